@@ -14,7 +14,9 @@ our @EXPORT_OK = qw(Fastq2Fasta Fasta2Fastq SplitFastq SplitFasta LoadFasta Load
 sub Fastq2Fasta {
     my ($ifn, $ofn) = @_;
     
-    open IN, "<$ifn" || die "open $ifn: $!\n";
+    # gzip/BGZF compressed fastq is read through gzip
+    my $in = $ifn =~ /\.gz$/ ? "gzip -dc $ifn |" : "<$ifn";
+    open IN, $in || die "open $ifn: $!\n";
     open OUT, ">$ofn" || die "open $ofn: $!\n";
 
     while (<IN>) {
@@ -60,25 +62,27 @@ sub Fasta2Fastq {
 sub SplitFastq {
     my ($fn, $n) = @_;
 
-    # set prefix
+    # set prefix (compressed input gives compressed splits)
     my $bn = `basename $fn`;          
     my ($pre) = $bn =~ /(.+)\.f(ast)*q/;
+    my $gz = $fn =~ /\.gz$/ ? ".gz" : "";
+    my $out = $gz ? "| gzip -1 >" : ">";
 
     # link file if no need to split
     if( $n == 1 ) {
-	`ln -s $fn $pre.1.fq`;
+	`ln -s $fn $pre.1.fq$gz`;
 	return;
     }
 
     # get number of sequences per split file
-    my $nos = `wc -l $fn`;
+    my $nos = $gz ? `gzip -dc $fn | wc -l` : `wc -l $fn`;
     ($nos) = $nos =~ /^(\d+)/; $nos /= 4;
 
     # when too few reads
     if ($nos < $n) {
-	`cp $fn $pre.1.fq`;
+	`cp $fn $pre.1.fq$gz`;
 	foreach my $i (2..$n) {
-	    `echo -n > $pre.$i.fq`;
+	    `echo -n > $pre.$i.fq$gz`;
 	}
 	return;
     }
@@ -87,10 +91,11 @@ sub SplitFastq {
     
     # load sequences and output
     my $k = 1;
-    open OUT, ">$pre.$k.fq" || die "open $pre.$k.fq: $!\n";
+    open OUT, "$out $pre.$k.fq$gz" || die "open $pre.$k.fq$gz: $!\n";
     
     my $i = 0;
-    open IN, "<$fn" || die "open $fn: $!\n";
+    my $in = $gz ? "gzip -dc $fn |" : "<$fn";
+    open IN, $in || die "open $fn: $!\n";
     while (<IN>) {
 	$i++;
 	if ($i > $nos) {
@@ -100,7 +105,7 @@ sub SplitFastq {
 	    }
 	    close OUT;
 	    $k++;
-	    open OUT, ">$pre.$k.fq" || die "open $pre.$k.fq: $!\n";
+	    open OUT, "$out $pre.$k.fq$gz" || die "open $pre.$k.fq$gz: $!\n";
 	    $i = 1;
 	}
 	print OUT $_;
@@ -24,10 +24,21 @@ sub check_command {
 	}
 }
 
-check_command ('usearch');
 check_command ('nucmer');
 
 
+############################## prefilter reads ##############################
+# keep only the reads sharing a minmatch-mer with the reference for nucmer
+# (the input is kept as *.all.fa); ProcessAlignment reads the whole fastq,
+# so rejected reads are still output as "---"
+sub prefilter {
+    my ($ref, $fa, $minmatch) = @_;
+    my ($pre) = $fa =~ /(.+)\.fa$/;
+    rename($fa, "$pre.all.fa");
+    `trig-prefilter -m $minmatch $ref $pre.all.fa > $fa 2> $pre.prefilter.log`;
+}
+
+
 ############################## set parameters ##############################
 
 # minmatch : minimal match for nucmer alignment
@@ -64,8 +75,8 @@ Usage(), exit 0 if $help;
 
 ##### confirm input and output
 
-# single-end reads can be either fasta or fastq
-die "input file error!\n" if !-e $ARGV[0] || $ARGV[0] !~ /[qa]$/;
+# single-end reads can be either fasta or fastq (plain or gzip/BGZF compressed)
+die "input file error!\n" if !-e $ARGV[0] || $ARGV[0] !~ /(q|q\.gz|a)$/;
 
 # paired-end fastq
 my $peq = $ARGV[1] ? 1 : 0;
@@ -149,19 +160,23 @@ print LOG "program start     : $date";
 # link reference data
 if (@gene == 1) {
     `ln -s $trigdir/gene/$sg.$_` for ("fa", "vdj", "cdr");
-    if ($patchq) {
-	`ln -s $trigdir/gene/$sg\_$_.fa` for ("j", "c");
-    }
+    `ln -s $trigdir/gene/$sg\_rss.txt` if -e "$trigdir/gene/$sg\_rss.txt";
 } else {
     foreach my $ext ("fa", "vdj", "cdr") {
 	my $command = "cat " . join(" ", map("$trigdir/gene/$species\_$_.$ext", @gene)) . " > $sg.$ext";
 	`$command`;
     }
-    if ($patchq) {
-	foreach my $g (@gene) {
-	    `ln -s $trigdir/gene/$species\_$g\_$_.fa` for ("j", "c");
-	}
-    }
+}
+
+# missing J or C alignments patched by ProcessAlignment (the Js and Cs of the vdj file)
+my $patch = $patchq ? "-p" : "";
+
+# reference bundle mapped by all ProcessAlignment processes (prebuilt in gene/ by "make index"
+# unless stale, i.e., a gene file changed since)
+if (@gene == 1 && system("trig-index -c $trigdir/gene/$sg 2> /dev/null") == 0) {
+    `ln -s $trigdir/gene/$sg.trig`;
+} else {
+    `trig-index $sg`;
 }
 
 # default data type
@@ -170,18 +185,19 @@ my $ext = "fq";
 # if single-end
 if (!$peq) {
 
-    # link input sequence
+    # link input sequence (compressed fastq is read in place by ProcessAlignment)
     $ext = "fa" if $fn =~ /a$/;
+    $ext = "fq.gz" if $fn =~ /\.gz$/;
     `ln -s $fd/$fn read.$ext`;
 
     # convert into fasta for nucmer and split
-    if ($ext eq "fq") {
-	Fastq2Fasta("read.fq", "read.fa");
-    } else {
+    if ($ext eq "fa") {
 	Fasta2Fastq("read.fa", "read.fq");
+    } else {
+	Fastq2Fasta("read.$ext", "read.fa");
     }
     SplitFasta("read.fa", $thread);
-    SplitFastq("read.fq", $thread);
+    SplitFastq($ext eq "fa" ? "read.fq" : "read.$ext", $thread);
     
 
 # if paired-end
@@ -191,23 +207,21 @@ if (!$peq) {
     `ln -s $fd/$fn read_1.fq`;
     `ln -s $f2d/$f2n read_2.fq`;
 
-    # merge paired-end reads
+    # merge paired-end reads, writing the fasta files in the same pass
     if ($mergeq) {
-        my $cmd = "usearch -fastq_mergepairs read_1.fq -reverse read_2.fq";
-        $cmd .= " -threads $thread -fastq_minovlen 20 -fastq_minmergelen 30 -fastq_pctid 90 -fastq_maxdiffs 10 -fastq_trunctail 0";
-        #$cmd .= " -threads $thread -fastq_minovlen 10 -fastq_pctid 75 -fastq_maxdiffs 75 -fastq_trunctail 0";
-        $cmd .= " -fastqout read.fq -fastqout_notmerged_fwd um1_read.fq -fastqout_notmerged_rev um2_read.fq"; 
-        $cmd .= " 2> usearch_fastqmergepairs.log";
+        my $cmd = "trig-merge -t $thread -f -l 20 -L 30 -p 90 -d 10";
+        #$cmd = "trig-merge -t $thread -f -l 10 -p 75 -d 75";
+        $cmd .= " read_1.fq read_2.fq read.fq um1_read.fq um2_read.fq";
+        $cmd .= " 2> trig_merge.log";
         `$cmd`;
     } else {
         `ln -s read_1.fq um1_read.fq`;
         `ln -s read_2.fq um2_read.fq`;
+        Fastq2Fasta("um1_read.fq", "um1_read.fa");
+        Fastq2Fasta("um2_read.fq", "um2_read.fa");
     }
 
-    # convert fastq into fasta then split file
-    Fastq2Fasta("read.fq", "read.fa") if $mergeq;
-    Fastq2Fasta("um1_read.fq", "um1_read.fa");
-    Fastq2Fasta("um2_read.fq", "um2_read.fa");
+    # split file
     SplitFastq("read.fq", $thread) if $mergeq;
     SplitFastq("um1_read.fq", $thread);
     SplitFastq("um2_read.fq", $thread);
@@ -235,6 +249,7 @@ for (my $i = 1; $i <= $thread; $i++) {
         if ($peq == 0 || $mergeq) {
 
             # run nucmer while taking care of null file
+            prefilter("$sg.fa", "read.$i.fa", $minmatch) if -s "read.$i.fa";
             if (-s "read.$i.fa") {
                 `nucmer --maxmatch -l $minmatch -c $minmatch -b $minmatch -p initial.$i $sg.fa read.$i.fa 2> /dev/null`;
             } else {
@@ -245,42 +260,25 @@ for (my $i = 1; $i <= $thread; $i++) {
             }
             
             # run TRIg kernel
-            if ($patchq) {
-                `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o processed.$i initial.$i.delta`;
-                `PatchAlignment.pl -s $species -g $gene -m $minmatch processed.$i.vdjdelta read.$i.fa`;
-                `mv processed.$i.vdjdelta.1 read.$i.vdjdelta`;
-                `mv processed.$i.cdr3.1 read.$i.cdr3`;
-            } else {
-                `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o read.$i initial.$i.delta`;
-            }
+            `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -L $patch -o read.$i initial.$i.delta`;
         }
 	
 	# analyze un-merged paired-end reads
 	if ($peq) {
-	    if (-s "um1_read.$i.fa") {
-		`nucmer --maxmatch -l $minmatch -c $minmatch -b $minmatch -p um1_initial.$i $sg.fa um1_read.$i.fa 2> /dev/null`;
-		`nucmer --maxmatch -l $minmatch -c $minmatch -b $minmatch -p um2_initial.$i $sg.fa um2_read.$i.fa 2> /dev/null`;
-	    } else {
-		my $command = "echo \"$sg.fa um1_read.$i.fa\" > um1_initial.$i.delta"; `$command`;
-		$command = "echo \"NUCMER\" >> um1_initial.$i.delta"; `$command`;
-		$command = "echo \"$sg.fa um2_read.$i.fa\" > um2_initial.$i.delta"; `$command`;
-		$command = "echo \"NUCMER\" >> um2_initial.$i.delta"; `$command`;
-	    }
-	    if($patchq) {
-		`ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o um1_processed.$i um1_initial.$i.delta`;
-		`PatchAlignment.pl -s $species -g $gene -m $minmatch um1_processed.$i.vdjdelta um1_read.$i.fa`;
-                `mv um1_processed.$i.vdjdelta.1 um1_read.$i.vdjdelta`;
-                `mv um1_processed.$i.cdr3.1 um1_read.$i.cdr3`;
-                `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o um2_processed.$i um2_initial.$i.delta`;
-		`PatchAlignment.pl -s $species -g $gene -m $minmatch um2_processed.$i.vdjdelta um2_read.$i.fa`;
-                `mv um2_processed.$i.vdjdelta.1 um2_read.$i.vdjdelta`;
-                `mv um2_processed.$i.cdr3.1 um2_read.$i.cdr3`;
-	    } else {
-		`ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o um1_read.$i um1_initial.$i.delta`;
-                `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -o um2_read.$i um2_initial.$i.delta`;
+
+	    # run nucmer on each mate while taking care of null file (e.g., all reads of a mate
+	    # rejected by the prefilter)
+	    foreach my $m (1, 2) {
+		prefilter("$sg.fa", "um$m\_read.$i.fa", $minmatch) if -s "um$m\_read.$i.fa";
+		if (-s "um$m\_read.$i.fa") {
+		    `nucmer --maxmatch -l $minmatch -c $minmatch -b $minmatch -p um$m\_initial.$i $sg.fa um$m\_read.$i.fa 2> /dev/null`;
+		} else {
+		    my $command = "echo \"$sg.fa um$m\_read.$i.fa\" > um$m\_initial.$i.delta"; `$command`;
+		    $command = "echo \"NUCMER\" >> um$m\_initial.$i.delta"; `$command`;
+		}
 	    }
-	    `CombinePEVDJDelta.pl um1_read.$i.vdjdelta um2_read.$i.vdjdelta > um_read.$i.vdjdelta`;
-            `CombinePECDR3.pl um1_read.$i.cdr3 um2_read.$i.cdr3 > um_read.$i.cdr3`;
+	    # both mates in one pass, combined as by CombinePEVDJDelta.pl and CombinePECDR3.pl
+	    `ProcessAlignment -s $species -g $gene -m $minmatch -a $adjolq -f $frac -L $patch -o um_read.$i -P um1_initial.$i.delta um2_initial.$i.delta`;
 	    #`CombinePEFastq4CDR3.pl um_read.$i.vdjdelta um1_read.$i.fq um2_read.$i.fq > um_read.$i.fq`;
 	    #`ExtractCDR3.pl -s $species -g $gene um_read.$i.vdjdelta um_read.$i.fq > um_read.$i.cdr3`;
 	}
@@ -308,6 +306,11 @@ if ($peq == 0 || $mergeq) {
     $command = "cat " . join(" ", map("read.$_.cdr3", (1..$thread))) . " > read.cdr3";
     `$command`;
     `rm read.*.cdr3`;
+
+    # recombination categories (ProcessAlignment -L)
+    $command = "cat " . join(" ", map("read.$_.lab", (1..$thread))) . " > read.lab";
+    `$command`;
+    `rm read.*.lab`;
 }
 
 if ($peq) {
@@ -318,6 +321,10 @@ if ($peq) {
     $command = "cat " . join(" ", map("um_read.$_.cdr3", (1..$thread))) . " > unmerged.cdr3";
     `$command`;
     `rm um*_read.*.cdr3`;
+
+    $command = "cat " . join(" ", map("um_read.$_.lab", (1..$thread))) . " > unmerged.lab";
+    `$command`;
+    `rm um_read.*.lab`;
     
 	# unified field (same as unmerged)
 	open IN, "read.vdjdelta";
@@ -329,15 +336,18 @@ if ($peq) {
 	close IN;
 	close OUT;
 	unlink("read.vdjdelta");
+	UnifyLabel("read.lab", "merged.lab");
 
 	#`mv read.vdjdelta merged.vdjdelta`;
     `mv read.cdr3 merged.cdr3`;
     if ($mergeq) {
         `cat merged.vdjdelta unmerged.vdjdelta > read.vdjdelta`;
         `cat merged.cdr3 unmerged.cdr3 > read.cdr3`;
+        `cat merged.lab unmerged.lab > read.lab`;
     } else {
         `ln -s unmerged.vdjdelta read.vdjdelta`;
         `ln -s unmerged.cdr3 read.cdr3`;
+        `ln -s unmerged.lab read.lab`;
     }
 } else {
 	open IN, "read.vdjdelta";
@@ -350,23 +360,33 @@ if ($peq) {
 	close OUT;
 	unlink("read.vdjdelta");
 	rename("merged.vdjdelta", "read.vdjdelta");
+	UnifyLabel("read.lab", "merged.lab");
+	rename("merged.lab", "read.lab");
+}
+
+# reads kept and rejected by the prefilter of each part (and mate)
+my ($kept, $rejected) = (0, 0);
+foreach my $log (glob("*read.*.prefilter.log")) {
+    open IN, $log;
+    while (<IN>) {
+	$kept += $1 if /^reads kept\s*:\s*(\d+)/;
+	$rejected += $1 if /^reads rejected\s*:\s*(\d+)/;
+    }
+    close IN;
+    unlink($log);
 }
 
 `rm *read.*.fa`;
-`rm *read.*.fq`;
+`rm -f *read.*.fq *read.*.fq.gz`;
 `rm *initial.*.delta`;
-`rm *processed.*.vdjdelta*` if $patchq == 1;
-
-$command = "CorrectCDR3Error.pl read.cdr3 > clone.txt";
-`$command`;
 
-$command = "CloneStat.pl clone.txt";
+# clones and their statistics (clone.vnpc, etc. as CloneStat.pl) in one pass
+$command = "trig-clone -t $thread -s $species -g $gene -S clone read.cdr3 > clone.txt";
 `$command`;
 
-$command = "LabelRecombination.pl read.vdjdelta > read.lab";
-`$command` if $gene eq "trb";
-
 # finish log
+print LOG "prefilter kept    : $kept\n";
+print LOG "prefilter rejected: $rejected\n";
 $date = `date`;
 print LOG "program end       : $date";
 
@@ -376,6 +396,20 @@ chdir("..");
 
 ################################################################################
 
+# unified field of .lab (mate 0 after the read ID, as in .vdjdelta)
+sub UnifyLabel {
+    my ($in, $out) = @_;
+    open IN, $in;
+    open OUT, ">$out";
+    while (<IN>) {
+        my @F = split "\t";
+        print OUT join "\t", @F[0..3], 0, @F[4..$#F];
+    }
+    close IN;
+    close OUT;
+    unlink($in);
+}
+
 
 sub Usage {
     print "usage  : trig.pl [options] R1.fq R2.fq\n";
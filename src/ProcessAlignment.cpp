@@ -3,25 +3,63 @@
 #include <getopt.h>
 #include <vector>
 #include <unordered_map>
+#include <sstream>
 #include "delta.hpp"
 #include "fastx_read.hpp"
 #include "extractCDR3.hpp"
 #include "vdjreader.hpp"
+#include "querypool.hpp"
+#include "mapfile.hpp"
+#include "arena.hpp"
+#include "seedalign.hpp"
+#include "bundle.hpp"
+#include "pairend.hpp"
+#include "patch.hpp"
+#include "vdjcol.hpp"
 
 using namespace std;
 
 //====================================================Options===
 string    OPT_Delta_file;
+string    OPT_Delta_file2;   // of read 2 in paired mode
 string    OPT_Species    = "hsa";
 string    OPT_Gene       = "trb";
 int       OPT_Minmatch   = 15;
 int       OPT_Adjolq     = 1;
 float     OPT_Frac       = 0.5;
 string    OPT_Output     = "read";
+int       OPT_Threads    = 1;
+int       OPT_Index      = 0;
+int       OPT_Align      = 0;
+int       OPT_Paired     = 0;
+int       OPT_Label      = 0;
+int       OPT_Patch      = 0;
+int       OPT_Binary     = 0;
+
+const size_t BATCH_SIZE  = 64;   // queries per batch handed to a worker
+
+// index of the references for --align
+SeedAligner_t SeedIndex;
+
+// reference bundle from trig-index, mapped while the references are in use
+RefBundle_t Bundle;
+
+// recombination categories for --label
+RecombLabeler_t Labeler;
+
+// J and C panels for --patch
+AlignPatcher_t Patcher;
 
 //===================================================Function===
 void ParseArgs(int argc, char ** argv);
 void help();
+void ProcessBatch(QueryBatch_t &batch);
+void ProcessPairBatch(QueryBatch_t &batch);
+void ProcessQuery(QueryJob_t &job, Arena_t &arena, ostream &OUT_V, ostream &OUT_C, ostream &OUT_L,
+		MateResult_t *mate = nullptr);
+void AlignReads(const string &qrypath, const string &qrypath2, ostream &OUT_V, ostream &OUT_C, ostream *OUT_L);
+void ProcessPairs(const string &deltapath1, const string &deltapath2, ostream &OUT_V, ostream &OUT_C, ostream *OUT_L);
+void LoadReference(const string &refpath, const string &vdjpath, const string &cdr3path);
 
 //=======================================================Main===
 int main(int argc, char **argv) {
@@ -33,113 +71,406 @@ int main(int argc, char **argv) {
 	const string cdr3path = OPT_Species + "_"  + OPT_Gene + ".cdr";
 	const string vdjdeltaout = OPT_Output + ".vdjdelta";
 	const string cdr3out = OPT_Output + ".cdr3";
+	const string labout = OPT_Output + ".lab";
 	
-	// output file stream
-	ofstream OUT_V;
-	ofstream OUT_C;
-	OUT_V.open(vdjdeltaout);
-	OUT_C.open(cdr3out);
-
-	// open MUMmer delta file
-	DeltaReader_t dr;
-	dr.open(deltapath);
+	// output file stream (.vdjdelta.col and .cdr3.col in place of .vdjdelta and .cdr3 if binary)
+	ofstream TXT_V;
+	ofstream TXT_C;
+	ofstream OUT_L;
+	ColOutStream_t COL_V;
+	ColOutStream_t COL_C;
+	if (OPT_Binary) {
+		COL_V.open(vdjdeltaout + ".col");
+		COL_C.open(cdr3out + ".col");
+	} else {
+		TXT_V.open(vdjdeltaout);
+		TXT_C.open(cdr3out);
+	}
+	if (OPT_Label)
+		OUT_L.open(labout);
+	ostream &OUT_V = OPT_Binary ? (ostream &)COL_V : TXT_V;
+	ostream &OUT_C = OPT_Binary ? (ostream &)COL_C : TXT_C;
+	ostream *out_l = OPT_Label ? &OUT_L : nullptr;
+	auto closeOutput = [&]() {
+		TXT_V.close();
+		TXT_C.close();
+		COL_V.close();
+		COL_C.close();
+		OUT_L.close();
+	};
+
+	// align reads (fasta or fastq) in place of a delta file
+	if (OPT_Align) {
+		AlignReads(OPT_Delta_file, OPT_Delta_file2, OUT_V, OUT_C, out_l);
+		closeOutput();
+		return 0;
+	}
+
+	// both mates of unmerged pairs, combined as by CombinePEVDJDelta.pl and CombinePECDR3.pl
+	if (OPT_Paired) {
+		ProcessPairs(OPT_Delta_file, OPT_Delta_file2, OUT_V, OUT_C, out_l);
+		closeOutput();
+		return 0;
+	}
+
+	// map MUMmer delta file, or stream it from stdin ("-") or a named pipe
+	const bool mapq = deltapath != "-" && isRegularFile(deltapath);
+	DeltaMapReader_t dmr;
+	DeltaReader_t dsr;
+	if (mapq) {
+		dmr.open(deltapath);
+	} else {
+		ios::sync_with_stdio(false);
+		dsr.open(deltapath);
+	}
+	auto readNextQuery = [&](DeltaRecord_t &query) {
+		return mapq ? dmr.readNextQuery(query) : dsr.readNextQuery(query);
+	};
 	
 	// load delta header
-	const string refpath = dr.getReferencePath();
-	const string qrypath_fa = dr.getQueryPath();
-	const string qrypath_fq = qrypath_fa.substr(0, qrypath_fa.length()-2) + "fq";
+	const string refpath = mapq ? dmr.getReferencePath() : dsr.getReferencePath();
+	const string qrypath_fa = mapq ? dmr.getQueryPath() : dsr.getQueryPath();
+	string qrypath_fq = qrypath_fa.substr(0, qrypath_fa.length()-2) + "fq";
+	if (!isRegularFile(qrypath_fq) && isRegularFile(qrypath_fq + ".gz"))
+		qrypath_fq += ".gz";
+	GzInStream_t::threads = OPT_Threads;
 
-	// load reference, query sequence and vdj info to static object in deltafilter_t;
-	DeltaFilter_t::refseq_m = FASTA_t::getfasta(refpath);
-	VDJReader_t vr;
-	DeltaFilter_t::VDJInfo_m = vr.getallVDJInfo(vdjpath);
+	// load reference and vdj info to static objects in deltafilter_t
+	LoadReference(refpath, vdjpath, cdr3path);
 
-	// load cdr3 info to static object
-	CDRReader_t cr;
-	ExtractCDR3_t::cdr3p_m = cr.getCDR3(cdr3path);
-
-	// load fastq file using FastqReader_t
+	// load fastq file using FastqReader_t, or index it to fetch reads by ID
 	FastqReader_t fr;
-	fr.open(qrypath_fq);
-
-	// read each delta record
-	while(dr.readNext(true)) {
-		DeltaRecord_t R1 = dr.getRecord();
-
-		// readNext until different qry
-		while(dr.readNext(true)) {
-			DeltaRecord_t R2 = dr.getRecord();
-			if (R1.idQ == R2.idQ) {
-				// merge records (records as same query and different reference)
-				R1.combine_rec(R2);
-			} else {
-				// seek and break
-				dr.seek_previous_record();
-				break;
-			}
+	FastqIndex_t fi;
+	if (OPT_Index)
+		fi.open(qrypath_fq);
+	else
+		fr.open(qrypath_fq);
+
+	// process queries in batches, output in input order
+	QueryPool_t pool(OPT_Threads, ProcessBatch, {&OUT_V, &OUT_C, out_l});
+	QueryBatch_t batch;
+
+	// read all delta records of each query
+	while(true) {
+		batch.jobs.emplace_back();
+		QueryJob_t &job = batch.jobs.back();
+		if (!readNextQuery(job.rec)) {
+			batch.jobs.pop_back();
+			break;
 		}
+		DeltaRecord_t &R1 = job.rec;
 
-		// filter process
-		DeltaFilter_t df(R1);
+		// fetch query fastq sequence by ID
+		if (OPT_Index) {
+			job.found = fi.fetch(R1.idQ, job.seq, job.qua);
+			if (!job.found) {
+				cerr << "\033[31mERROR:\033[0m Query not found in fastq file, " << R1.idQ << endl;
+				exit(1);
+			}
+			job.uid = R1.idQ;
+			if (batch.jobs.size() == BATCH_SIZE)
+				pool.push(batch);
+			continue;
+		}
 
-		// load query fasta sequence
+		// load query fastq sequence (in the same order as the delta)
 		while(fr.readNext()) {
-			const string uid = fr.getUID();
-			const string seq = fr.getSEQ();
+			const string &uid = fr.getUID();
 			if (R1.idQ == uid) {
-				df.qryseq_m = seq;
+				job.found = true;
 				break;
-			// query fasta sequence without delta information
+			// query fastq sequence without delta information
 			} else {
-				OUT_V << uid << "\t" << seq.length() << "\t" << "---" << endl;
-				OUT_C << uid << "\t" << "---" << "\t" << "---" << endl;
+				job.skip_v += uid + "\t" + to_string(fr.getSEQ().length()) + "\t" + "---" + "\n";
+				job.skip_c += uid + "\t" + "---" + "\t" + "---" + "\n";
+			}
+		}
+		job.uid = fr.getUID();
+		job.seq = fr.getSEQ();
+		job.qua = fr.getQUA();
+
+		if (batch.jobs.size() == BATCH_SIZE)
+			pool.push(batch);
+	}
+	if (!batch.jobs.empty())
+		pool.push(batch);
+	pool.finish();
+
+	// else fasta without delta information (all at the end if indexed)
+	if (OPT_Index) {
+		string uid, seq, qua;
+		for (size_t i = 0; i < fi.size(); i++) {
+			if (fi.isFetched(i))
+				continue;
+			fi.getEntry(i, uid, seq, qua);
+			OUT_V << uid << "\t" << seq.length() << "\t" << "---" << "\n";
+			OUT_C << uid << "\t---\t---" << "\n";
+		}
+	}
+	while(!OPT_Index && fr.readNext()) {
+		OUT_V << fr.getUID() << "\t" << fr.getSEQ().length() << "\t" << "---" << endl;
+		OUT_C << fr.getUID() << "\t---\t---" << endl;
+	}
+
+	closeOutput();
+	return 0;
+	}
+
+	//=================================================AlignReads===
+	void AlignReads(const string &qrypath, const string &qrypath2, ostream &OUT_V, ostream &OUT_C, ostream *OUT_L) {
+		const string refpath = OPT_Species + "_"  + OPT_Gene + ".fa";
+		const string vdjpath = OPT_Species + "_"  + OPT_Gene + ".vdj";
+		const string cdr3path = OPT_Species + "_"  + OPT_Gene + ".cdr";
+		GzInStream_t::threads = OPT_Threads;
+
+		// reference index for the workers, and as for a delta file
+		SeedIndex.build(refpath, OPT_Minmatch);
+		LoadReference(refpath, vdjpath, cdr3path);
+
+		// reads in fasta (quality 'I', as in Fasta2Fastq) or fastq, by extension as in trig.pl
+		const string path[2] = {qrypath, qrypath2};
+		const int nmate = OPT_Paired ? 2 : 1;
+		bool fastaq[2];
+		FastaReader_t far[2];
+		FastqReader_t fqr[2];
+		for (int k = 0; k < nmate; k++) {
+			string base = path[k];
+			if (base.size() > 3 && base.compare(base.size()-3, 3, ".gz") == 0)
+				base.resize(base.size()-3);
+			fastaq[k] = !base.empty() && base.back() == 'a';
+			if (fastaq[k])
+				far[k].open(path[k]);
+			else
+				fqr[k].open(path[k]);
+		}
+		auto readNext = [&](const int k, QueryJob_t &job) {
+			if (!(fastaq[k] ? far[k].readNext() : fqr[k].readNext()))
+				return false;
+			job.found = true;
+			job.uid = fastaq[k] ? far[k].getUID() : fqr[k].getUID();
+			job.seq = fastaq[k] ? far[k].getSEQ() : fqr[k].getSEQ();
+			job.qua = fastaq[k] ? string(job.seq.size(), 'I') : fqr[k].getQUA();
+			job.rec.idQ = job.uid;
+			job.rec.lenQ = job.seq.size();
+			return true;
+		};
+
+		// each read (or pair) is aligned by the worker processing it
+		QueryPool_t pool(OPT_Threads, OPT_Paired ? ProcessPairBatch : ProcessBatch, {&OUT_V, &OUT_C, OUT_L});
+		QueryBatch_t batch;
+		while (true) {
+			batch.jobs.emplace_back();
+			if (!readNext(0, batch.jobs.back())) {
+				batch.jobs.pop_back();
+				break;
+			}
+			if (OPT_Paired) {
+				batch.jobs.emplace_back();
+				if (!readNext(1, batch.jobs.back())) {
+					cerr << "\033[31mERROR:\033[0m Inconsistent paired reads, " << path[1]
+						<< " ends before " << path[0] << endl;
+					exit(1);
+				}
+			}
+			if (batch.jobs.size() >= BATCH_SIZE)
+				pool.push(batch);
+		}
+		if (!batch.jobs.empty())
+			pool.push(batch);
+		pool.finish();
+	}
+
+	//===============================================ProcessPairs===
+	void ProcessPairs(const string &deltapath1, const string &deltapath2, ostream &OUT_V, ostream &OUT_C, ostream *OUT_L) {
+		MateReader_t mr[2];
+		mr[0].open(deltapath1);
+		mr[1].open(deltapath2);
+		GzInStream_t::threads = OPT_Threads;
+
+		const string vdjpath = OPT_Species + "_"  + OPT_Gene + ".vdj";
+		const string cdr3path = OPT_Species + "_"  + OPT_Gene + ".cdr";
+		LoadReference(mr[0].getReferencePath(), vdjpath, cdr3path);
+
+		// both mates of each pair in a batch, one after the other
+		QueryPool_t pool(OPT_Threads, ProcessPairBatch, {&OUT_V, &OUT_C, OUT_L});
+		QueryBatch_t batch;
+		while (true) {
+			batch.jobs.emplace_back();
+			batch.jobs.emplace_back();
+			QueryJob_t &job1 = batch.jobs[batch.jobs.size()-2];
+			QueryJob_t &job2 = batch.jobs.back();
+			const bool more1 = mr[0].next(job1), more2 = mr[1].next(job2);
+			if (more1 != more2) {
+				cerr << "\033[31mERROR:\033[0m Inconsistent paired reads, fastq of "
+					<< (more1 ? deltapath2 : deltapath1) << " ends first" << endl;
+				exit(1);
+			}
+			if (!more1) {
+				batch.jobs.resize(batch.jobs.size()-2);
+				break;
 			}
+			if (batch.jobs.size() >= BATCH_SIZE)
+				pool.push(batch);
+		}
+		if (!batch.jobs.empty())
+			pool.push(batch);
+		pool.finish();
+	}
+
+	//==============================================LoadReference===
+	void LoadReference(const string &refpath, const string &vdjpath, const string &cdr3path) {
+
+		// map the bundle next to the reference (e.g., hsa_trb.trig for hsa_trb.fa) if any and not stale
+		string prefix = refpath;
+		if (prefix.size() > 3 && prefix.compare(prefix.size()-3, 3, ".fa") == 0)
+			prefix.resize(prefix.size()-3);
+		if (!Bundle.open(prefix, DeltaFilter_t::refseq_m, DeltaFilter_t::symbols_m)) {
+
+			// else load the reference sequence, and the vdj and cdr3 info into the symbol table
+			DeltaFilter_t::refseq_m.load(refpath);
+			VDJReader_t vr;
+			CDRReader_t cr;
+			DeltaFilter_t::symbols_m.build(vr.getallVDJInfo(vdjpath), cr.getCDR3(cdr3path));
+		}
+
+		// genes of the symbol table, and RSS23 positions (e.g., hsa_trb_rss.txt) if any
+		if (OPT_Label)
+			Labeler.load(DeltaFilter_t::symbols_m, OPT_Species + "_"  + OPT_Gene + "_rss.txt");
+
+		// Js and first C exons of the symbol table
+		if (OPT_Patch)
+			Patcher.load(DeltaFilter_t::symbols_m, DeltaFilter_t::refseq_m, OPT_Minmatch);
+	}
+
+	//===============================================ProcessBatch===
+	void ProcessBatch(QueryBatch_t &batch) {
+		// per-query objects of a worker, released after each query is written
+		static thread_local Arena_t arena;
+
+		ostringstream OUT_V;
+		ostringstream OUT_C;
+		ostringstream OUT_L;
+		for (auto &job : batch.jobs) {
+			ProcessQuery(job, arena, OUT_V, OUT_C, OUT_L);
+			arena.reset();
+		}
+		batch.out = {OUT_V.str(), OUT_C.str(), OUT_L.str()};
+	}
+
+	//===========================================ProcessPairBatch===
+	void ProcessPairBatch(QueryBatch_t &batch) {
+		static thread_local Arena_t arena;
+
+		ostringstream OUT_V;
+		ostringstream OUT_C;
+		ostringstream OUT_L;
+		ostringstream none, C1, C2;
+		MateResult_t m1, m2;
+		for (size_t i = 0; i + 1 < batch.jobs.size(); i += 2) {
+			ProcessQuery(batch.jobs[i], arena, none, C1, none, &m1);
+			arena.reset();
+			ProcessQuery(batch.jobs[i+1], arena, none, C2, none, &m2);
+			arena.reset();
+			if (m1.f[0] != m2.f[0]) {
+				cerr << "\033[31mERROR:\033[0m Inconsistent paired reads, " << m1.f[0] << " " << m2.f[0] << endl;
+				exit(1);
+			}
+			PAIR_t::combineVDJ(m1, m2, OUT_V);
+			if (OPT_Label)
+				PAIR_t::labelVDJ(m1, m2, Labeler, OUT_L);
+			PAIR_t::combineCDR3(C1.str(), C2.str(), OUT_C);
+			C1.str("");
+			C2.str("");
+		}
+		batch.out = {OUT_V.str(), OUT_C.str(), OUT_L.str()};
+	}
+
+	//===============================================ProcessQuery===
+	// a mate of a pair is kept in mate in place of its .vdjdelta line
+	void ProcessQuery(QueryJob_t &job, Arena_t &arena, ostream &OUT_V, ostream &OUT_C, ostream &OUT_L,
+			MateResult_t *mate) {
+		DeltaRecord_t &R1 = job.rec;
+
+		// fastq entries skipped before the query
+		OUT_V << job.skip_v;
+		OUT_C << job.skip_c;
+
+		// a read without alignments is output as if absent from the delta
+		if (OPT_Align)
+			SeedIndex.align(job.seq, R1, &arena);
+		if (R1.aligns.empty() && (OPT_Align || mate)) {
+			if (mate)
+				mate->none(job.uid, job.seq.length());
+			else
+				OUT_V << job.uid << "\t" << job.seq.length() << "\t" << "---" << "\n";
+			OUT_C << job.uid << "\t---\t---" << "\n";
+			return;
 		}
 
-		df.getOptimalSet();
-		df.annotateVDJ();
-		df.groupAlignment();
-		df.filterAlignment();
-		df.setRecombCode();
-		if (OPT_Adjolq && df.rc_m != "CH")
-			df.adjustOverlap();
-		df.annotateQuery();
+		// filter process
+		DeltaFilter_t df(R1, &arena);
+		if (job.found)
+			df.qryseq_m = job.seq;
+
+		auto filter = [&]() {
+			df.getOptimalSet();
+			df.annotateVDJ();
+			df.groupAlignment();
+			df.filterAlignment();
+			df.setRecombCode();
+			if (OPT_Adjolq && df.rc_m != "CH")
+				df.adjustOverlap();
+			df.annotateQuery();
+		};
+		filter();
+
+		// a missing J or C aligned to the panels and filtered again (a J, then its C)
+		for (int k = 0; k < 2 && OPT_Patch && Patcher.patch(df, R1, &arena); k++) {
+			df.load(R1);
+			filter();
+		}
 
 		//if (df.alf_m >= OPT_Frac) 
-		if (df.al_m >= 30) {
+		if (mate && df.al_m >= 30) {
+			mate->load(df, OPT_Label);
+		} else if (mate) {
+			mate->none(R1.idQ, R1.lenQ);
+		} else if (df.al_m >= 30) {
 			//df.printResult(OUT_V);
-			OUT_V << df << endl;
+			OUT_V << df << "\n";
+
+			// recombination category, then the .vdjdelta fields with the corrected alignments
+			if (OPT_Label) {
+				LabelSet_t ls;
+				RecombLabel_t lab;
+				df.getLabelSet(ls);
+				Labeler.label(ls, df.getREG(), lab);
+				OUT_L << lab.cat << "\t" << lab.genes << "\t" << lab.junction << "\t"
+					<< R1.idQ << "\t" << R1.lenQ << "\t" << df.getREG() << "\t" << df.getREC().idR << "\t"
+					<< df.getORI() << "\t" << df.getVDJ() << "\t" << lab.aln << "\t"
+					<< df.getVi() << "," << df.getDi() << "," << df.getJi() << "\t" << df.al_m << "\n";
+			}
 		} else {
-			OUT_V << R1.idQ << "\t" << R1.lenQ << "\t" << "---" << endl;
+			OUT_V << R1.idQ << "\t" << R1.lenQ << "\t" << "---" << "\n";
 		}
 
 		// CDR3
 		if (df.getREG() == 1 || df.getREG() == 2) {
-			ExtractCDR3_t excdr(df.getREC(), df.getREG(), df.getORI(), df.getVDJ(), df.getVi(), df.getJi());
-			excdr.inputFastq(fr.getSEQ(), fr.getQUA());
+			ExtractCDR3_t excdr(df.getREC(), df.getTAB(), df.getREG(), df.getORI(),
+					df.getALN()[df.getVi()], df.getALN()[df.getJi()], &arena);
+			excdr.inputFastq(job.seq, job.qua);
 			excdr.extractCDR3();
 			//excdr.printResult(OUT_C);
-			OUT_C << excdr << endl;
+			OUT_C << excdr << "\n";
 		} else {
-			OUT_C << fr.getUID() << "\t" << 0 << "\t" << "---" << endl;
+			OUT_C << job.uid << "\t" << 0 << "\t" << "---" << "\n";
 		}
 	}
 
-	// else fasta without delta information
-	while(fr.readNext()) {
-		OUT_V << fr.getUID() << "\t" << fr.getSEQ().length() << "\t" << "---" << endl;
-		OUT_C << fr.getUID() << "\t---\t---" << endl;
-	}
-
-	OUT_V.close();
-	OUT_C.close();
-	return 0;
-	}
-
 	//==================================================ParseArgs===
 	void ParseArgs(int argc, char ** argv) {
 		int opt, errflg = 0;
-		const char *optstring = "s:g:m:a:f:o:";
+		const char *optstring = "s:g:m:a:f:o:t:xAPLpb";
 		const struct option int_opts[] = {
 			{"species",  1, NULL, 's'},
 			{"gene",     1, NULL, 'g'},
@@ -147,6 +478,14 @@ int main(int argc, char **argv) {
 			{"adjolq",   1, NULL, 'a'},
 			{"frac",     1, NULL, 'f'},
 			{"output",   1, NULL, 'o'},
+			{"threads",  1, NULL, 't'},
+			{"index",    0, NULL, 'x'},
+			{"align",    0, NULL, 'A'},
+			{"paired",   0, NULL, 'P'},
+			{"label",    0, NULL, 'L'},
+			{"patch",    0, NULL, 'p'},
+			{"binary",   0, NULL, 'b'},
+			{NULL,       0, NULL, 0},
 		};
 
 		while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
@@ -168,23 +507,61 @@ int main(int argc, char **argv) {
 				case (int)'o':
 					OPT_Output = optarg;
 					break;
+				case (int)'t':
+					OPT_Threads = atoi(optarg);
+					break;
+				case (int)'x':
+					OPT_Index = 1;
+					break;
+				case (int)'A':
+					OPT_Align = 1;
+					break;
+				case (int)'P':
+					OPT_Paired = 1;
+					break;
+				case (int)'L':
+					OPT_Label = 1;
+					break;
+				case (int)'p':
+					OPT_Patch = 1;
+					break;
+				case (int)'b':
+					OPT_Binary = 1;
+					break;
 				default:
 					errflg++;
 			}
 		}
 
-		if (errflg > 0 || optind != argc -1) help();
+		if (errflg > 0 || optind != argc - 1 - OPT_Paired || (OPT_Paired && OPT_Index)) help();
 		OPT_Delta_file = argv[optind++];
+		if (OPT_Paired)
+			OPT_Delta_file2 = argv[optind++];
 	}
 
 	//=======================================================Help===
 	void help() {
-		cout << "usage  : ProcAlgn [option] initial.delta\n\n" <<
+		cout << "usage  : ProcAlgn [option] initial.delta   (\"-\" or a named pipe to stream the delta)\n" <<
+			"         ProcAlgn [option] -A read.fa/q     (align to species_gene.fa without nucmer)\n" <<
+			"         ProcAlgn [option] -P um1.delta um2.delta   (mates of unmerged pairs, combined)\n\n" <<
 			"option : -s | --species  species name              [hsa*, mmu] (*default)\n" <<
 			"         -g | --gene     immune receptor gene      [tra, trb*, trd, trg, igh, igl, igk]\n" <<
-			"         -m | --minmatch minimal match of nucmer   [15*]\n" <<
+			"         -m | --minmatch minimal match of nucmer   [15*] (and of -A)\n" <<
 			"         -a | --adjolq   adjust overlap Q          [0, 1*]\n" <<
 			"         -f | --frac     alignment length fraction [0.5*]\n" <<
-			"         -o | --output   output filenames prefix   [read*] (ext: .vdjdelta .cdr3)\n\n";
+			"         -o | --output   output filenames prefix   [read*] (ext: .vdjdelta .cdr3)\n" <<
+			"         -t | --threads  number of worker threads  [1*]\n" <<
+			"         -x | --index    fetch reads by ID from an indexed fastq (delta in any order,\n" <<
+			"                         reads without alignments are written at the end)\n" <<
+			"         -A | --align    align the reads with the built-in seed-and-extend aligner\n" <<
+			"                         (nucmer --maxmatch -l m -c m -b m), in place of a delta\n" <<
+			"         -P | --paired   both mates of unmerged pairs, written as by CombinePEVDJDelta.pl\n" <<
+			"                         and CombinePECDR3.pl (with -A, read 1 and read 2 fasta/q)\n" <<
+			"         -L | --label    recombination category of each aligned query (as by\n" <<
+			"                         LabelRecombination.pl) into .lab\n" <<
+			"         -p | --patch    align a missing J (or C) in the rest of a query to the Js (or Cs)\n" <<
+			"                         of species_gene.vdj, in place of PatchAlignment.pl\n" <<
+			"         -b | --binary   write .vdjdelta.col and .cdr3.col (columnar, block-compressed,\n" <<
+			"                         see trig-view) in place of .vdjdelta and .cdr3\n\n";
 		exit(0);
 	}
@@ -0,0 +1,215 @@
+#include "aligntable.hpp"
+#include "delta.hpp"
+#include "fastx_read.hpp"
+#include "score.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+
+void AlignTable_t::clear() {
+	sR.clear(); eR.clear();
+	sQ.clear(); eQ.clear();
+	mmgp.clear();
+	ro.clear(); go.clear();
+	osQ.clear(); oeQ.clear();
+	alQ.clear();
+	sc.clear();
+	id.clear();
+	tbf.clear();
+	ref.clear();
+	ex0.clear(); ex1.clear(); ge.clear();
+	dofs.clear(); dlen.clear();
+	gmb.clear(); gme.clear();
+	fkq.clear(); rlfk.clear(); rrfk.clear();
+	dpool.clear();
+	mpool.clear();
+	refs.clear();
+}
+
+void AlignTable_t::load(const DeltaRecord_t &rec) {
+	clear();
+	for (auto &a : rec.aligns) {
+		sR.push_back(a.sR);
+		eR.push_back(a.eR);
+		sQ.push_back(a.sQ);
+		eQ.push_back(a.eQ);
+		mmgp.push_back(a.mmgp);
+		ro.push_back(a.ro);
+		go.push_back(a.go);
+		osQ.push_back(a.osQ);
+		oeQ.push_back(a.oeQ);
+		alQ.push_back(a.alQ);
+		sc.push_back(a.sc);
+		id.push_back(a.id);
+		tbf.push_back(false);
+		ex0.push_back(-1);
+		ex1.push_back(-1);
+		ge.push_back(0);
+		gmb.push_back(0);
+		gme.push_back(0);
+
+		// alignments of a contig come together
+		if (refs.empty() || refs.back() != a.idR)
+			refs.push_back(a.idR);
+		ref.push_back(refs.size() - 1);
+
+		dofs.push_back(dpool.size());
+		dpool.insert(dpool.end(), a.deltas.begin(), a.deltas.end());
+		dlen.push_back(dpool.size() - dofs.back());
+	}
+	fkq.assign(size(), 0);
+	rlfk.resize(size());
+	rrfk.resize(size());
+}
+
+std::string AlignTable_t::concise_form(const int r, const SymbolTable_t &st) const {
+	const int *dt = deltas(r);
+	std::string cf = refs[ref[r]] + ":" + st.vdjeName(ex0[r], ex1[r]) + ":";
+	cf += std::to_string(sR[r]) + "-" + std::to_string(eR[r]) + ":";
+	cf += std::to_string(sQ[r]) + "-" + std::to_string(eQ[r]) + ":";
+	cf += std::to_string(mmgp[r]) + ":";
+	cf += std::to_string(dt[0]);
+	for (int i = 1; i < dlen[r]; i++) {
+		cf += "," + std::to_string(dt[i]);
+	}
+	return cf;
+}
+
+void DeltaCursor_t::seek(const int qs) {
+	while (qi < qs) {
+		int g = dt[gi];
+		int d = qs - qi;
+		if (g > 0) {
+			if (d < g-1) {
+				ri += d;
+				qi += d;
+				gs = d;
+			} else {
+				ri += g;
+				qi += g-1;
+				gi += 1;
+			}
+		} else if (g == 0) {
+			ri += d;
+			qi += d;
+			gs = d;
+		} else {
+			g = -g;
+			if (d < g) {
+				ri += d;
+				qi += d;
+				gs = d;
+			} else {
+				ri += g-1;
+				qi += g;
+				gi += 1;
+			}
+		}
+	}
+}
+
+void AlignTable_t::getEndAlignment(const int r, const int n, const bool rev, const RefStore_t &rs,
+		std::string_view qry, std::pmr::string &ra, std::pmr::string &qa) const {
+	if ((size_t)oeQ[r] > qry.size())
+		throw std::out_of_range("AlignTable_t::getEndAlignment");
+
+	// starting column
+	DeltaCursor_t c(deltas(r));
+	if (n < 0)
+		c.seek(alQ[r] + n);
+
+	// count the columns
+	int cols = 0;
+	DeltaCursor_t(c).walk(abs(n), [&cols](int, int, const int len, const int gap) {
+		cols += len + (gap != 0);
+	});
+	ra.resize(cols);
+	qa.resize(cols);
+
+	// get aligned segment on reference and query, run by run
+	const std::string &id = refs[ref[r]];
+	int k = 0;
+	c.walk(abs(n), [&](const int ri, const int qi, const int len, const int gap) {
+		const int rl = len + (gap > 0);
+		const int ql = len + (gap < 0);
+		rs.subseq(id, sR[r] + ri, sR[r] + ri + rl - 1, &ra[k]);
+		if (ro[r] == '+')
+			std::copy_n(qry.data() + osQ[r] - 1 + qi, ql, &qa[k]);
+		else
+			FASTA_t::revcom(qry.data() + oeQ[r] - qi - ql, ql, &qa[k]);
+		if (gap > 0)
+			qa[k+len] = '_';
+		else if (gap < 0)
+			ra[k+len] = '_';
+		k += len + (gap != 0);
+	});
+
+	if (rev == true) {
+		FASTA_t::revcomInPlace(ra);
+		FASTA_t::revcomInPlace(qa);
+	}
+}
+
+void AlignTable_t::cutEndAlignment(const int r, const int n, const RefStore_t &rs, std::string_view qry) {
+	if (n == 0)
+		return;
+
+	// get end alignment, count mismatch and gap, and update
+	getEndAlignment(r, n, false, rs, qry, cutra_m, cutqa_m);
+	mmgp[r] -= SCORE_t::countMismatches(cutra_m.data(), cutqa_m.data(), cutra_m.size());
+
+	// move to the desired cut point
+	int *dt = dpool.data() + dofs[r];
+	DeltaCursor_t c(dt);
+	c.seek(n > 0 ? n : alQ[r] + n);
+	const int ri = c.ri;
+	const int qi = c.qi;
+	const int gi = c.gi;
+	const int gs = c.gs;
+
+	// cut from head
+	if (n > 0) {
+		sR[r]   += ri;
+		alQ[r]  -= n;
+
+		// drop the gaps passed, and shorten the one cut into
+		dofs[r] += gi;
+		dlen[r] -= gi;
+		if (dt[gi] != 0)
+			dt[gi] = dt[gi] > 0 ? dt[gi] - gs : dt[gi] + gs;
+		if (ro[r] == '+') {
+			sQ[r]  += qi;
+			osQ[r] += qi;
+		} else {
+			sQ[r]  -= qi;
+			oeQ[r] -= qi;
+		}
+
+		// cut from tail
+	} else {
+		int rl = (eR[r] - sR[r] + 1) - ri;
+		int ql = alQ[r] - qi;
+		eR[r]   -= rl;
+		alQ[r]  += n;
+
+		// keep the gaps passed
+		dt[gi] = 0;
+		dlen[r] = gi + 1;
+		if (ro[r] == '+') {
+			eQ[r]  -= ql;
+			oeQ[r] -= ql;
+		} else {
+			eQ[r]  += ql;
+			osQ[r] += ql;
+		}
+	}
+
+	// Note that simc, stpc, gcQ, sc, and id are not modified.
+	// But these will not be used afterward.
+}
@@ -0,0 +1,187 @@
+#ifndef ALIGNTABLE_HPP
+#define ALIGNTABLE_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+
+#include "symbols.hpp"
+#include "refstore.hpp"
+
+struct DeltaRecord_t;
+
+/*
+  usage:
+  AlignTable_t tab(&arena);       // or the default resource
+  tab.load(rec);                 // rows 0..size()-1 in the order of rec.aligns
+  if (tab.overlapQ(a, b)) ...
+  tab.setMembers(r, gm.begin(), gm.end());
+  tab.getEndAlignment(r, -10, false, refs, qry, ra, qa);   // last 10 query bases, aligned
+*/
+
+//==================================================DeltaCursor_t===
+
+/* Columns of an alignment follow its deltas (as in MUMMER): a delta g > 0
+ * is g-1 matched columns and a reference base aligned to a gap on the
+ * query, g < 0 is -g-1 matched columns and a query base aligned to a gap
+ * on the reference, and the ending 0 is matched columns to the end.
+ */
+
+// position in the columns of a row, moved along the query
+struct DeltaCursor_t {
+	const int *dt;   // deltas of the row
+	int ri;          // offset on the reference segment
+	int qi;          // offset on the query segment
+	int gi;          // current delta
+	int gs;          // matched columns of the current delta already passed
+
+	explicit DeltaCursor_t(const int *deltas) {
+		dt = deltas;
+		ri = qi = gi = gs = 0;
+	}
+
+	// pass the columns before query offset qs (and a query gap right at it)
+	void seek(const int qs);
+
+	// visit the columns of the next d query bases as runs of
+	// visit(ri, qi, len, gap): len matched columns, then a column with a gap
+	// on the query (gap > 0) or the reference (gap < 0) if gap != 0
+	template <class Visit>
+	void walk(int d, Visit visit) {
+		while (d > 0) {
+			int g = dt[gi];
+			if (g > 0) {
+				g -= gs;
+				if (d < g) {
+					visit(ri, qi, d, 0);
+					ri += d;
+					qi += d;
+					gs += d;
+					d = 0;
+				} else {
+					visit(ri, qi, g-1, 1);
+					ri += g;
+					qi += g-1;
+					d -= g-1;
+					gi += 1;
+					gs = 0;
+				}
+			} else if (g == 0) {
+				visit(ri, qi, d, 0);
+				ri += d;
+				qi += d;
+				d = 0;
+			} else {
+				g = -g - gs;
+				if (d < g) {
+					visit(ri, qi, d, 0);
+					ri += d;
+					qi += d;
+					gs += d;
+					d = 0;
+				} else {
+					visit(ri, qi, g-1, -1);
+					ri += g-1;
+					qi += g;
+					d -= g;
+					gi += 1;
+					gs = 0;
+				}
+			}
+		}
+	}
+};
+
+//===================================================AlignTable_t===
+
+// alignments of a query in parallel arrays, referred to by row
+class AlignTable_t
+{
+public:
+	// per row
+	std::pmr::vector<int> sR, eR;         // coordinates on the reference
+	std::pmr::vector<int> sQ, eQ;         // coordinates on the query
+	std::pmr::vector<int> mmgp;           // number of mismatches and gaps
+	std::pmr::vector<char> ro, go;        // orientation along reference and gene
+	std::pmr::vector<int> osQ, oeQ;       // oriented start and end on the query
+	std::pmr::vector<int> alQ;            // query alignment length
+	std::pmr::vector<int> sc;             // score
+	std::pmr::vector<float> id;           // identity
+	std::pmr::vector<char> tbf;           // to be filtered
+	std::pmr::vector<int> ref;            // reference contig (index in refs)
+	std::pmr::vector<int> ex0, ex1, ge;   // annotation (see SymbolTable_t)
+	std::pmr::vector<int> dofs, dlen;     // deltas in dpool
+	std::pmr::vector<int> gmb, gme;       // group members in mpool (of a representative)
+	std::pmr::vector<char> fkq;           // flanking bases loaded (adjustOverlap)
+	std::pmr::vector<std::string> rlfk;   // reference left flanking bases
+	std::pmr::vector<std::string> rrfk;   // reference right flanking bases
+
+	// shared by rows
+	std::pmr::vector<int> dpool;          // deltas of all rows, each ending with 0
+	std::pmr::vector<int> mpool;          // group members of all rows
+	std::pmr::vector<std::string> refs;        // reference contig IDs
+
+	// all arrays allocated from mr (e.g., the Arena_t of a worker)
+	explicit AlignTable_t(std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+		: sR(mr), eR(mr), sQ(mr), eQ(mr), mmgp(mr), ro(mr), go(mr), osQ(mr), oeQ(mr),
+		alQ(mr), sc(mr), id(mr), tbf(mr), ref(mr), ex0(mr), ex1(mr), ge(mr),
+		dofs(mr), dlen(mr), gmb(mr), gme(mr), fkq(mr), rlfk(mr), rrfk(mr),
+		dpool(mr), mpool(mr), refs(mr), cutra_m(mr), cutqa_m(mr) {}
+
+	void clear();
+	void load(const DeltaRecord_t &rec);
+
+	int size() const {
+		return sR.size();
+	}
+
+	// deltas of a row (the last one is 0)
+	const int *deltas(const int r) const {
+		return dpool.data() + dofs[r];
+	}
+
+	// group members of a representative
+	const int *gmBegin(const int r) const {
+		return mpool.data() + gmb[r];
+	}
+	const int *gmEnd(const int r) const {
+		return mpool.data() + gme[r];
+	}
+	int gmSize(const int r) const {
+		return gme[r] - gmb[r];
+	}
+	template <class It>
+	void setMembers(const int r, It first, It last) {
+		gmb[r] = mpool.size();
+		mpool.insert(mpool.end(), first, last);
+		gme[r] = mpool.size();
+	}
+
+	// 1 if a overlaps more than half of b on the query
+	int overlapQ(const int a, const int b) const {
+		int ol = osQ[a] < osQ[b] ? oeQ[a] - osQ[b] + 1 : oeQ[b] - osQ[a] + 1;
+		return ol > alQ[b] * 0.5 ? 1 : 0;
+	}
+
+	std::string concise_form(const int r, const SymbolTable_t &st) const;
+
+	/* The segments of a row are views: the reference is decoded from rs at
+	 * [sR, eR] and the query is qry at [osQ, oeQ] (reverse complemented if
+	 * ro is '-'), so a cut only moves the coordinates and the deltas.
+	 */
+
+	// aligned columns of the first n (> 0) or the last -n (< 0) query bases into ra and qa
+	// ('_' for gap), reverse complemented if rev
+	void getEndAlignment(const int r, const int n, const bool rev, const RefStore_t &rs,
+			std::string_view qry, std::pmr::string &ra, std::pmr::string &qa) const;
+
+	// cut the first n (> 0) or the last -n (< 0) query bases
+	void cutEndAlignment(const int r, const int n, const RefStore_t &rs, std::string_view qry);
+
+private:
+	std::pmr::string cutra_m, cutqa_m;    // columns being cut
+};
+
+#endif /* aligntable.hpp */
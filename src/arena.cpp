@@ -0,0 +1,51 @@
+#include "arena.hpp"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+
+Arena_t::Arena_t(const size_t chunk) {
+	chunks_m.emplace_back(new char[chunk]);
+	sizes_m.push_back(chunk);
+	reset();
+}
+
+void *Arena_t::do_allocate(size_t bytes, size_t align) {
+	uintptr_t p = ((uintptr_t)cur_m + align - 1) & ~(uintptr_t)(align - 1);
+	if (p + bytes > (uintptr_t)end_m) {
+		nextChunk(bytes + align);
+		p = ((uintptr_t)cur_m + align - 1) & ~(uintptr_t)(align - 1);
+	}
+	cur_m = (char *)(p + bytes);
+	return (void *)p;
+}
+
+void Arena_t::nextChunk(const size_t need) {
+
+	// chunks kept from earlier queries
+	while (++ci_m < chunks_m.size()) {
+		if (sizes_m[ci_m] >= need) {
+			cur_m = chunks_m[ci_m].get();
+			end_m = cur_m + sizes_m[ci_m];
+			return;
+		}
+	}
+
+	// a new chunk, twice as large as the last one
+	const size_t n = std::max(need, sizes_m.back() * 2);
+	chunks_m.emplace_back(new char[n]);
+	sizes_m.push_back(n);
+	ci_m = chunks_m.size() - 1;
+	cur_m = chunks_m.back().get();
+	end_m = cur_m + n;
+}
+
+size_t Arena_t::capacity() const {
+	size_t n = 0;
+	for (auto s : sizes_m)
+		n += s;
+	return n;
+}
@@ -0,0 +1,58 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+
+/*
+  usage:
+  Arena_t arena;                          // one per worker thread
+  std::pmr::vector<int> v(&arena);        // allocate from the arena
+  ...
+  arena.reset();                          // release everything at once, keep the chunks
+*/
+
+//=======================================================Arena_t===
+
+// bump allocator for objects living as long as a query, not thread-safe
+class Arena_t : public std::pmr::memory_resource
+{
+private:
+	std::vector<std::unique_ptr<char[]>> chunks_m;   // memory kept over resets
+	std::vector<size_t> sizes_m;                     // size of each chunk
+	size_t ci_m;                                     // current chunk
+	char *cur_m;                                     // next free byte in the current chunk
+	char *end_m;                                     // end of the current chunk
+
+	// move to a later chunk with at least need bytes, allocating one if none
+	void nextChunk(const size_t need);
+
+protected:
+	void *do_allocate(size_t bytes, size_t align) override;
+	void do_deallocate(void *, size_t, size_t) override {
+		// released by reset()
+	}
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+		return this == &other;
+	}
+
+public:
+	explicit Arena_t(const size_t chunk = 1 << 16);
+
+	Arena_t(const Arena_t &) = delete;
+	Arena_t &operator=(const Arena_t &) = delete;
+
+	// release all allocations in O(1); objects allocated before must not be used again
+	void reset() {
+		ci_m = 0;
+		cur_m = chunks_m[0].get();
+		end_m = cur_m + sizes_m[0];
+	}
+
+	// memory held by the arena
+	size_t capacity() const;
+};
+
+#endif /* arena.hpp */
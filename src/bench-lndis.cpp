@@ -0,0 +1,155 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <memory_resource>
+#include <getopt.h>
+#include "delta.hpp"
+
+using namespace std;
+
+// GeneChain (DeltaFilter_t::LNDIS) against the O(n^2) scan it replaced:
+// the same chains on random inputs, and the time on reads with thousands of alignments
+
+//====================================================Options===
+int       OPT_Check      = 100000;   // random inputs of the equivalence check
+int       OPT_Repeat     = 10;       // runs of each timing
+unsigned  OPT_Seed       = 7;
+
+//===================================================Function===
+int ScanChain(const int *rank, const int *len, const int n, const bool up, vector<int> &chain);
+void RandomRead(mt19937 &rng, const int n, const int maxlen, vector<int> &rank, vector<int> &len);
+void ParseArgs(int argc, char ** argv);
+void help();
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	ParseArgs(argc, argv);
+	mt19937 rng(OPT_Seed);
+	vector<int> rank, len, old;
+	pmr::vector<int> chain;
+
+	// the chains and their lengths, both ways, with many ties (few distinct lengths)
+	int bad = 0;
+	for (int k = 0; k < OPT_Check; k++) {
+		RandomRead(rng, 1 + rng() % 12, 4, rank, len);
+		for (const bool up : {true, false}) {
+			const int l = GeneChain(rank.data(), len.data(), rank.size(), up, chain);
+			const int m = ScanChain(rank.data(), len.data(), rank.size(), up, old);
+			if (l != m || !equal(chain.begin(), chain.end(), old.begin(), old.end()))
+				bad++;
+		}
+	}
+	cout << "check\t" << OPT_Check << " random reads\t" << bad << " differ\n";
+
+	cout << "alignments\tlinear(ms)\tscan(ms)\n";
+	for (const int n : {100, 1000, 5000}) {
+		RandomRead(rng, n, 100, rank, len);
+		double t[2];
+		for (int s = 0; s < 2; s++) {
+			auto t0 = chrono::steady_clock::now();
+			for (int k = 0; k < OPT_Repeat; k++) {
+				if (s == 0) {
+					GeneChain(rank.data(), len.data(), n, true, chain);
+					GeneChain(rank.data(), len.data(), n, false, chain);
+				} else {
+					ScanChain(rank.data(), len.data(), n, true, old);
+					ScanChain(rank.data(), len.data(), n, false, old);
+				}
+			}
+			t[s] = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / OPT_Repeat;
+		}
+		cout << n << "\t" << t[0] << "\t" << t[1] << "\n";
+	}
+	return bad ? 1 : 0;
+}
+
+//=================================================ScanChain===
+// the double loop of LNDIS before GeneChain
+int ScanChain(const int *rank, const int *len, const int n, const bool up, vector<int> &chain) {
+	vector<int> cl(len, len + n);
+	vector<int> from(n, -1);
+
+	for (int i = 1; i < n; i++) {
+		for (int j = 0; j < i; j++) {
+			if (rank[j] >= 0 && rank[i] >= 0 &&
+					(up ? rank[j] <= rank[i] : rank[j] >= rank[i]) &&
+					(cl[j] + len[i]) > cl[i]) {
+				cl[i] = cl[j] + len[i];
+				from[i] = j;
+			}
+		}
+	}
+
+	int maxl = 0;
+	int maxi = -1;
+	for (int i = 0; i < n; i++) {
+		if (cl[i] >= maxl) {
+			maxl = cl[i];
+			maxi = i;
+		}
+	}
+
+	chain.clear();
+	int i = maxi;
+	chain.insert(chain.begin(), i);
+	while (from[i] != -1) {
+		i = from[i];
+		chain.insert(chain.begin(), i);
+	}
+	return maxl;
+}
+
+//================================================RandomRead===
+// ranks of V0..C4 or intergenic (-1), lengths 1 + 10k (k < maxlen)
+void RandomRead(mt19937 &rng, const int n, const int maxlen, vector<int> &rank, vector<int> &len) {
+	rank.resize(n);
+	len.resize(n);
+	for (int i = 0; i < n; i++) {
+		rank[i] = (int)(rng() % (GEO_RANKS + 1)) - 1;
+		len[i] = 1 + rng() % maxlen * 10;
+	}
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv) {
+	int opt, errflg = 0;
+	const char *optstring = "c:r:s:";
+	const struct option int_opts[] = {
+		{"check",  1, NULL, 'c'},
+		{"repeat", 1, NULL, 'r'},
+		{"seed",   1, NULL, 's'},
+		{NULL,     0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'c':
+				OPT_Check = atoi(optarg);
+				break;
+			case (int)'r':
+				OPT_Repeat = atoi(optarg);
+				break;
+			case (int)'s':
+				OPT_Seed = atoi(optarg);
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind != argc || OPT_Repeat < 1) help();
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : bench-lndis [option]\n" <<
+		"         (GeneChain of LNDIS against the O(n^2) scan: equivalence on random reads, time at\n" <<
+		"          100, 1000 and 5000 alignments; exit 1 if any chain differs)\n\n" <<
+		"option : -c | --check    random reads to compare          [100000]\n" <<
+		"         -r | --repeat   runs of each timing              [10]\n" <<
+		"         -s | --seed     random seed                      [7]\n\n";
+	exit(0);
+}
@@ -0,0 +1,153 @@
+#include "bundle.hpp"
+#include "vdjreader.hpp"
+#include "extractCDR3.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+
+
+// extensions of the sources of a bundle, in the order of its header
+static const char *SourceExt[BUNDLE_SOURCES] = {".fa", ".vdj", ".cdr"};
+
+// size and hash of the contents of a source file (false if it cannot be mapped)
+static bool sourceStamp(const std::string &path, uint64_t &size, uint64_t &hash) {
+	MappedFile_t mf;
+	if (!mf.open(path))
+		return false;
+	const char *p = mf.data();
+	size = mf.size();
+	hash = 0x9e3779b97f4a7c15ULL ^ size;
+	auto mix = [&hash](const uint64_t w) {
+		hash = (hash ^ w) * 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 32;
+	};
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t w;
+		memcpy(&w, p + i, 8);
+		mix(w);
+	}
+	uint64_t w = 0;
+	memcpy(&w, p + i, size - i);
+	mix(w);
+	return true;
+}
+
+// header of a mapped bundle after its magic and version (false if of another version)
+struct BundleHeader_t {
+	uint64_t ro, rn;   // offset and size of the reference section
+	uint64_t so, sn;   // of the symbol section
+	uint64_t size[BUNDLE_SOURCES], hash[BUNDLE_SOURCES];
+
+	bool read(const MappedFile_t &map, const std::string &bundle_path) {
+		BundleReader_t br(map.data(), map.size());
+		const char *magic = br.getArray<char>(8);
+		if (strncmp(magic, BUNDLE_MAGIC, 8) != 0 || br.get<uint32_t>() != BUNDLE_VERSION)
+			return false;
+		br.get<uint32_t>();
+		ro = br.get<uint64_t>();
+		rn = br.get<uint64_t>();
+		so = br.get<uint64_t>();
+		sn = br.get<uint64_t>();
+		for (int k = 0; k < BUNDLE_SOURCES; k++) {
+			size[k] = br.get<uint64_t>();
+			hash[k] = br.get<uint64_t>();
+		}
+		if (ro + rn > map.size() || so + sn > map.size() || ro % 8 || so % 8) {
+			std::cerr << "\033[31mERROR:\033[0m Could not parse bundle file, " << bundle_path << std::endl;
+			exit(1);
+		}
+		return true;
+	}
+
+	// the sources prefix.fa, .vdj and .cdr are those compiled
+	bool sourcesOf(const std::string &prefix) const {
+		for (int k = 0; k < BUNDLE_SOURCES; k++) {
+			uint64_t n, h;
+			if (!sourceStamp(prefix + SourceExt[k], n, h) || n != size[k] || h != hash[k])
+				return false;
+		}
+		return true;
+	}
+};
+
+void RefBundle_t::build(const std::string &prefix, const std::string &bundle_path) {
+	RefStore_t rs;
+	rs.load(prefix + ".fa");
+	VDJReader_t vr;
+	CDRReader_t cr;
+	SymbolTable_t st;
+	st.build(vr.getallVDJInfo(prefix + ".vdj"), cr.getCDR3(prefix + ".cdr"));
+
+	BundleWriter_t refs, syms;
+	rs.save(refs);
+	st.save(syms);
+	refs.align();
+	syms.align();
+
+	// header, then the sections
+	BundleWriter_t out;
+	char magic[8] = {0};
+	memcpy(magic, BUNDLE_MAGIC, strlen(BUNDLE_MAGIC));
+	out.putArray(magic, sizeof(magic));
+	out.put<uint32_t>(BUNDLE_VERSION);
+	out.put<uint32_t>(0);
+	const uint64_t hsize = 8 + 4 + 4 + 4 * 8 + BUNDLE_SOURCES * 2 * 8;
+	out.put<uint64_t>(hsize);
+	out.put<uint64_t>(refs.data().size());
+	out.put<uint64_t>(hsize + refs.data().size());
+	out.put<uint64_t>(syms.data().size());
+	for (int k = 0; k < BUNDLE_SOURCES; k++) {
+		uint64_t n, h;
+		if (!sourceStamp(prefix + SourceExt[k], n, h)) {
+			std::cerr << "\033[31mERROR:\033[0m Could not read source file, " << prefix + SourceExt[k] << std::endl;
+			exit(1);
+		}
+		out.put<uint64_t>(n);
+		out.put<uint64_t>(h);
+	}
+
+	std::ofstream bundle(bundle_path, std::ios::binary);
+	bundle << out.data() << refs.data() << syms.data();
+	if (!bundle.good()) {
+		std::cerr << "\033[31mERROR:\033[0m Could not write bundle file, " << bundle_path << std::endl;
+		exit(1);
+	}
+}
+
+bool RefBundle_t::current(const std::string &prefix, const std::string &bundle_path) {
+	MappedFile_t map;
+	BundleHeader_t h;
+	return map.open(bundle_path) && h.read(map, bundle_path) && h.sourcesOf(prefix);
+}
+
+bool RefBundle_t::open(const std::string &prefix, RefStore_t &rs, SymbolTable_t &st) {
+	const std::string bundle_path = prefix + ".trig";
+	if (!map_m.open(bundle_path))
+		return false;
+
+	// a bundle of another version (or byte order) is left for the sources
+	BundleHeader_t h;
+	if (!h.read(map_m, bundle_path)) {
+		std::cerr << "\033[33mWARNING:\033[0m Bundle file of another version, reading the sources instead "
+			"(rebuild it with trig-index), " << bundle_path << std::endl;
+		map_m.close();
+		return false;
+	}
+
+	// and so is a stale bundle
+	if (!h.sourcesOf(prefix)) {
+		std::cerr << "\033[33mWARNING:\033[0m Bundle file older than its sources, reading the sources instead "
+			"(rebuild it with trig-index), " << bundle_path << std::endl;
+		map_m.close();
+		return false;
+	}
+
+	BundleReader_t refs(map_m.data() + h.ro, h.rn);
+	BundleReader_t syms(map_m.data() + h.so, h.sn);
+	rs.map(refs);
+	st.map(syms);
+	return true;
+}
@@ -0,0 +1,147 @@
+#ifndef BUNDLE_HPP
+#define BUNDLE_HPP
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "mapfile.hpp"
+#include "refstore.hpp"
+#include "symbols.hpp"
+
+/*
+  usage:
+  RefBundle_t::build("hsa_trb", "hsa_trb.trig");   // trig-index: hsa_trb.fa, .vdj and .cdr
+  RefBundle_t rb;                                  // kept while rs is used
+  rb.open("hsa_trb", rs, st);                      // rs views the sequences of hsa_trb.trig
+  RefBundle_t::current("hsa_trb", "hsa_trb.trig"); // trig-index -c: not stale
+*/
+
+/* A bundle is a header (BUNDLE_MAGIC, BUNDLE_VERSION, the offset and size
+ * of the reference and the symbol sections, then the size and a hash of
+ * each of the .fa, .vdj and .cdr files it was compiled from) followed by
+ * the sections, each starting at a multiple of 8 bytes. Values are in the
+ * byte order of the machine that wrote it, so a bundle from another byte
+ * order fails the version check and must be rebuilt like one from an
+ * older version. A bundle is stale once its sources differ from the files
+ * next to it (e.g., a gene file edited without "make index"); the hash is
+ * of the contents, so copies of the sources (as made by trig.pl) match.
+ */
+
+#define BUNDLE_MAGIC   "TRIGIDX"
+#define BUNDLE_VERSION 2
+#define BUNDLE_SOURCES 3   // .fa, .vdj and .cdr
+
+//================================================BundleWriter_t===
+
+// a section of a bundle being written
+class BundleWriter_t
+{
+private:
+	std::string data_m;
+
+public:
+	template <class T>
+	void put(const T v) {
+		data_m.append((const char *)&v, sizeof(T));
+	}
+
+	// n values, starting at a multiple of 8 bytes
+	template <class T>
+	void putArray(const T *v, const size_t n) {
+		align();
+		data_m.append((const char *)v, n * sizeof(T));
+	}
+
+	void putString(const std::string &s) {
+		put<uint32_t>(s.size());
+		data_m.append(s);
+	}
+
+	void align() {
+		data_m.append((8 - data_m.size() % 8) % 8, '\0');
+	}
+
+	const std::string &data() const {
+		return data_m;
+	}
+};
+
+//================================================BundleReader_t===
+
+// a section of a mapped bundle being read, exit on a truncated section
+class BundleReader_t
+{
+private:
+	const char *base_m;   // start of the section (a multiple of 8 bytes in the mapping)
+	const char *pos_m;
+	const char *end_m;
+
+	void need(const size_t n) {
+		if ((size_t)(end_m - pos_m) < n) {
+			std::cerr << "\033[31mERROR:\033[0m Could not parse bundle file, truncated section" << std::endl;
+			exit(1);
+		}
+	}
+
+public:
+	BundleReader_t(const char *p, const size_t n) {
+		base_m = pos_m = p;
+		end_m = p + n;
+	}
+
+	template <class T>
+	T get() {
+		need(sizeof(T));
+		T v;
+		memcpy(&v, pos_m, sizeof(T));
+		pos_m += sizeof(T);
+		return v;
+	}
+
+	// n values in place, as written by putArray
+	template <class T>
+	const T *getArray(const size_t n) {
+		align();
+		need(n * sizeof(T));
+		const T *v = (const T *)pos_m;
+		pos_m += n * sizeof(T);
+		return v;
+	}
+
+	std::string getString() {
+		const uint32_t n = get<uint32_t>();
+		need(n);
+		std::string s(pos_m, n);
+		pos_m += n;
+		return s;
+	}
+
+	void align() {
+		pos_m += std::min((size_t)(end_m - pos_m), (size_t)((8 - (pos_m - base_m) % 8) % 8));
+	}
+};
+
+//===================================================RefBundle_t===
+
+// reference sequences, exons, CDR3 anchors and symbols of a species and locus in one file
+class RefBundle_t
+{
+private:
+	MappedFile_t map_m;
+
+public:
+	// compile prefix.fa, prefix.vdj and prefix.cdr into bundle_path
+	static void build(const std::string &prefix, const std::string &bundle_path);
+
+	// true if bundle_path is of this version and compiled from prefix.fa, .vdj and .cdr as they are
+	static bool current(const std::string &prefix, const std::string &bundle_path);
+
+	// map prefix.trig and load rs and st from it (false if it cannot be mapped, is of another
+	// version or is stale)
+	bool open(const std::string &prefix, RefStore_t &rs, SymbolTable_t &st);
+};
+
+#endif /* bundle.hpp */
@@ -0,0 +1,356 @@
+#include "clone.hpp"
+#include "codon.hpp"
+#include "gzstream.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <tuple>
+
+
+// fields of s separated by c
+static std::vector<std::string_view> split(std::string_view s, const char c) {
+	std::vector<std::string_view> f;
+	size_t b = 0, e;
+	while ((e = s.find(c, b)) != std::string_view::npos) {
+		f.push_back(s.substr(b, e - b));
+		b = e + 1;
+	}
+	f.push_back(s.substr(b));
+	return f;
+}
+
+// V, CDR3 and J of V:CDR3:J
+static void splitVDJ(std::string_view s, std::string_view &v, std::string_view &seq, std::string_view &j) {
+	const size_t a = s.find(':');
+	const size_t b = a == std::string_view::npos ? a : s.find(':', a + 1);
+	v = s.substr(0, a);
+	seq = a == std::string_view::npos ? std::string_view() : s.substr(a + 1, b == std::string_view::npos ? b : b - a - 1);
+	j = b == std::string_view::npos ? std::string_view() : s.substr(b + 1);
+}
+
+// equal but where either has an N
+static bool matchN(std::string_view a, std::string_view b) {
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i] != b[i] && a[i] != 'N' && b[i] != 'N')
+			return false;
+	}
+	return true;
+}
+
+// within one mismatch or indel, and at least 90% identical (usearch -id 0.9)
+static bool withinOne(std::string_view a, std::string_view b) {
+	if (a.size() < b.size())
+		std::swap(a, b);
+	const size_t la = a.size(), lb = b.size();
+	if (la == 0 || la - lb > 1)
+		return false;
+
+	int ed = 0;
+	if (la == lb) {
+		for (size_t i = 0; i < la && ed <= 1; i++)
+			ed += a[i] != b[i] && a[i] != 'N' && b[i] != 'N';
+	} else {
+		size_t i = 0;
+		while (i < lb && (a[i] == b[i] || a[i] == 'N' || b[i] == 'N'))
+			i++;
+		ed = matchN(a.substr(i + 1), b.substr(i)) ? 1 : 2;
+	}
+	return ed <= 1 && (double)(la - ed) / la >= 0.9;
+}
+
+static bool bySize(const std::pair<std::string, double> &a, const std::pair<std::string, double> &b) {
+	return a.second != b.second ? a.second > b.second : a.first < b.first;
+}
+
+// entries of a weight table by size
+static std::vector<std::pair<std::string, double>> sorted(const std::unordered_map<std::string, double> &m) {
+	std::vector<std::pair<std::string, double>> v(m.begin(), m.end());
+	std::sort(v.begin(), v.end(), bySize);
+	return v;
+}
+
+//==================================================NeighbourIndex_t===
+
+// core clones of each V:J and length, with each block of CLONE_BLOCK bases bucketed
+class NeighbourIndex_t
+{
+private:
+	struct Part {
+		std::vector<int> ids;    // all clones in order
+		std::vector<int> wild;   // clones with an N, or shorter than a block
+		std::vector<std::unordered_map<std::string_view, std::vector<int>>> blocks;
+	};
+	const std::vector<Clone_t> &core_m;
+	std::unordered_map<std::string, Part> part_m;
+
+	static std::string key(std::string_view v, std::string_view j, const size_t len) {
+		return std::string(v) + ":" + std::string(j) + ":" + std::to_string(len);
+	}
+
+public:
+	NeighbourIndex_t(const std::vector<Clone_t> &core) : core_m(core) {
+		for (size_t i = 0; i < core.size(); i++) {
+			const std::string_view s = core[i].seq;
+			Part &p = part_m[key(core[i].v, core[i].j, s.size())];
+			p.ids.push_back(i);
+			if (s.size() < CLONE_BLOCK || s.find('N') != std::string_view::npos) {
+				p.wild.push_back(i);
+				continue;
+			}
+			p.blocks.resize(s.size() / CLONE_BLOCK);
+			for (size_t b = 0; b < p.blocks.size(); b++)
+				p.blocks[b][s.substr(b * CLONE_BLOCK, CLONE_BLOCK)].push_back(i);
+		}
+	}
+
+	// first core clone of the same V:J and length that seq matches, -1 if none
+	int find(std::string_view v, std::string_view seq, std::string_view j) const {
+		auto pi = part_m.find(key(v, j, seq.size()));
+		if (pi == part_m.end())
+			return -1;
+		const Part &p = pi->second;
+
+		// a block without N must be the same in the clone (unless the clone has an N)
+		int best = -1;
+		size_t b = 0;
+		while (b < p.blocks.size() && seq.substr(b * CLONE_BLOCK, CLONE_BLOCK).find('N') != std::string_view::npos)
+			b++;
+		const std::vector<int> *cand = &p.ids;
+		if (b < p.blocks.size()) {
+			auto bi = p.blocks[b].find(seq.substr(b * CLONE_BLOCK, CLONE_BLOCK));
+			cand = bi == p.blocks[b].end() ? nullptr : &bi->second;
+		}
+		if (cand) {
+			for (const int c : *cand) {
+				if (matchN(seq, core_m[c].seq)) {
+					best = c;
+					break;
+				}
+			}
+		}
+		for (const int c : p.wild) {
+			if (best >= 0 && c > best)
+				break;
+			if (matchN(seq, core_m[c].seq)) {
+				best = c;
+				break;
+			}
+		}
+		return best;
+	}
+};
+
+//=================================================CloneEngine_t===
+
+void CloneEngine_t::add(const std::string &line) {
+	// query, regularity, V:CDR3:J, qualities and amino acids of each CDR3 ('|' separated)
+	const std::vector<std::string_view> f = split(line, '\t');
+	if (f.size() < 4 || f[1] == "---" || atoi(std::string(f[1]).c_str()) != 2)
+		return;
+	if (f[2].find("---") != std::string_view::npos || f[3].find("---") != std::string_view::npos)
+		return;
+	const std::string_view qua = f[3].substr(0, f[3].find('|'));   // use first qua
+	const std::vector<std::string_view> seq = split(f[2], '|');
+	const double wt = 1.0 / seq.size();
+
+	// position of low quality (q<10) bases
+	std::vector<int> lqb;
+	for (size_t i = 0; i < qua.size(); i++) {
+		if ((unsigned char)qua[i] - 33 < CLONE_LQ)
+			lqb.push_back(i);
+	}
+
+	// core clone if no low quality base
+	if (lqb.empty()) {
+		for (const auto &s : seq)
+			clone_m[std::string(s)] += wt;
+
+	// deferred if < 70% of the bases are of low quality (the last line of a read ID kept)
+	} else if ((double)lqb.size() / qua.size() < CLONE_LQFRAC) {
+		auto id = lqid_m.emplace(std::string(f[0]), lq_m.size());
+		if (id.second)
+			lq_m.emplace_back();
+		LowQual_t &lq = lq_m[id.first->second];
+		lq.wt = wt;
+		lq.seq.assign(seq.begin(), seq.end());
+		lq.lqb = std::move(lqb);
+	}
+}
+
+void CloneEngine_t::load(const std::string &cdr3_path) {
+	GzInStream_t in;
+	in.open(cdr3_path);
+	if (!in.good()) {
+		std::cerr << "\033[31mERROR:\033[0m Could not parse cdr3 file, " << cdr3_path << std::endl;
+		exit(1);
+	}
+	std::string line;
+	while (std::getline(in, line))
+		add(line);
+}
+
+void CloneEngine_t::rescue() {
+	// accept a low quality CDR3 if the clone exists, otherwise mask its low quality bases
+	std::unordered_map<std::string, double> defer;
+	for (const auto &lq : lq_m) {
+		for (const auto &s : lq.seq) {
+			auto c = clone_m.find(s);
+			if (c != clone_m.end()) {
+				c->second += lq.wt;
+				continue;
+			}
+			std::string_view v, seq, j;
+			splitVDJ(s, v, seq, j);
+			std::string m(seq);
+			for (const int p : lq.lqb) {
+				if (p < (int)m.size())
+					m[p] = 'N';
+				else if (p == (int)m.size())
+					m += 'N';
+			}
+			defer[std::string(v) + ":" + m + ":" + std::string(j)] += lq.wt;
+		}
+	}
+	lq_m.clear();
+	lqid_m.clear();
+
+	// core clones and deferred CDR3s by size
+	sortClones();
+	const std::vector<std::pair<std::string, double>> dv = sorted(defer);
+	NeighbourIndex_t ni(clones_m);
+
+	// the core clone of each deferred CDR3, searched in parallel
+	std::vector<int> hit(dv.size(), -1);
+	std::atomic<size_t> next(0);
+	auto search = [&]() {
+		const size_t step = 1024;
+		for (size_t b; (b = next.fetch_add(step)) < dv.size(); ) {
+			for (size_t i = b; i < std::min(b + step, dv.size()); i++) {
+				std::string_view v, seq, j;
+				splitVDJ(dv[i].first, v, seq, j);
+				hit[i] = ni.find(v, seq, j);
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads_m; t++)
+		workers.emplace_back(search);
+	search();
+	for (auto &w : workers)
+		w.join();
+
+	// assign the masked deferred CDR3s to the perfectly aligned core clone
+	for (size_t i = 0; i < dv.size(); i++) {
+		if (hit[i] >= 0)
+			clones_m[hit[i]].size += dv[i].second;
+	}
+	std::sort(clones_m.begin(), clones_m.end(), [](const Clone_t &a, const Clone_t &b) {
+		if (a.size != b.size)
+			return a.size > b.size;
+		return std::tie(a.v, a.seq, a.j) < std::tie(b.v, b.seq, b.j);
+	});
+}
+
+void CloneEngine_t::sortClones() {
+	clones_m.clear();
+	for (const auto &c : sorted(clone_m)) {
+		std::string_view v, seq, j;
+		splitVDJ(c.first, v, seq, j);
+		clones_m.push_back({std::string(v), std::string(seq), std::string(j), c.second, -1});
+	}
+	clone_m.clear();
+}
+
+void CloneEngine_t::cluster() {
+	// clone IDs of each VJ pair, by size
+	std::unordered_map<std::string, std::vector<int>> vjid;
+	for (size_t i = 0; i < clones_m.size(); i++)
+		vjid[clones_m[i].v + ":" + clones_m[i].j].push_back(i);
+	std::vector<std::vector<int> *> groups;
+	for (auto &g : vjid)
+		groups.push_back(&g.second);
+
+	// cluster each VJ pair until no clone remains (VJ pairs in parallel)
+	std::atomic<size_t> next(0);
+	auto clusterVJ = [&]() {
+		for (size_t g; (g = next.fetch_add(1)) < groups.size(); ) {
+			const std::vector<int> &ids = *groups[g];
+			std::vector<int> child;
+			for (size_t h = 0; h < ids.size(); h++) {
+				const Clone_t &p = clones_m[ids[h]];
+
+				// stop cluster if the clone size is <100, i.e., cannot have child
+				if (p.size < CLONE_MINPAR)
+					break;
+
+				// assign a potential child to the parent if the edit distance is at most 1
+				for (size_t k = h + 1; k < ids.size(); k++) {
+					Clone_t &c = clones_m[ids[k]];
+					if (c.size < p.size / 100 && std::abs((int)c.seq.size() - (int)p.seq.size()) <= 1 &&
+							c.par < 0 && withinOne(c.seq, p.seq)) {
+						c.par = ids[h];
+						child.push_back(ids[k]);
+					}
+				}
+			}
+
+			// increase size of the parent clone by the child size
+			for (auto c = child.rbegin(); c != child.rend(); c++)
+				clones_m[clones_m[*c].par].size += clones_m[*c].size;
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads_m; t++)
+		workers.emplace_back(clusterVJ);
+	clusterVJ();
+	for (auto &w : workers)
+		w.join();
+}
+
+void CloneEngine_t::rows(std::vector<CloneRow_t> &rows) const {
+	rows.clear();
+	for (const auto &c : clones_m) {
+		if (c.par >= 0)
+			continue;
+
+		// round up, translate and mark the TRB D of the CDR3
+		CloneRow_t r;
+		r.count = ceil(c.size);
+		r.nt = c.seq;
+		for (size_t i = 0; i < c.seq.size(); i += 3)
+			r.aa += i + 3 <= c.seq.size() ? CODON_t::codon(c.seq.data() + i) : '*';
+		r.v = c.v;
+		r.d = ".";
+		if (c.seq.find("ACTAGC") != std::string::npos)
+			r.d = "TRBD2";
+		else if (c.seq.find("ACAGGG") != std::string::npos)
+			r.d = "TRBD1";
+		r.j = c.j;
+		rows.push_back(std::move(r));
+	}
+}
+
+void CloneEngine_t::print(std::ostream &out) const {
+	std::vector<CloneRow_t> rs;
+	rows(rs);
+	double total = 0;
+	for (const auto &r : rs)
+		total += r.count;
+
+	char num[64];
+	out << "count\tfreq\tcdr3nt\tcdr3aa\tv\td\tj\n";
+	for (const auto &r : rs) {
+		snprintf(num, sizeof(num), "%.15g", r.count);
+		out << num;
+		snprintf(num, sizeof(num), "%.15g", r.count / total);
+		out << "\t" << num << "\t" << r.nt << "\t" << r.aa << "\t" << r.v << "\t" << r.d << "\t" << r.j << "\n";
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef CLONE_HPP
+#define CLONE_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+/*
+  usage:
+  CloneEngine_t ce(threads);
+  ce.load("read.cdr3");     // stream the regular CDR3s into weighted clones
+  ce.rescue();              // deferred (masked) CDR3s onto core clones
+  ce.cluster();             // small clones one edit from a large one into it
+  ce.print(std::cout);      // clone.txt (vdjtools format)
+  ce.rows(rows);            // or its lines in memory
+*/
+
+//=======================================================Clone_t===
+
+struct Clone_t {
+	std::string v;      // V gene
+	std::string seq;    // CDR3 nucleotides
+	std::string j;      // J gene
+	double size;        // weighted read count
+	int par;            // index of the parent clone, -1 if none
+};
+
+//====================================================CloneRow_t===
+
+// a line of clone.txt
+struct CloneRow_t {
+	double count;       // reads (rounded up)
+	std::string nt;     // cdr3nt
+	std::string aa;     // cdr3aa ('*' for a stop codon or a partial one)
+	std::string v;
+	std::string d;      // TRBD1, TRBD2 or "."
+	std::string j;
+};
+
+//===================================================LowQual_t===
+
+// a read whose CDR3 has low quality (Q<10) bases
+struct LowQual_t {
+	double wt;                       // 1 / number of CDR3s of the read
+	std::vector<std::string> seq;    // V:CDR3:J of each CDR3
+	std::vector<int> lqb;            // positions of the low quality bases
+};
+
+//=================================================CloneEngine_t===
+
+/* Port of CorrectCDR3Error.pl. CDR3s without low quality bases are core
+ * clones. A read with low quality bases (in less than 70% of them) adds to
+ * the core clones it already matches, and otherwise its CDR3s are deferred
+ * with those bases masked to N. A deferred CDR3 is rescued by the first
+ * core clone (in size order) of the same V:J and length that it matches
+ * with N matching any base, found through blocks of the core CDR3s that
+ * must match exactly (pigeonhole) in place of usearch -id 1.0. Clones of
+ * at least 100 reads then absorb the clones of the same V:J under 1% of
+ * their size that are within one mismatch or indel.
+ *
+ * Clones of the same size are taken in V:CDR3:J order, where the perl
+ * hash order was arbitrary.
+ */
+
+#define CLONE_LQ     10     // quality below which a base is masked
+#define CLONE_LQFRAC 0.7    // reads with this fraction of low quality bases are discarded
+#define CLONE_MINPAR 100    // minimal size of a parent clone
+#define CLONE_BLOCK  8      // length of the blocks of the neighbour index
+
+class CloneEngine_t
+{
+private:
+	int threads_m;
+	std::unordered_map<std::string, double> clone_m;    // V:CDR3:J of the core clones and their sizes
+	std::unordered_map<std::string, size_t> lqid_m;     // read ID of each entry of lq_m
+	std::vector<LowQual_t> lq_m;
+	std::vector<Clone_t> clones_m;                      // clones by size after rescue
+
+	void sortClones();
+
+public:
+	CloneEngine_t(const int threads = 1) {
+		threads_m = threads;
+	}
+
+	// a .cdr3 line
+	void add(const std::string &line);
+	void load(const std::string &cdr3_path);
+
+	void rescue();
+	void cluster();
+
+	// clones without a parent, by size
+	void rows(std::vector<CloneRow_t> &rows) const;
+	void print(std::ostream &out) const;
+
+	const std::vector<Clone_t> &clones() const {
+		return clones_m;
+	}
+};
+
+#endif /* clone.hpp */
@@ -0,0 +1,199 @@
+#include "clonestat.hpp"
+#include "vdjreader.hpp"
+#include "gzstream.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+
+#define STAT_BLOCK 65536   // clone.txt lines counted at a time
+
+// a count as perl prints a number
+static std::string num(const double x) {
+	char s[64];
+	snprintf(s, sizeof(s), "%.15g", x);
+	return s;
+}
+
+// percentage with 4 decimals
+static std::string pct(const double x, const double total) {
+	char s[64];
+	snprintf(s, sizeof(s), "%.4f", x / total * 100);
+	return s;
+}
+
+//=================================================CloneCount_t===
+
+void CloneCount_t::merge(CloneCount_t &c) {
+	count += c.count;
+	for (size_t i = 0; i < vn.size(); i++)
+		vn[i] += c.vn[i];
+	for (size_t i = 0; i < jn.size(); i++)
+		jn[i] += c.jn[i];
+	for (size_t i = 0; i < vjn.size(); i++)
+		vjn[i] += c.vjn[i];
+	for (const auto &a : c.aan)
+		aan[a.first] += a.second;
+	for (const auto &n : c.nln)
+		nln[n.first] += n.second;
+	cn.insert(cn.end(), std::make_move_iterator(c.cn.begin()), std::make_move_iterator(c.cn.end()));
+	c.cn.clear();
+}
+
+//==================================================CloneStat_t===
+
+void CloneStat_t::genes(const std::string &vdj_path) {
+	VDJReader_t vr;
+	for (const auto &g : vr.getGeneNames(vdj_path)) {
+		const char c = g.size() > 3 ? g[3] : '\0';
+		if (c == 'V') {
+			vid_m.emplace(g, v_m.size());
+			v_m.push_back(g);
+		} else if (c == 'J' && g.find('P') == std::string::npos) {
+			jid_m.emplace(g, j_m.size());
+			j_m.push_back(g);
+		}
+	}
+	all_m.vn.assign(v_m.size(), 0);
+	all_m.jn.assign(j_m.size(), 0);
+	all_m.vjn.assign(v_m.size() * j_m.size(), 0);
+}
+
+void CloneStat_t::count(const CloneRow_t &r, CloneCount_t &c) const {
+	// skip a stop codon or a partial one
+	if (r.aa.find_first_of("*|_") != std::string::npos)
+		return;
+
+	c.count += r.count;
+	auto v = vid_m.find(r.v), j = jid_m.find(r.j);
+	if (v != vid_m.end())
+		c.vn[v->second] += r.count;
+	if (j != jid_m.end())
+		c.jn[j->second] += r.count;
+	if (v != vid_m.end() && j != jid_m.end())
+		c.vjn[v->second * j_m.size() + j->second] += r.count;
+	c.aan[r.aa] += r.count;
+	c.nln[r.nt.size()] += r.count;
+	c.cn.emplace_back(r.v + ":" + r.nt + ":" + r.j, r.count);
+}
+
+void CloneStat_t::countAll(const std::vector<CloneRow_t> &rows) {
+	// a slice of the rows per thread, merged in order
+	const int nt = std::max(1, std::min(threads_m, (int)(rows.size() / 1024) + 1));
+	std::vector<CloneCount_t> part(nt);
+	std::vector<std::thread> workers;
+	const size_t step = (rows.size() + nt - 1) / nt;
+	for (int t = 0; t < nt; t++) {
+		part[t].vn.assign(v_m.size(), 0);
+		part[t].jn.assign(j_m.size(), 0);
+		part[t].vjn.assign(v_m.size() * j_m.size(), 0);
+		workers.emplace_back([&, t]() {
+			for (size_t i = t * step; i < std::min(rows.size(), (t + 1) * step); i++)
+				count(rows[i], part[t]);
+		});
+	}
+	for (int t = 0; t < nt; t++) {
+		workers[t].join();
+		all_m.merge(part[t]);
+	}
+}
+
+void CloneStat_t::add(const std::vector<CloneRow_t> &rows) {
+	countAll(rows);
+}
+
+void CloneStat_t::load(const std::string &clone_path) {
+	GzInStream_t in;
+	in.open(clone_path);
+	if (!in.good()) {
+		std::cerr << "\033[31mERROR:\033[0m Could not parse clone file, " << clone_path << std::endl;
+		exit(1);
+	}
+
+	// count, freq, cdr3nt, cdr3aa, v, d and j of each clone after the title
+	std::string line;
+	std::getline(in, line);
+	std::vector<CloneRow_t> rows;
+	while (true) {
+		const bool more = (bool)std::getline(in, line);
+		if (more) {
+			CloneRow_t r;
+			std::string f[7];
+			size_t b = 0;
+			for (int k = 0; k < 7 && b <= line.size(); k++) {
+				const size_t e = std::min(line.find('\t', b), line.size());
+				f[k] = line.substr(b, e - b);
+				b = e + 1;
+			}
+			r.count = atof(f[0].c_str());
+			r.nt = f[2];
+			r.aa = f[3];
+			r.v = f[4];
+			r.d = f[5];
+			r.j = f[6];
+			rows.push_back(std::move(r));
+		}
+		if (rows.size() == STAT_BLOCK || (!more && !rows.empty())) {
+			countAll(rows);
+			rows.clear();
+		}
+		if (!more)
+			break;
+	}
+}
+
+void CloneStat_t::write(const std::string &prefix) const {
+	const char *ext[7] = {"vnpc", "jnpc", "vjpc", "nlpc", "cnpc", "vjnpc", "aanpc"};
+	std::ofstream out[7];
+	for (int k = 0; k < 7; k++) {
+		out[k].open(prefix + "." + ext[k]);
+		if (!out[k].good()) {
+			std::cerr << "\033[31mERROR:\033[0m Could not write clone statistics, " << prefix << "." << ext[k] << std::endl;
+			exit(1);
+		}
+	}
+	const CloneCount_t &c = all_m;
+	if (!c.count)
+		return;
+
+	// vnpc, jnpc
+	for (size_t i = 0; i < v_m.size(); i++)
+		out[0] << v_m[i] << "\t" << num(c.vn[i]) << "\t" << pct(c.vn[i], c.count) << "\n";
+	for (size_t i = 0; i < j_m.size(); i++)
+		out[1] << j_m[i] << "\t" << num(c.jn[i]) << "\t" << pct(c.jn[i], c.count) << "\n";
+
+	// nlpc, cnpc
+	for (const auto &n : c.nln)
+		out[3] << n.first << "\t" << num(n.second) << "\t" << pct(n.second, c.count) << "\n";
+	for (const auto &n : c.cn)
+		out[4] << n.first << "\t" << num(n.second) << "\t" << pct(n.second, c.count) << "\n";
+
+	// vjpc (a V per row, a J per column), vjnpc
+	out[2] << "V\\J\t";
+	for (size_t j = 0; j < j_m.size(); j++)
+		out[2] << (j ? "\t" : "") << j_m[j];
+	out[2] << "\n";
+	for (size_t v = 0; v < v_m.size(); v++) {
+		out[2] << v_m[v];
+		for (size_t j = 0; j < j_m.size(); j++) {
+			const double n = c.vjn[v * j_m.size() + j];
+			out[2] << "\t" << pct(n, c.count);
+			out[5] << v_m[v] << ":" << j_m[j] << "\t" << num(n) << "\t" << pct(n, c.count) << "\n";
+		}
+		out[2] << "\n";
+	}
+
+	// aanpc
+	std::vector<std::pair<std::string, double>> aa(c.aan.begin(), c.aan.end());
+	std::sort(aa.begin(), aa.end(), [](const std::pair<std::string, double> &a, const std::pair<std::string, double> &b) {
+		return a.second != b.second ? a.second > b.second : a.first < b.first;
+	});
+	for (const auto &a : aa)
+		out[6] << a.first << "\t" << num(a.second) << "\t" << pct(a.second, c.count) << "\n";
+}
@@ -0,0 +1,75 @@
+#ifndef CLONESTAT_HPP
+#define CLONESTAT_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include "clone.hpp"
+
+/*
+  usage:
+  CloneStat_t cs(threads);
+  cs.genes("hsa_trb.vdj");       // V and J genes listed in the tables
+  cs.load("clone.txt");          // or cs.add(rows) from CloneEngine_t::rows
+  cs.write("clone");             // clone.vnpc, .jnpc, .vjpc, .nlpc, .cnpc, .vjnpc and .aanpc
+*/
+
+//=================================================CloneCount_t===
+
+// counts of the in-frame clones of a part of the records
+struct CloneCount_t {
+	double count;                                   // all reads
+	std::vector<double> vn;                         // reads of each listed V
+	std::vector<double> jn;                         // of each listed J
+	std::vector<double> vjn;                        // of each V (row) and J (column)
+	std::unordered_map<std::string, double> aan;    // of each cdr3aa
+	std::map<int, double> nln;                      // of each cdr3nt length
+	std::vector<std::pair<std::string, double>> cn; // V:cdr3nt:J of each clone in order
+
+	CloneCount_t() {
+		count = 0;
+	}
+
+	void merge(CloneCount_t &c);
+};
+
+//==================================================CloneStat_t===
+
+/* Port of CloneStat.pl. Clones whose cdr3aa has a stop codon or a partial
+ * one are skipped, and the tables give the reads and their percentage of
+ * all reads of each V, J, V:J pair, cdr3nt length, clone and cdr3aa. Genes
+ * are counted by their index in the vdj file (Vs, and Js but pseudo ones
+ * with a P in the name) in per-thread counts merged at the end. cdr3aa of
+ * the same reads are listed in alphabetical order.
+ */
+
+class CloneStat_t
+{
+private:
+	int threads_m;
+	std::vector<std::string> v_m, j_m;              // listed genes in vdj file order
+	std::unordered_map<std::string, int> vid_m;     // index of each listed V
+	std::unordered_map<std::string, int> jid_m;
+	CloneCount_t all_m;
+
+	void count(const CloneRow_t &r, CloneCount_t &c) const;
+	void countAll(const std::vector<CloneRow_t> &rows);
+
+public:
+	CloneStat_t(const int threads = 1) {
+		threads_m = threads;
+	}
+
+	void genes(const std::string &vdj_path);
+
+	// clone.txt, or its rows in memory
+	void load(const std::string &clone_path);
+	void add(const std::vector<CloneRow_t> &rows);
+
+	void write(const std::string &prefix) const;
+};
+
+#endif /* clonestat.hpp */
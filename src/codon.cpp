@@ -0,0 +1,70 @@
+#include "codon.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/* Codons are read up to the last whole codon of frame 0 (length/3*3),
+ * so a frame-1/2 codon crossing that point is cut short and becomes '*',
+ * and '_' is appended if any base is left after it.
+ */
+
+void CODON_t::translate(std::string_view seq, std::string &aa, const int str) {
+	const int len = seq.length();
+	const int l3 = len / 3 * 3;
+	aa.clear();
+	aa.reserve((len - str) / 3 + 1);
+
+	int i = str;
+	for (; i < l3; i += 3)
+		aa += i + 3 <= len ? codon(seq.data() + i) : '*';
+
+	// not a multiple of three
+	if (i < len)
+		aa += '_';
+}
+
+std::string CODON_t::translate(std::string_view seq, const int str) {
+	std::string aa;
+	translate(seq, aa, str);
+	return aa;
+}
+
+void CODON_t::translate(const std::vector<std::string> &seqs, std::vector<std::string> &aas) {
+	aas.resize(seqs.size());
+	for (size_t k = 0; k < seqs.size(); k++)
+		translate(seqs[k], aas[k], 0);
+}
+
+void CODON_t::translateFrames(std::string_view seq, std::string aa[3]) {
+	const int len = seq.length();
+	const int l3 = len / 3 * 3;
+	for (int f = 0; f < 3; f++) {
+		aa[f].clear();
+		aa[f].reserve(len / 3 + 1);
+	}
+
+	// rolling 6-bit code of the last three bases, bad counts down the bases since a non-ACGT
+	unsigned code = 0;
+	int bad = 0;
+	for (int p = 0; p < len; p++) {
+		unsigned b = BASE[(unsigned char)seq[p]];
+		code = ((code << 2) | (b & 3)) & 63;
+		bad = b & 4 ? 3 : (bad > 0 ? bad - 1 : 0);
+
+		// codon starting at i = p-2 belongs to frame i%3
+		int i = p - 2;
+		if (i >= 0 && i < l3)
+			aa[i % 3] += bad ? '*' : AA[code];
+	}
+
+	// codons cut short at the end, and trailing partial codons
+	for (int f = 0; f < 3; f++) {
+		int i = f + (int)aa[f].size() * 3;
+		for (; i < l3; i += 3)
+			aa[f] += '*';
+		if (i < len)
+			aa[f] += '_';
+	}
+}
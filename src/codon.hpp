@@ -0,0 +1,49 @@
+#ifndef CODON_HPP
+#define CODON_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+
+/*
+  usage:
+  std::string aa = CODON_t::translate(seq);          // frame 0
+  CODON_t::translate(seqs, aas);                     // a batch of sequences
+  std::string f[3]; CODON_t::translateFrames(seq, f);
+*/
+
+namespace CODON_t
+{
+	// 2-bit code of an uppercase base (A=0, C=1, G=2, T=3), 4 otherwise
+	constexpr std::array<unsigned char, 256> makeBaseCode() {
+		std::array<unsigned char, 256> b{};
+		for (int i = 0; i < 256; i++)
+			b[i] = 4;
+		b['A'] = 0; b['C'] = 1; b['G'] = 2; b['T'] = 3;
+		return b;
+	}
+	inline constexpr std::array<unsigned char, 256> BASE = makeBaseCode();
+
+	// amino acid of a codon indexed by its 6-bit code (first base in the high bits)
+	inline constexpr char AA[65] =
+		"KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF";
+
+	// amino acid of the codon at p ('*' if it contains a base other than ACGT)
+	inline char codon(const char *p) {
+		unsigned a = BASE[(unsigned char)p[0]], b = BASE[(unsigned char)p[1]], c = BASE[(unsigned char)p[2]];
+		return (a | b | c) & 4 ? '*' : AA[(a << 4) | (b << 2) | c];
+	}
+
+	// translate seq from position str (0-based), '_' marks a trailing partial codon
+	void translate(std::string_view seq, std::string &aa, const int str = 0);
+	std::string translate(std::string_view seq, const int str = 0);
+
+	// translate a batch of sequences in frame 0
+	void translate(const std::vector<std::string> &seqs, std::vector<std::string> &aas);
+
+	// translate all three frames in one pass (aa[f] equals translate(seq, f))
+	void translateFrames(std::string_view seq, std::string aa[3]);
+}
+
+#endif /* codon.hpp */
@@ -1,6 +1,7 @@
 #include "delta.hpp"
 #include "fastx_read.hpp"
 #include "vdjreader.hpp"
+#include "score.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -10,322 +11,296 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <numeric>
+#include <climits>
 
 // IGH constant region MEGAD issue to be solved
 // IGK distal orientation issue to be solved
-std::map<char, int> GGO = { {'V', 0}, {'J', 1}, {'D', 2}, {'C', 3}, {'I', 4} };
-std::map<std::string, int> GEO = { {"V0", 0}, {"V1", 1}, {"V2", 2}, {"D0", 3}, {"J0", 4},
-	{"C1", 5}, {"C2", 6}, {"C3", 7}, {"C4", 8}};
+// order of a gene (V, J, D, C, I), 0 if not listed
+static int getGGO(const char g) {
+	switch (g) {
+		case 'J': return 1;
+		case 'D': return 2;
+		case 'C': return 3;
+		case 'I': return 4;
+		default:  return 0;
+	}
+}
 
-// initialization static member
-std::unordered_map< std::string, std::string > DeltaFilter_t::refseq_m;
-std::unordered_map< std::string, std::vector<VDJInfo_t> > DeltaFilter_t::VDJInfo_m;
+// order of an exon (V0, V1, V2, D0, J0, C1, C2, C3, C4), 0 if not listed
+static int getGEO(const int ge) {
+	switch (ge) {
+		case GE('V', '1'): return 1;
+		case GE('V', '2'): return 2;
+		case GE('D', '0'): return 3;
+		case GE('J', '0'): return 4;
+		case GE('C', '1'): return 5;
+		case GE('C', '2'): return 6;
+		case GE('C', '3'): return 7;
+		case GE('C', '4'): return 8;
+		default:           return 0;
+	}
+}
 
+// initialization static member
+RefStore_t DeltaFilter_t::refseq_m;
+SymbolTable_t DeltaFilter_t::symbols_m;
 
-//====================================================DeltaAlignment_t===
+//====================================================DeltaReader_t===
 
-int DeltaAlignment_t::overlapQ(const DeltaAlignment_t &b) {
-	int ol = this->osQ < b.osQ ? this->oeQ - b.osQ + 1 : b.oeQ - this->osQ + 1;
-	int q = ol > b.alQ * 0.5 ? 1 : 0;
-	return q;
-}
+void DeltaReader_t::open(const std::string &delta_path) {
+	delta_path_m = delta_path;
 
-std::string DeltaAlignment_t::concise_form() const {
-	std::string cf = this->idR + ":" + this->vdje + ":";
-	cf += std::to_string(this->sR) + "-" + std::to_string(this->eR) + ":";
-	cf += std::to_string(this->sQ) + "-" + std::to_string(this->eQ) + ":";
-	cf += std::to_string(this->mmgp) + ":";
-	cf += std::to_string(this->deltas[0]);
-	for (auto i = this->deltas.begin()+1; i != this->deltas.end(); i++) {
-		cf += "," + std::to_string(*i);
+	// open delta file, stdin, or named pipe
+	if (delta_path_m == "-") {
+		delta_stream_m = &std::cin;
+	} else {
+		delta_file_m.open(delta_path_m);
+		delta_stream_m = &delta_file_m;
 	}
-	return cf;
+	CheckStream();
+
+	// read file header
+	*delta_stream_m >> reference_path_m;
+	*delta_stream_m >> query_path_m;
+	*delta_stream_m >> data_type_m;
+	is_open_m = true;
+
+	while(delta_stream_m->peek() != '>')
+		if (delta_stream_m->get() == EOF)
+			break;
 }
 
-std::vector<std::string> DeltaAlignment_t::getEndAlignment(const int &n, bool rev) {
-	std::vector<std::string> aseg;
-
-	// starting loci
-	int ri = 0;
-	int qi = 0;
-	int gi = 0;
-	int gs = 0;
-	if (n < 0) {
-		int qs = this->alQ + n;
-		while (qi < qs) {
-			int g = this->deltas[gi];
-			int d = qs - qi;
-			if (g > 0) {
-				if (d < g-1) {
-					ri += d;
-					qi += d;
-					gs = d;
-				} else {
-					ri += g;
-					qi += g-1;
-					gi += 1;
-				}
-			} else if (g == 0) {
-				ri += d;
-				qi += d;
-				gs = d;
-			} else {
-				g = -g;
-				if (d < g) {
-					ri += d;
-					qi += d;
-					gs = d;
-				} else {
-					ri += g-1;
-					qi += g;
-					gi += 1;
-				}
-			}
-		}
-	}
+bool DeltaReader_t::readNextRecord(const bool read_deltas) {
 
-	// get aligned segment on reference and query
-	std::string raseg;
-	std::string qaseg;
-
-	// if no gap
-	if (this->deltas[gi] == 0) {
-		raseg = this->rseg.substr(ri, n);
-		qaseg = this->qseg.substr(qi, n);
-		if (rev == true) {
-			raseg = FASTA_t::revcom(raseg);
-			qaseg = FASTA_t::revcom(qaseg);
-		}
-		aseg.push_back(raseg);
-		aseg.push_back(qaseg);
-		return aseg;
-	}
+	// EOF or or any other abnormality
+	if(delta_stream_m->peek() != '>')
+		return false;
 
-	// if there is a gap
-	int d = abs(n);   // distance to desired length
-	while (d > 0) {
-		int g = this->deltas[gi];
-		if (g > 0) {
-			g -= gs;
-			if (d < g) {
-				raseg += this->rseg.substr(ri, d);
-				qaseg += this->qseg.substr(qi, d);
-				d = 0;
-			} else {
-				raseg += this->rseg.substr(ri, g);
-				qaseg += this->qseg.substr(qi, g-1) + '_';
-				d -= g-1;
-				ri += g;
-				qi += g-1;
-				gi += 1;
-				gs = 0;
-			}
-		} else if (g == 0) {
-			raseg += this->rseg.substr(ri, d);
-			qaseg += this->qseg.substr(qi, d);
-			d = 0;
-		} else {
-			g = -g - gs;
-			if (d < g) {
-				raseg += this->rseg.substr(ri, d);
-				qaseg += this->qseg.substr(qi, d);
-				d = 0;
-			} else {
-				raseg += this->rseg.substr(ri, g-1) + '_';
-				qaseg += this->qseg.substr(qi, g);
-				d -= g;
-				ri += g-1;
-				qi += g;
-				gi += 1;
-				gs = 0;
-			}
-		}
-	}
+	// make way for the new record
+	record_m.clear();
+	is_record_m = true;
+
+	// read the record header
+	delta_stream_m->get();             // remove '>'
+	*delta_stream_m >> record_m.idR;
+	*delta_stream_m >> record_m.idQ;
+	*delta_stream_m >> record_m.lenR;
+	*delta_stream_m >> record_m.lenQ;
 
-	if (rev == true) {
-		raseg = FASTA_t::revcom(raseg);
-		qaseg = FASTA_t::revcom(qaseg);
+	// flush the remaining whitespace
+	while(delta_stream_m->get () != '\n');
+
+	// for each alignment...
+	DeltaAlignment_t align;
+	while(delta_stream_m->peek () != '>' && delta_stream_m->peek () != EOF) {
+		readNextAlignment(align, read_deltas);
+		align.idR = record_m.idR;
+		record_m.aligns.push_back(align);
 	}
-	aseg.push_back(raseg);
-	aseg.push_back(qaseg);
-	return aseg;
+
+	return true;
 }
 
-void DeltaAlignment_t::cutEndAlignment(const int &n) {
-	if (n == 0)
-		return;
+bool DeltaReader_t::readNextQuery(DeltaRecord_t &query, const bool read_deltas) {
 
-	// get end alignment, count mismatch and gap, and update
-	int cutoffmmgp = 0;
-	std::vector<std::string> cutoffseq = getEndAlignment(n, false);
-	for (size_t i = 0; i < cutoffseq[0].size(); i++) {
-		if ( (char)std::toupper(cutoffseq[0][i]) != (char)cutoffseq[1][i] ) cutoffmmgp++;
-	}
-	this->mmgp -= cutoffmmgp;
-
-	// move to the desired cut point
-	int d = n > 0 ? n : this->alQ + n;   // distance to the desired cut point
-	int ri = 0;
-	int qi = 0;
-	int gi = 0;
-	int gs = 0;
-	std::vector<int> newdeltas;
-
-	while (d > 0) {
-		int g = this->deltas[gi];
-		if (g > 0) {
-			if (d < g-1) {
-				ri += d;
-				qi += d;
-				gs = d;
-				d = 0;
-			} else {
-				ri += g;
-				qi += g-1;
-				gi += 1;
-				newdeltas.push_back(g);
-				d -= g-1;
-			}
-		} else if (g == 0) {
-			ri += d;
-			qi += d;
-			d = 0;
-		} else {
-			g = -g;
-			if (d < g) {
-				ri += d;
-				qi += d;
-				gs = d;
-				d = 0;
-			} else {
-				ri += g-1;
-				qi += g;
-				gi += 1;
-				newdeltas.push_back(-g);
-				d -= g;
-			}
-		}
+	// the first record is the lookahead, if any
+	if (!is_record_m && !readNextRecord(read_deltas))
+		return false;
+	std::swap(query, record_m);
+	is_record_m = false;
+
+	// merge records of the same query (and different references)
+	while (readNextRecord(read_deltas)) {
+		if (record_m.idQ != query.idQ)
+			return true;
+		query.combine_rec(std::move(record_m));
+		is_record_m = false;
 	}
+	return true;
+}
 
-	// cut from head
-	if (n > 0) {
-		this->sR   += ri;
-		this->alQ  -= n;
-		this->rseg  = this->rseg.substr(ri);
-		this->qseg  = this->qseg.substr(qi);
-		if (this->deltas[gi] == 0) {
-			newdeltas = {0};
-		} else {
-			newdeltas = {};
-			int g = this->deltas[gi];
-			g = g > 0 ? g - gs : g + gs;
-			newdeltas.push_back(g);
-			for (int i = gi+1; i < this->deltas.size(); i++) {
-				newdeltas.push_back(this->deltas[i]);
-			}
-		}
-		this->deltas = newdeltas;
-		if (this->ro == '+') {
-			this->sQ  += qi;
-			this->osQ += qi;
-		} else {
-			this->sQ  -= qi;
-			this->oeQ -= qi;
-		}
+void DeltaReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_deltas) {
+	int delta;      // indel pos
+	int gapT = 0;   // total gaps
+	int gapQ = 0;   // query gaps
 
-		// cut from tail
-	} else {
-		int rl = (this->eR - this->sR + 1) - ri;
-		int ql = this->alQ - qi;
-		this->eR   -= rl;
-		this->alQ  += n;
-		this->rseg  = this->rseg.substr(0, ri);
-		this->qseg  = this->qseg.substr(0, qi);
-		newdeltas.push_back(0);
-		this->deltas = newdeltas;
-		if (this->ro == '+') {
-			this->eQ  -= ql;
-			this->oeQ -= ql;
-		} else {
-			this->eQ  += ql;
-			this->osQ += ql;
+	// make way for the new alignment
+	align.clear();
+
+	// read the alignment header
+	*delta_stream_m >> align.sR;
+	*delta_stream_m >> align.eR;
+	*delta_stream_m >> align.sQ;
+	*delta_stream_m >> align.eQ;
+	*delta_stream_m >> align.mmgp;
+	*delta_stream_m >> align.simc;
+	*delta_stream_m >> align.stpc;
+
+	align.ro = align.sQ < align.eQ ? '+' : '-';
+	align.go = align.ro;
+	align.osQ = align.sQ < align.eQ ? align.sQ : align.eQ;
+	align.oeQ = align.sQ < align.eQ ? align.eQ : align.sQ;
+	align.alQ = align.oeQ - align.osQ + 1;
+
+	// get gap info
+	do {
+		*delta_stream_m >> delta;
+		if (delta > 0) {
+			gapQ++;
+			gapT++;
 		}
-	}
+		if (delta < 0)
+			gapT++;
+		if (read_deltas)
+			align.deltas.push_back(delta);
+	} while(delta != 0);
+
+	int mismatch = align.mmgp - gapT;
+	int match    = align.alQ + gapQ - align.mmgp;
+	align.id     = match / (float)(align.alQ + gapQ);
+	align.sc     = match * MSC + mismatch * MMSC + gapT * GSC;
 
-	// Note that simc, stpc, gcQ, sc, and id are not modified.
-	// But these will not be used afterward.
+	// flush the remaining whitespace
+	while(delta_stream_m->get () != '\n');
 }
 
-//====================================================DeltaReader_t===
+//=================================================DeltaMapReader_t===
 
-void DeltaReader_t::open(const std::string &delta_path) {
+static inline const char *skipSpace(const char *p, const char *end) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+		p++;
+	return p;
+}
+
+// parse a (signed) integer in place
+static inline const char *parseInt(const char *p, const char *end, int &v) {
+	p = skipSpace(p, end);
+	bool neg = false;
+	if (p < end && *p == '-') {
+		neg = true;
+		p++;
+	}
+	int x = 0;
+	while (p < end && (unsigned)(*p - '0') < 10) {
+		x = x * 10 + (*p - '0');
+		p++;
+	}
+	v = neg ? -x : x;
+	return p;
+}
+
+// parse a whitespace-delimited word in place
+static inline const char *parseWord(const char *p, const char *end, std::string_view &w) {
+	p = skipSpace(p, end);
+	const char *s = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+		p++;
+	w = std::string_view(s, p - s);
+	return p;
+}
+
+void DeltaMapReader_t::open(const std::string &delta_path) {
 	delta_path_m = delta_path;
 
-	// open delta file
-	delta_stream_m.open(delta_path_m);
-	CheckStream();
+	// map delta file
+	CheckMap(map_m.open(delta_path_m));
+	is_open_m = true;
 
 	// read file header
-	delta_stream_m >> reference_path_m;
-	delta_stream_m >> query_path_m;
-	delta_stream_m >> data_type_m;
-	is_open_m = true;
+	const char *end = map_m.end();
+	std::string_view w;
+	pos_m = parseWord(map_m.data(), end, w);
+	reference_path_m = std::string(w);
+	pos_m = parseWord(pos_m, end, w);
+	query_path_m = std::string(w);
+	pos_m = parseWord(pos_m, end, w);
+	data_type_m = std::string(w);
+
+	// move to the first record
+	while (pos_m < end && *pos_m != '>')
+		pos_m++;
+}
 
-	while(delta_stream_m.peek() != '>')
-		if (delta_stream_m.get() == EOF)
-			break;
+void DeltaMapReader_t::close() {
+	map_m.close();
+	pos_m = NULL;
+	delta_path_m.erase();
+	reference_path_m.erase();
+	query_path_m.erase();
+	data_type_m.erase();
+	idR_m = idQ_m = std::string_view();
+	record_m.clear();
+	is_open_m = false;
+	is_record_m = false;
 }
 
-bool DeltaReader_t::readNextRecord(const bool read_deltas) {
+bool DeltaMapReader_t::readNextRecord(const bool read_deltas) {
+	const char *end = map_m.end();
 
 	// EOF or or any other abnormality
-	if(delta_stream_m.peek() != '>')
+	if (pos_m == NULL || pos_m >= end || *pos_m != '>')
 		return false;
 
-	// get previous record_m position
-	prepos_m = delta_stream_m.tellg();
-
 	// make way for the new record
 	record_m.clear();
 	is_record_m = true;
 
 	// read the record header
-	delta_stream_m.get();             // remove '>'
-	delta_stream_m >> record_m.idR;
-	delta_stream_m >> record_m.idQ;
-	delta_stream_m >> record_m.lenR;
-	delta_stream_m >> record_m.lenQ;
+	pos_m++;   // remove '>'
+	pos_m = parseWord(pos_m, end, idR_m);
+	pos_m = parseWord(pos_m, end, idQ_m);
+	pos_m = parseInt(pos_m, end, record_m.lenR);
+	pos_m = parseInt(pos_m, end, record_m.lenQ);
+	record_m.idR.assign(idR_m.data(), idR_m.size());
+	record_m.idQ.assign(idQ_m.data(), idQ_m.size());
 
 	// flush the remaining whitespace
-	while(delta_stream_m.get () != '\n');
+	pos_m = findNewline(pos_m, end) + 1;
 
-	// for each alignment...
-	DeltaAlignment_t align;
-	while(delta_stream_m.peek () != '>' && delta_stream_m.peek () != EOF) {
+	// for each alignment, fill in place
+	while (pos_m < end && *pos_m != '>') {
+		record_m.aligns.emplace_back();
+		DeltaAlignment_t &align = record_m.aligns.back();
 		readNextAlignment(align, read_deltas);
 		align.idR = record_m.idR;
-		record_m.aligns.push_back(align);
 	}
 
 	return true;
 }
 
-void DeltaReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_deltas) {
+bool DeltaMapReader_t::readNextQuery(DeltaRecord_t &query, const bool read_deltas) {
+
+	// the first record is the lookahead, if any
+	if (!is_record_m && !readNextRecord(read_deltas))
+		return false;
+	std::swap(query, record_m);
+	is_record_m = false;
+
+	// merge records of the same query (and different references)
+	while (readNextRecord(read_deltas)) {
+		if (record_m.idQ != query.idQ)
+			return true;
+		query.combine_rec(std::move(record_m));
+		is_record_m = false;
+	}
+	return true;
+}
+
+void DeltaMapReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_deltas) {
+	const char *end = map_m.end();
 	int delta;      // indel pos
 	int gapT = 0;   // total gaps
 	int gapQ = 0;   // query gaps
 
-	// make way for the new alignment
-	align.clear();
-
 	// read the alignment header
-	delta_stream_m >> align.sR;
-	delta_stream_m >> align.eR;
-	delta_stream_m >> align.sQ;
-	delta_stream_m >> align.eQ;
-	delta_stream_m >> align.mmgp;
-	delta_stream_m >> align.simc;
-	delta_stream_m >> align.stpc;
+	pos_m = parseInt(pos_m, end, align.sR);
+	pos_m = parseInt(pos_m, end, align.eR);
+	pos_m = parseInt(pos_m, end, align.sQ);
+	pos_m = parseInt(pos_m, end, align.eQ);
+	pos_m = parseInt(pos_m, end, align.mmgp);
+	pos_m = parseInt(pos_m, end, align.simc);
+	pos_m = parseInt(pos_m, end, align.stpc);
 
 	align.ro = align.sQ < align.eQ ? '+' : '-';
 	align.go = align.ro;
@@ -335,7 +310,7 @@ void DeltaReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_d
 
 	// get gap info
 	do {
-		delta_stream_m >> delta;
+		pos_m = parseInt(pos_m, end, delta);
 		if (delta > 0) {
 			gapQ++;
 			gapT++;
@@ -344,7 +319,7 @@ void DeltaReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_d
 			gapT++;
 		if (read_deltas)
 			align.deltas.push_back(delta);
-	} while(delta != 0);
+	} while(delta != 0 && pos_m < end);
 
 	int mismatch = align.mmgp - gapT;
 	int match    = align.alQ + gapQ - align.mmgp;
@@ -352,357 +327,386 @@ void DeltaReader_t::readNextAlignment(DeltaAlignment_t &align, const bool read_d
 	align.sc     = match * MSC + mismatch * MMSC + gapT * GSC;
 
 	// flush the remaining whitespace
-	while(delta_stream_m.get () != '\n');
+	pos_m = findNewline(pos_m, end) + 1;
 }
 
 //====================================================DeltaFilter_t===
 
-// comparing function for sorting alignments by score and identity
+// comparing function for sorting alignments (rows) by score and identity
 struct aligns_SC_Cmp_t {
-	bool operator() (const DeltaAlignment_t &i, const DeltaAlignment_t &j) const {
-		if (i.sc > j.sc)
+	const AlignTable_t &t;
+	aligns_SC_Cmp_t(const AlignTable_t &tab) : t(tab) {}
+
+	bool operator() (const int i, const int j) const {
+		if (t.sc[i] > t.sc[j])
 			return true;
-		else if (i.sc < j.sc)
+		else if (t.sc[i] < t.sc[j])
 			return false;
-		else if (i.id > j.id)
+		else if (t.id[i] > t.id[j])
 			return true;
 		else
 			return false;
 	}
 };
 
-void DeltaFilter_t::getOptimalSet() {
-	std::sort(rec_m.aligns.begin(), rec_m.aligns.end(), aligns_SC_Cmp_t());
-	std::vector<DeltaAlignment_t> oaln;
+/* A winner a removes b if a.overlapQ(b), i.e., 2*ol > b.alQ where ol is
+ * a.oeQ-b.osQ+1 if a starts before b and b.oeQ-a.osQ+1 otherwise. So it is
+ * enough to know the largest oeQ of winners starting before b, and the
+ * smallest osQ of winners starting at or after b.
+ */
+
+// winners of getOptimalSet in two Fenwick trees over the rank of osQ
+class OverlapSweep_t
+{
+private:
+	const AlignTable_t &t_m;
+	std::pmr::vector<int> os_m;      // distinct osQ of all alignments
+	std::pmr::vector<int> maxoe_m;   // max oeQ of winners, prefix over ranks
+	std::pmr::vector<int> minos_m;   // min osQ of winners, prefix over reversed ranks
+
+	int rank(const int osQ) const {
+		return std::lower_bound(os_m.begin(), os_m.end(), osQ) - os_m.begin();
+	}
 
-	while(!rec_m.aligns.empty()) {
+public:
+	OverlapSweep_t(const AlignTable_t &t, const std::pmr::vector<int> &rows, std::pmr::memory_resource *mr)
+		: t_m(t), os_m(mr), maxoe_m(mr), minos_m(mr) {
+		for (const int r : rows)
+			os_m.push_back(t.osQ[r]);
+		std::sort(os_m.begin(), os_m.end());
+		os_m.erase(std::unique(os_m.begin(), os_m.end()), os_m.end());
+		maxoe_m.assign(os_m.size()+1, INT_MIN);
+		minos_m.assign(os_m.size()+1, INT_MAX);
+	}
 
-		// get current best alignment
-		std::vector<DeltaAlignment_t> cba = {rec_m.aligns[0]};
-		rec_m.aligns.erase(rec_m.aligns.begin());
+	void insert(const int a) {
+		const int u = os_m.size();
+		const int r = rank(t_m.osQ[a]);
+		for (int i = r+1; i <= u; i += i & -i)
+			maxoe_m[i] = std::max(maxoe_m[i], t_m.oeQ[a]);
+		for (int i = u-r; i <= u; i += i & -i)
+			minos_m[i] = std::min(minos_m[i], t_m.osQ[a]);
+	}
 
-		while(!rec_m.aligns.empty() && rec_m.aligns[0].sc == cba.back().sc && rec_m.aligns[0].id == cba.back().id) {
-			cba.push_back(rec_m.aligns[0]);
-			rec_m.aligns.erase(rec_m.aligns.begin());
-		}
-		oaln.insert(oaln.end(), cba.begin(), cba.end());
-
-		// filter alignment that overlaps the current best alignment
-		for (auto a : cba) {
-			std::vector<DeltaAlignment_t> aln_tmp;
-			for (auto b : rec_m.aligns) {
-				if (a.overlapQ(b) == 0)
-					aln_tmp.push_back(b); 
-			}
-			rec_m.aligns.assign(aln_tmp.begin(), aln_tmp.end());
+	// true if a winner overlaps b (i.e., overlapQ(a, b) == 1)
+	bool suppressed(const int b) const {
+		const int u = os_m.size();
+		const int r = rank(t_m.osQ[b]);
+
+		// winners starting before b
+		int oe = INT_MIN;
+		for (int i = r; i > 0; i -= i & -i)
+			oe = std::max(oe, maxoe_m[i]);
+		if (oe != INT_MIN && 2 * (oe - t_m.osQ[b] + 1) > t_m.alQ[b])
+			return true;
+
+		// winners starting at or after b
+		int os = INT_MAX;
+		for (int i = u-r; i > 0; i -= i & -i)
+			os = std::min(os, minos_m[i]);
+		return os != INT_MAX && 2 * (t_m.oeQ[b] - os + 1) > t_m.alQ[b];
+	}
+};
+
+void DeltaFilter_t::getOptimalSet() {
+	const int n = aln_m.size();
+
+	// sort rows (same permutation as sorting the alignments)
+	std::pmr::vector<int> order(aln_m, mr_m);
+	std::sort(order.begin(), order.end(), aligns_SC_Cmp_t(tab_m));
+
+	// take alignments of the same score and identity together as the current best,
+	// unless overlapped by a previous best
+	OverlapSweep_t sweep(tab_m, order, mr_m);
+	aln_m.clear();
+	for (int s = 0, e = 0; s < n; s = e) {
+		const int f = order[s];
+		while (e < n && tab_m.sc[order[e]] == tab_m.sc[f] && tab_m.id[order[e]] == tab_m.id[f])
+			e++;
+
+		const size_t w = aln_m.size();
+		for (int k = s; k < e; k++) {
+			if (!sweep.suppressed(order[k]))
+				aln_m.push_back(order[k]);
 		}
+		for (size_t k = w; k < aln_m.size(); k++)
+			sweep.insert(aln_m[k]);
 	}
-	rec_m.aligns.assign(oaln.begin(), oaln.end());
 }
 
 void DeltaFilter_t::annotateVDJ() {
-	for(auto i = rec_m.aligns.begin(); i != rec_m.aligns.end(); i++) {
+	const int I0 = GE('I', '0');
+
+	// contig of each reference ID
+	std::pmr::vector<int> ctgs(mr_m);
+	for (auto &n : tab_m.refs) {
+		ctgs.push_back(symbols_m.contigID(n));
+		if (ctgs.back() < 0) {
+			std::cerr << "\033[31mERROR:\033[0m Reference contig not found in vdj file, "
+				<< n << std::endl;
+			exit(1);
+		}
+	}
 
-		const std::string ref = i->idR;
-		const int rs = i->sR;          // alignment range start
-		const int re = i->eR;          // alignment range end
-		int si = 0;                    // start of info
-		int ei = VDJInfo_m[ref].size()-1;   // end of info
-		std::string annot;
-		std::string annot_exon;
+	for (const int i : aln_m) {
+		const ContigSym_t &ctg = symbols_m.contig(ctgs[tab_m.ref[i]]);
+		const int rs = tab_m.sR[i];    // alignment range start
+		const int re = tab_m.eR[i];    // alignment range end
+		int si = ctg.first;            // start of info
+		int ei = ctg.last-1;           // end of info
+		int e0 = -1;                   // first exon of the annotation
 
 		// range start is after start of the last vdj
-		if (rs > VDJInfo_m[ref][ei].exon_start) {
-			i->vdj = rs > VDJInfo_m[ref][ei].exon_end ? VDJInfo_m[ref][ei].gene + "I" : VDJInfo_m[ref][ei].vdj;
-			i->vdje = rs > VDJInfo_m[ref][ei].exon_end ? VDJInfo_m[ref][ei].gene + "I_0" : VDJInfo_m[ref][ei].vdj_exon;
-			i->ge = "I0";
+		if (rs > symbols_m.exon(ei).start) {
+			tab_m.ex0[i] = tab_m.ex1[i] = rs > symbols_m.exon(ei).end ? ctg.inter : ei;
+			tab_m.ge[i] = I0;
 			continue;
 		}
 
 		// locate the range start
 		int mid = (si+ei) / 2;
 		while (mid != si) {
-			rs < VDJInfo_m[ref][mid].exon_start ? ei = mid : si = mid;
+			rs < symbols_m.exon(mid).start ? ei = mid : si = mid;
 			mid = (si+ei) / 2;
 		}
 
 		// get vdj exon from the starting location
-		if (rs <= VDJInfo_m[ref][si].exon_end) {
-			annot = VDJInfo_m[ref][si].vdj;
-			annot_exon = VDJInfo_m[ref][si].vdj_exon;
-		}
+		if (rs <= symbols_m.exon(si).end)
+			e0 = si;
 		while(++si) {
-			if (si > VDJInfo_m[ref].size()-1 || re < VDJInfo_m[ref][si].exon_start)
+			if (si > ctg.last-1 || re < symbols_m.exon(si).start)
 				break;
-			if (!annot_exon.empty()) {
-				annot += "~";
-				annot_exon += "~";
-			}
-			annot += VDJInfo_m[ref][si].vdj;
-			annot_exon += VDJInfo_m[ref][si].vdj_exon;
+			if (e0 == -1)
+				e0 = si;
 		}
-		if (annot_exon.empty()) {
-			i->vdj = VDJInfo_m[ref][si].gene + "I";
-			i->vdje = VDJInfo_m[ref][si].gene + "I_0";
-			i->ge = "I0";
+		if (e0 == -1) {
+			tab_m.ex0[i] = tab_m.ex1[i] = ctg.inter;
+			tab_m.ge[i] = I0;
 			continue;
 		}
-		i->vdj = annot;
-		i->vdje = annot_exon;
-		i->ge = std::string(1, annot[3]) + annot_exon[annot_exon.length()-1];
-		if (annot == "TRBV30") {
-			i->go = i->ro == '+' ? '-' : '+';
+		tab_m.ex0[i] = e0;
+		tab_m.ex1[i] = si-1;
+		tab_m.ge[i] = GE(geneOf(i).cls, symbols_m.exon(si-1).num);
+		if (symbols_m.isGene(e0, si-1, symbols_m.trbv30)) {
+			tab_m.go[i] = tab_m.ro[i] == '+' ? '-' : '+';
 		}
 	}
 }
 
 void DeltaFilter_t::groupAlignment() {
-	std::vector<DeltaAlignment_t> galn;
+	std::pmr::vector<int> galn(mr_m);
 
 	// sort along the query
-	std::sort(rec_m.aligns.begin(), rec_m.aligns.end(),
-			[](DeltaAlignment_t a, DeltaAlignment_t b){ return a.osQ < b.osQ; });
+	std::sort(aln_m.begin(), aln_m.end(),
+			[this](const int a, const int b){ return tab_m.osQ[a] < tab_m.osQ[b]; });
 
 	// filter short (<30 bp) intergenic alignment
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if (rec_m.aligns[i].ge == "I0" && rec_m.aligns[i].alQ < 30) {
-			rec_m.aligns.erase(rec_m.aligns.begin()+i);
-			i--;
-		}
-	}
+	aln_m.erase(std::remove_if(aln_m.begin(), aln_m.end(),
+				[this](const int a){ return tab_m.ge[a] == GE('I', '0') && tab_m.alQ[a] < 30; }),
+			aln_m.end());
 
-	while(!rec_m.aligns.empty()) {
+	std::pmr::vector<int> ga(mr_m);
+	for (size_t k = 0; k < aln_m.size(); ) {
 
 		// initialize grouped alignment
-		std::vector<DeltaAlignment_t> ga = {rec_m.aligns[0]};
-		rec_m.aligns.erase(rec_m.aligns.begin());
+		ga.assign(1, aln_m[k++]);
 
 		// find overlapping alignment and put it in a group
-		while(!rec_m.aligns.empty() && ga[0].overlapQ(rec_m.aligns[0]) == 1) {
-			ga.push_back(rec_m.aligns[0]);
-			rec_m.aligns.erase(rec_m.aligns.begin());
-		}
+		while(k < aln_m.size() && tab_m.overlapQ(ga[0], aln_m[k]) == 1)
+			ga.push_back(aln_m[k++]);
 
 		// find representative alignment of a group
 		if (ga.size() > 1) {
 			std::sort(ga.begin(), ga.end(),
-					[](DeltaAlignment_t a, DeltaAlignment_t b){ return GGO[a.vdj[3]] < GGO[b.vdj[3]]; });
+					[this](const int a, const int b){ return getGGO(geneOf(a).cls) < getGGO(geneOf(b).cls); });
 		}
-		DeltaAlignment_t ra = ga[0];
-		ra.gm.assign(ga.begin()+1, ga.end());
-		galn.push_back(ra);
+		tab_m.setMembers(ga[0], ga.begin()+1, ga.end());
+		galn.push_back(ga[0]);
 	}
 
-	rec_m.aligns.assign(galn.begin(), galn.end());
+	aln_m.swap(galn);
 }
 
 void DeltaFilter_t::filterAlignment() {
 
 	// exit if no alignment remains
-	if (rec_m.aligns.size() == 0)
+	if (aln_m.size() == 0)
 		return;
 
-	// count alignments of each V, D, or J
-	std::map<std::string, int> VDJ_c;
-	for (auto ra : rec_m.aligns) {
-		VDJ_c[ra.vdj]++;
-		for (auto m : ra.gm)
-			VDJ_c[m.vdj]++;
+	// count alignments of each V, D, or J, by the gene IDs of their spans packed in a key
+	std::pmr::string key(mr_m);
+	auto geneKey = [this, &key](const int a) -> const std::pmr::string & {
+		key.clear();
+		for (int e = tab_m.ex0[a]; e <= tab_m.ex1[a]; e++) {
+			const int g = symbols_m.exon(e).gene;
+			key.append((const char *)&g, sizeof(g));
+		}
+		return key;
+	};
+	std::pmr::unordered_map<std::pmr::string, int> spans(mr_m);
+	for (const int r : aln_m) {
+		spans[geneKey(r)]++;
+		for (const int *m = tab_m.gmBegin(r); m != tab_m.gmEnd(r); m++)
+			spans[geneKey(*m)]++;
 	}
+	auto VDJ_c = [&spans, &geneKey](const int a) {
+		return spans.find(geneKey(a))->second;
+	};
 
 	// filter ambiguous alignment in a group
-	for (auto i = rec_m.aligns.begin(); i != rec_m.aligns.end(); i++) {
+	for (auto i = aln_m.begin(); i != aln_m.end(); i++) {
 
 		// skip if no ambiguity
-		if (i->gm.size() == 0)
+		if (tab_m.gmSize(*i) == 0)
 			continue;
 
 		// if V or C ambiguity
-		if (i->vdj[3] == 'V' || i->vdj[3] == 'C') {
+		const GeneSym_t &ig = geneOf(*i);
+		if (ig.cls == 'V' || ig.cls == 'C') {
 
 			// keep only V or C alignments in the group
-			std::vector<DeltaAlignment_t> va = {*i};
-			for (auto m : i->gm) {
-				if (m.vdj[3] == 'V' || m.vdj[3] == 'C') 
-					va.push_back(m);
+			std::pmr::vector<int> va({*i}, mr_m);
+			for (const int *m = tab_m.gmBegin(*i); m != tab_m.gmEnd(*i); m++) {
+				if (geneOf(*m).cls == 'V' || geneOf(*m).cls == 'C')
+					va.push_back(*m);
 			}
 			if (va.size() == 1) {
 				*i = va[0];
-				i->gm.assign(va.begin()+1, va.end());
+				tab_m.setMembers(*i, va.begin()+1, va.end());
 				continue;
 			}
 
 			// find V or C alignment with more counts
+			std::pmr::vector<int> vn(mr_m);
 			int maxn = 0;
-			for (auto m : va) {
-				if (VDJ_c[m.vdj] > maxn)
-					maxn = VDJ_c[m.vdj];
+			for (const int m : va) {
+				vn.push_back(VDJ_c(m));
+				if (vn.back() > maxn)
+					maxn = vn.back();
 			}
-			std::vector<DeltaAlignment_t> tva = {};
-			for (auto a : va) {
-				if (VDJ_c[a.vdj] == maxn) 
-					tva.push_back(a);
+			std::pmr::vector<int> tva(mr_m);
+			for (size_t k = 0; k < va.size(); k++) {
+				if (vn[k] == maxn)
+					tva.push_back(va[k]);
 			}
 
 			// reset the grouped alignment if the ambiguity can be resolved
-			if (tva.size() > 0 && tva.size() < i->gm.size()+1) {
+			if (tva.size() > 0 && (int)tva.size() < tab_m.gmSize(*i)+1) {
 				*i = tva[0];
-				i->gm.assign(tva.begin()+1, tva.end());
+				tab_m.setMembers(*i, tva.begin()+1, tva.end());
 			}
 
-		} else if ((i->vdj[2] == 'B' || i->vdj[2] == 'G') && i->vdj[3] == 'C') {   // if TRB/G C ambiguity   
+		} else if ((ig.chain == 'B' || ig.chain == 'G') && ig.cls == 'C') {   // if TRB/G C ambiguity
 
 			// filter the C1 if J2-C1|C2
-			std::vector<DeltaAlignment_t> tca = {};
-			if ((i->ro == '+' && i > rec_m.aligns.begin() && (i-1)->vdj[3] == 'J' && (i-1)->vdj[4] == '2') ||
-					(i->ro == '-' && i < rec_m.aligns.end()-1 && (i+1)->vdj[3] == 'J' && (i+1)->vdj[4] == '2')) {
-				if (i->vdj[4] == '2')
+			std::pmr::vector<int> tca(mr_m);
+			if ((tab_m.ro[*i] == '+' && i > aln_m.begin() && geneOf(*(i-1)).cls == 'J' && geneOf(*(i-1)).sub == '2') ||
+					(tab_m.ro[*i] == '-' && i < aln_m.end()-1 && geneOf(*(i+1)).cls == 'J' && geneOf(*(i+1)).sub == '2')) {
+				if (ig.sub == '2')
 					tca.push_back(*i);
-				for (auto a : i->gm) {
-					if (a.vdj[4] == '2') 
-						tca.push_back(a);
+				for (const int *a = tab_m.gmBegin(*i); a != tab_m.gmEnd(*i); a++) {
+					if (geneOf(*a).sub == '2')
+						tca.push_back(*a);
 				}
 			}
 			if (tca.size() == 1) {
 				*i = tca[0];
-				i->gm.assign(tca.begin()+1, tca.end());
+				tab_m.setMembers(*i, tca.begin()+1, tca.end());
 			}
 
-		} else if (i->vdj[2] == 'L' && i->vdj[3] == 'C') {   // if IGL C ambiguity
+		} else if (ig.chain == 'L' && ig.cls == 'C') {   // if IGL C ambiguity
 			// 12367
 		}
 	}
 
 	// filter alignment of potential CDR3 segment
 	int pcdr3i = -1;
-	for (auto i = rec_m.aligns.begin()+1; i < rec_m.aligns.end()-1; i++) {
+	for (auto i = aln_m.begin()+1; i < aln_m.end()-1; i++) {
+		const int a = *(i-1), b = *i, c = *(i+1);
 
 		// skip if the alignment is good
-		if (i->ge == "D0")
+		if (tab_m.ge[b] == GE('D', '0'))
 			continue;
-		if (i->alQ >= 60)
+		if (tab_m.alQ[b] >= 60)
 			continue;
-		if (i->alQ >= 30 && i->id > 0.9)
+		if (tab_m.alQ[b] >= 30 && tab_m.id[b] > 0.9)
 			continue;
 
 		// if flanked by V2 and J0 and not broken V or J
-		if ( ((i-1)->ge == "V2" && (i+1)->ge == "J0" &&
-					i->vdje != (i-1)->vdje && i->vdje != (i+1)->vdje) ||
-				((i-1)->ge == "J0" && (i+1)->ge == "V2" &&
-				 i->vdje != (i+1)->vdje && i->vdje != (i-1)->vdje) ) { 
-			pcdr3i = i - rec_m.aligns.begin();
+		const bool newb = !symbols_m.sameExons(tab_m.ex0[b], tab_m.ex1[b], tab_m.ex0[a], tab_m.ex1[a]) &&
+			!symbols_m.sameExons(tab_m.ex0[b], tab_m.ex1[b], tab_m.ex0[c], tab_m.ex1[c]);
+		if ( (tab_m.ge[a] == GE('V', '2') && tab_m.ge[c] == GE('J', '0') && newb) ||
+				(tab_m.ge[a] == GE('J', '0') && tab_m.ge[c] == GE('V', '2') && newb) ) {
+			pcdr3i = i - aln_m.begin();
 		}
 	}
 
 	// reset alignment if a potential CDR3 is found
 	if (pcdr3i != -1) {
-		rec_m.aligns.erase(rec_m.aligns.begin() + pcdr3i);
+		aln_m.erase(aln_m.begin() + pcdr3i);
 	}
 }
 
-int DeltaFilter_t::maxScorePosition(std::vector<std::string> &adjseq1, std::vector<std::string> &adjseq2,
-		std::string &rfk1, std::string &rfk2) {
-	std::vector<int> sps1;
-	std::vector<int> sps2;
+int DeltaFilter_t::maxScorePosition(std::string_view r1, std::string_view q1, std::string_view r2, std::string_view q2,
+		std::string_view rfk1, std::string_view rfk2) {
+	const int n1 = r1.size();
+	const int n2 = r2.size();
+
+	// score of each column
+	std::pmr::vector<int8_t> cs1(n1, mr_m);
+	std::pmr::vector<int8_t> cs2(n2, mr_m);
+	SCORE_t::columnScores(r1.data(), q1.data(), n1, cs1.data());
+	SCORE_t::columnScores(r2.data(), q2.data(), n2, cs2.data());
+
+	// splicing bonus 1 (GT after the cut) and 2 (AG before the cut), 0 without flanking bases
+	std::pmr::vector<int8_t> sps1(n1+1, 0, mr_m);
+	std::pmr::vector<int8_t> sps2(n2+1, 0, mr_m);
 	bool spq = (rfk1.size() == 2 && rfk2.size() == 2);
 	if (spq) {
-		// get splicing bonus 1
-		std::string rseg1 = adjseq1[0] + rfk1;
-		std::transform(rseg1.begin(), rseg1.end(), rseg1.begin(), ::toupper);
-		for (size_t i = 0; i < rseg1.size()-1; i++) {
-			if (rseg1[i] == 'G' && rseg1[i+1] == 'T') {
-				sps1.push_back(SPC);
-			} else {
-				sps1.push_back(0);
-			}
-		}
-		// get splicing bonus 2
-		std::string rseg2 = rfk2 + adjseq2[0];
-		std::transform(rseg2.begin(), rseg2.end(), rseg2.begin(), ::toupper);
-		for (size_t i = 2; i < rseg2.size()+1; i++) {
-			if (rseg2[i-2] == 'A' && rseg2[i-1] == 'G') {
-				sps2.push_back(SPC);
-			} else {
-				sps2.push_back(0);
-			}
-		}
+		std::pmr::string rseg1(r1, mr_m);
+		rseg1 += rfk1;
+		SCORE_t::spliceBonus(rseg1.data(), rseg1.size(), 'G', 'T', sps1.data());
+		std::pmr::string rseg2(rfk2, mr_m);
+		rseg2 += r2;
+		SCORE_t::spliceBonus(rseg2.data(), rseg2.size(), 'A', 'G', sps2.data());
 	}
 
-	// calculate score of alignment 1
-	std::vector<int> qps1;
-	int cs1 = 0;
-	int ri1 = -1;
-	if (spq) {
-		qps1.push_back(sps1[ri1+1]);
-	} else {
-		qps1.push_back(0);
-	}
-	for (size_t i = 0; i < adjseq1[0].size(); i++) {
-		if (adjseq1[0][i] != '_')
-			ri1 += 1;
-		if (adjseq1[1][i] != '_') {
-			if (adjseq1[0][i] != '_') {
-				if (adjseq1[0][i] == adjseq1[1][i]) {
-					cs1 += MSC + EXB;
-				} else if (adjseq1[0][i]-32 == adjseq1[1][i]) {
-					cs1 += MSC;
-				} else {
-					cs1 += MMSC;
-				}
-			} else {
-				cs1 += GSC;
-			}
-			if (spq) {
-				qps1.push_back(cs1 + sps1[ri1+1]);
-			} else {
-				qps1.push_back(cs1);
-			}
-		} else {
-			cs1 += GSC;
+	// without gaps, the score of a cut at k is the prefix sum of the column score
+	// differences plus both bonuses at k
+	auto gapless = [](std::string_view s) { return s.find('_') == std::string_view::npos; };
+	if (n1 == n2 && gapless(r1) && gapless(q1) && gapless(r2) && gapless(q2)) {
+		for (int i = 0; i < n1; i++) {
+			cs1[i] -= cs2[i];
+			sps1[i] += sps2[i];
 		}
+		sps1[n1] += sps2[n1];
+		return SCORE_t::maxPrefixPosition(cs1.data(), sps1.data(), n1);
 	}
 
-	// calculate score of alignment 2
-	std::vector<int> qps2;
-	int cs2 = 0;
-	int ri2 = -1;
-	if (spq) {
-		qps2.push_back(-sps2[ri2+1]);
-	} else {
-		qps2.push_back(0);
-	}
-	for (size_t i = 0; i < adjseq2[0].size(); i++) {
-		if (adjseq2[0][i] != '_')
-			ri2 += 1;
-		if (adjseq2[1][i] != '_') {
-			if (adjseq2[0][i] != '_') {
-				if (adjseq2[0][i] == adjseq2[1][i]) {
-					cs2 += MSC + EXB;
-				} else if (adjseq2[0][i]-32 == adjseq2[1][i]) {
-					cs2 += MSC;
-				} else {
-					cs2 += MMSC;
-				}
-			} else {
-				cs2 += GSC;
-			}
-			if (spq) {
-				qps2.push_back(cs2 - sps2[ri2+1]);
-			} else {
-				qps2.push_back(cs2);
-			}
-		} else {
-			cs2 += GSC;
+	// otherwise, score each cut along the query (bonus by the position on the reference)
+	auto prefixScores = [this](std::string_view r, std::string_view q, const int8_t *cs,
+			const int8_t *sps, const int sign) {
+		std::pmr::vector<int> qps(mr_m);
+		int s = 0;
+		int ri = -1;
+		qps.push_back(sign * sps[0]);
+		for (size_t i = 0; i < r.size(); i++) {
+			if (r[i] != '_')
+				ri += 1;
+			s += cs[i];
+			if (q[i] != '_')
+				qps.push_back(s + sign * sps[ri+1]);
 		}
-	}
+		return qps;
+	};
+	std::pmr::vector<int> qps = prefixScores(r1, q1, cs1.data(), sps1.data(), 1);
+	std::pmr::vector<int> qps2 = prefixScores(r2, q2, cs2.data(), sps2.data(), -1);
 
 	// combine two scores
-	std::vector<int> qps;
-	for (size_t i = 0; i < qps1.size(); i++) {
-		qps.push_back(qps1[i] - qps2[i]);
+	for (size_t i = 0; i < qps.size(); i++) {
+		qps[i] -= qps2[i];
 	}
 
-
 	// find the max score, if same score choose the left one
 	return std::distance(qps.begin(), std::max_element(qps.begin(), qps.end()));
 }
@@ -710,123 +714,122 @@ int DeltaFilter_t::maxScorePosition(std::vector<std::string> &adjseq1, std::vect
 void DeltaFilter_t::adjustOverlap() {
 
 	// if no alignment remains
-	if (rec_m.aligns.size() == 0)
+	if (aln_m.size() == 0)
 		return;
 
 	// update vi di ji
 	//update_VDJ_index();
 
+	// aligned end segments of a pair, on the reference and the query
+	std::pmr::string ra1(mr_m), qa1(mr_m);
+	std::pmr::string ra2(mr_m), qa2(mr_m);
+	auto getEnd = [this](const int r, const int n, const bool rev, std::pmr::string &ra, std::pmr::string &qa) {
+		tab_m.getEndAlignment(r, n, rev, refseq_m, qryseq_m, ra, qa);
+	};
+	auto cutEnd = [this](const int r, const int n) {
+		tab_m.cutEndAlignment(r, n, refseq_m, qryseq_m);
+	};
+
 	// check overlap for each pair of neighboring alignments
-	for (auto i = rec_m.aligns.begin()+1; i < rec_m.aligns.end(); i++) {
+	for (auto i = aln_m.begin()+1; i < aln_m.end(); i++) {
+		const int a = *(i-1), b = *i;
 
 		// skip if more than one group member
-		if ((i-1)->gm.size() > 0 || i->gm.size() > 0)
+		if (tab_m.gmSize(a) > 0 || tab_m.gmSize(b) > 0)
 			continue;
 
 		// skip if no overlap
-		int ol = (i-1)->oeQ - i->osQ +1;
+		int ol = tab_m.oeQ[a] - tab_m.osQ[b] +1;
 		if (ol <= 0)
 			continue;
 
 		// label (i-1) to be removed if it is enclosed in i after being cut
-		if (((i-1)->osQ + (i-1)->oeQ) >= 2 * i->osQ) {
-			(i-1)->tbf = true;
+		if ((tab_m.osQ[a] + tab_m.oeQ[a]) >= 2 * tab_m.osQ[b]) {
+			tab_m.tbf[a] = true;
 			continue;
 		}
 
 		// skip if the aligned segment is at the beginning of the reference 
-		if ((i-1)->sR == 1 || i->sR == 1)
+		if (tab_m.sR[a] == 1 || tab_m.sR[b] == 1)
 			continue;
 
-		// load reference and query segments
-		if ((i-1)->rseg.length()==0) {
-			(i-1)->rseg = FASTA_t::subseq(refseq_m[(i-1)->idR], (i-1)->sR, (i-1)->eR);
-			(i-1)->rlfk = FASTA_t::subseq(refseq_m[(i-1)->idR], (i-1)->sR-2, (i-1)->sR-1);
-			(i-1)->rrfk = FASTA_t::subseq(refseq_m[(i-1)->idR], (i-1)->eR+1, (i-1)->eR+2);
-			(i-1)->qseg = FASTA_t::subseq(qryseq_m, (i-1)->osQ, (i-1)->oeQ);
-			if ((i-1)->ro == '-')
-				(i-1)->qseg = FASTA_t::revcom((i-1)->qseg);
+		// load flanking bases of the reference segments (kept from the first load of a row)
+		for (const int r : {a, b}) {
+			if (r == a && tab_m.fkq[a])
+				continue;
+			const std::string &idR = tab_m.refs[tab_m.ref[r]];
+			refseq_m.subseq(idR, tab_m.sR[r]-2, tab_m.sR[r]-1, tab_m.rlfk[r]);
+			refseq_m.subseq(idR, tab_m.eR[r]+1, tab_m.eR[r]+2, tab_m.rrfk[r]);
+			tab_m.fkq[r] = 1;
 		}
-		i->rseg = FASTA_t::subseq(refseq_m[i->idR], i->sR, i->eR);
-		i->rlfk = FASTA_t::subseq(refseq_m[i->idR], i->sR-2, i->sR-1);
-		i->rrfk = FASTA_t::subseq(refseq_m[i->idR], i->eR+1, i->eR+2);
-		i->qseg = FASTA_t::subseq(qryseq_m, i->osQ, i->oeQ);
-		if (i->ro == '-')
-			i->qseg = FASTA_t::revcom(i->qseg);
-
-
-		// get aligned segments
-		std::vector<std::string> adjseq1;
-		std::vector<std::string> adjseq2;
 
 		// along reference
-		if ((i-1)->ro == i->ro) {
-			if (i->ro == '+') {
-				adjseq1 = (i-1)->getEndAlignment(-ol, false);
-				adjseq2 = i->getEndAlignment(ol, false);
+		if (tab_m.ro[a] == tab_m.ro[b]) {
+			if (tab_m.ro[b] == '+') {
+				getEnd(a, -ol, false, ra1, qa1);
+				getEnd(b, ol, false, ra2, qa2);
 			} else {
-				adjseq1 = i->getEndAlignment(-ol, false);
-				adjseq2 = (i-1)->getEndAlignment(ol, false);
+				getEnd(b, -ol, false, ra1, qa1);
+				getEnd(a, ol, false, ra2, qa2);
 			}
 
-			int max_pos = maxScorePosition(adjseq1, adjseq2, (i-1)->rrfk, i->rlfk);
+			int max_pos = maxScorePosition(ra1, qa1, ra2, qa2, tab_m.rrfk[a], tab_m.rlfk[b]);
 			int n1 = -(ol-max_pos);
 			int n2 = max_pos;
 
-			if (i->ro == '+') {
-				(i-1)->cutEndAlignment(n1);
-				i->cutEndAlignment(n2);
+			if (tab_m.ro[b] == '+') {
+				cutEnd(a, n1);
+				cutEnd(b, n2);
 			} else {
-				i->cutEndAlignment(n1);
-				(i-1)->cutEndAlignment(n2);
+				cutEnd(b, n1);
+				cutEnd(a, n2);
 			}
 
 			// along query
 		} else {
-			adjseq1 = (i-1)->ro == '+' ? (i-1)->getEndAlignment(-ol, false) :
-				(i-1)->getEndAlignment(ol, true);
-			adjseq2 = i->ro == '+' ? i->getEndAlignment(ol, false) :
-				i->getEndAlignment(-ol, true);
-
-			std::string rfk1 = "";
-			std::string rfk2 = "";
-			int max_pos = maxScorePosition(adjseq1, adjseq2, rfk1, rfk2);
-
-			int n1 = (i-1)->ro == '+' ? -(ol-max_pos) : (ol-max_pos);
-			(i-1)->cutEndAlignment(n1);
-			int n2 = i->ro == '+' ? max_pos : -max_pos;
-			i->cutEndAlignment(n2);
+			if (tab_m.ro[a] == '+')
+				getEnd(a, -ol, false, ra1, qa1);
+			else
+				getEnd(a, ol, true, ra1, qa1);
+			if (tab_m.ro[b] == '+')
+				getEnd(b, ol, false, ra2, qa2);
+			else
+				getEnd(b, -ol, true, ra2, qa2);
+
+			int max_pos = maxScorePosition(ra1, qa1, ra2, qa2, "", "");
+
+			int n1 = tab_m.ro[a] == '+' ? -(ol-max_pos) : (ol-max_pos);
+			cutEnd(a, n1);
+			int n2 = tab_m.ro[b] == '+' ? max_pos : -max_pos;
+			cutEnd(b, n2);
 		}
 
 	}
 
 	// filter short intergenic alignment again after adjusting overlap
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if ((rec_m.aligns[i].ge == "I0" && rec_m.aligns[i].alQ < 30) || rec_m.aligns[i].tbf == true) {
-			rec_m.aligns.erase(rec_m.aligns.begin()+i);
-			i--;
-		}
-	}
+	aln_m.erase(std::remove_if(aln_m.begin(), aln_m.end(),
+				[this](const int a){ return (tab_m.ge[a] == GE('I', '0') && tab_m.alQ[a] < 30) || tab_m.tbf[a]; }),
+			aln_m.end());
 
 }
 
 void DeltaFilter_t::setRecombCode() {
 
 	// exit if no alignment remains
-	if (rec_m.aligns.size() == 0)
+	if (aln_m.size() == 0)
 		return;
 
 	// set recombination code
 	int cn = 0;    // number of C segments
 	std::unordered_map<char, int> oc = { {'+', 0}, {'-', 0} };
 
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if (rec_m.aligns[i].vdj[3] == 'C')
+	for (const int r : aln_m) {
+		if (geneOf(r).cls == 'C')
 			cn++;
-		if (rec_m.aligns[i].vdj != "TRBV30") {
-			oc[rec_m.aligns[i].ro] += 1;
+		if (!symbols_m.isGene(tab_m.ex0[r], tab_m.ex1[r], symbols_m.trbv30)) {
+			oc[tab_m.ro[r]] += 1;
 		} else {
-			char o = rec_m.aligns[i].ro == '+' ? '-' : '+';
+			char o = tab_m.ro[r] == '+' ? '-' : '+';
 			oc[o] += 1;
 		}
 	}
@@ -843,10 +846,10 @@ void DeltaFilter_t::setRecombCode() {
 		int siq = 1;   // check increasing Q
 
 		// remove V30 from the alignment
-		std::vector<DeltaAlignment_t> nov30aln;
-		for (auto a : rec_m.aligns) {
-			if (a.vdj != "TRBV30") {
-				nov30aln.push_back(a);
+		std::pmr::vector<int> nov30aln(mr_m);
+		for (const int r : aln_m) {
+			if (!symbols_m.isGene(tab_m.ex0[r], tab_m.ex1[r], symbols_m.trbv30)) {
+				nov30aln.push_back(r);
 			}
 		}
 		if (oc['-'] > 0) {
@@ -854,10 +857,11 @@ void DeltaFilter_t::setRecombCode() {
 		}
 
 		// allow C1 to be replaced by C2
-		for (int i = 1; i < nov30aln.size(); i++) {
-			if (nov30aln[i-1].sR > nov30aln[i].sR) {
-				if (nov30aln[i].vdj == "TRBC1") {
-					if (nov30aln[i-1].sR > (nov30aln[i].sR + 9346)) {
+		for (size_t i = 1; i < nov30aln.size(); i++) {
+			const int p = nov30aln[i-1], r = nov30aln[i];
+			if (tab_m.sR[p] > tab_m.sR[r]) {
+				if (symbols_m.isGene(tab_m.ex0[r], tab_m.ex1[r], symbols_m.trbc1)) {
+					if (tab_m.sR[p] > (tab_m.sR[r] + 9346)) {
 						siq = 0;
 					}
 				}
@@ -872,7 +876,7 @@ void DeltaFilter_t::setRecombCode() {
 void DeltaFilter_t::annotateQuery() {
 
 	// exit if no alignment remains
-	if (rec_m.aligns.size() == 0)
+	if (aln_m.size() == 0)
 		return;
 
 	// get longest non-decreasing or non-increasing sub-alignments
@@ -881,15 +885,15 @@ void DeltaFilter_t::annotateQuery() {
 	// calculate fraction of aligned length
 
 	al_m = 0;
-	int qs = rec_m.aligns[0].osQ;
-	int qe = rec_m.aligns[0].oeQ;
-	for (int i = 1; i < rec_m.aligns.size(); i++) {
-		if (rec_m.aligns[i].osQ > qe) {
+	int qs = tab_m.osQ[aln_m[0]];
+	int qe = tab_m.oeQ[aln_m[0]];
+	for (size_t i = 1; i < aln_m.size(); i++) {
+		if (tab_m.osQ[aln_m[i]] > qe) {
 			al_m += (qe - qs + 1);
-			qs = rec_m.aligns[i].osQ;
-			qe = rec_m.aligns[i].oeQ;
+			qs = tab_m.osQ[aln_m[i]];
+			qe = tab_m.oeQ[aln_m[i]];
 		} else {
-			qe = rec_m.aligns[i].oeQ;
+			qe = tab_m.oeQ[aln_m[i]];
 		}
 	}
 	al_m += (qe - qs + 1);
@@ -899,7 +903,7 @@ void DeltaFilter_t::annotateQuery() {
 
 	// orient alignments in the order of VDJ
 	if (ori_m == '-') {
-		std::reverse(rec_m.aligns.begin(), rec_m.aligns.end());
+		std::reverse(aln_m.begin(), aln_m.end());
 	}
 
 	// get index of V, D, and J alignments
@@ -909,42 +913,40 @@ void DeltaFilter_t::annotateQuery() {
 	//int cn = 0;    // number of C segments
 	//int soq = 1;   // same orientation Q
 
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if (rec_m.aligns[i].ge == "V0" || rec_m.aligns[i].ge == "V2") {
+	for (int i = 0; i < (int)aln_m.size(); i++) {
+		const int ge = tab_m.ge[aln_m[i]];
+		if (ge == GE('V', '0') || ge == GE('V', '2')) {
 			vi = i;
-		} else if (rec_m.aligns[i].ge == "D0" && (vi != -1 || di == -1)) {
+		} else if (ge == GE('D', '0') && (vi != -1 || di == -1)) {
 			di = i;
-		} else if (rec_m.aligns[i].ge == "J0" && (vi != -1 || di != -1 || ji == -1)) {
+		} else if (ge == GE('J', '0') && (vi != -1 || di != -1 || ji == -1)) {
 			ji = i;
 		}
 	}
 
 	// set idR
 	if (ji != -1) {
-		rec_m.idR = rec_m.aligns[ji].idR;
+		rec_m.idR = tab_m.refs[tab_m.ref[aln_m[ji]]];
 	} else if (vi != -1) {
-		rec_m.idR = rec_m.aligns[vi].idR;
+		rec_m.idR = tab_m.refs[tab_m.ref[aln_m[vi]]];
 	}
 
 	// set regularity
 	std::string combv = "---";
 	std::string combd = "---";
 	std::string combj = "---";
-	if (vi != -1) {
-		combv = rec_m.aligns[vi].vdj;
-		for (auto m = rec_m.aligns[vi].gm.begin(); m != rec_m.aligns[vi].gm.end(); m++)
-			combv += "|" + m->vdj;
-	}
-	if (di != -1) {
-		combd = rec_m.aligns[di].vdj;
-		for (auto m = rec_m.aligns[di].gm.begin(); m != rec_m.aligns[di].gm.end(); m++)
-			combd += "|" + m->vdj;
-	}
-	if (ji != -1) {
-		combj = rec_m.aligns[ji].vdj;
-		for (auto m = rec_m.aligns[ji].gm.begin(); m != rec_m.aligns[ji].gm.end(); m++)
-			combj += "|" + m->vdj;
-	}
+	auto combine = [this](const int r) {
+		std::string c = symbols_m.vdjName(tab_m.ex0[r], tab_m.ex1[r]);
+		for (const int *m = tab_m.gmBegin(r); m != tab_m.gmEnd(r); m++)
+			c += "|" + symbols_m.vdjName(tab_m.ex0[*m], tab_m.ex1[*m]);
+		return c;
+	};
+	if (vi != -1)
+		combv = combine(aln_m[vi]);
+	if (di != -1)
+		combd = combine(aln_m[di]);
+	if (ji != -1)
+		combj = combine(aln_m[ji]);
 	if (vi != -1 && ji != -1) {
 		if ((ji - vi) == 1 || ((ji-vi) == 2 && di == (vi+ji)/2)) {
 			reg_m = 1;
@@ -952,14 +954,16 @@ void DeltaFilter_t::annotateQuery() {
 			if (vi > 1) {
 				vq = 0;
 			} else if (vi == 1) {
-				if (rec_m.aligns[0].ge != "V1" || rec_m.aligns[0].vdj != rec_m.aligns[1].vdj)
+				const int a = aln_m[0], b = aln_m[1];
+				if (tab_m.ge[a] != GE('V', '1') ||
+						!symbols_m.sameGenes(tab_m.ex0[a], tab_m.ex1[a], tab_m.ex0[b], tab_m.ex1[b]))
 					vq = 0;
 			}
 			int cq = 1;
-			if (ji < rec_m.aligns.size()-2) {
+			if (ji < (int)aln_m.size()-2) {
 				cq = 0;
-			} else if (ji == rec_m.aligns.size()-2) {
-				if (rec_m.aligns[ji+1].ge != "C1")
+			} else if (ji == (int)aln_m.size()-2) {
+				if (tab_m.ge[aln_m[ji+1]] != GE('C', '1'))
 					cq = 0;
 			}
 			if (vq == 1 && cq == 1)
@@ -978,83 +982,101 @@ void DeltaFilter_t::annotateQuery() {
 	CombineVDJ_m = combv + ":" + combd + ":" + combj;
 }
 
-void DeltaFilter_t::LNDIS() {
-	int lndsl[rec_m.aligns.size()]  = {0};
-	int lnisl[rec_m.aligns.size()]  = {0};
-	int ndfrom[rec_m.aligns.size()] = {0};
-	int nifrom[rec_m.aligns.size()] = {0};
-
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		lndsl[i] = rec_m.aligns[i].alQ;
-		lnisl[i] = rec_m.aligns[i].alQ;
-		ndfrom[i] = -1;
-		nifrom[i] = -1;
-	}
-
+//====================================================GeneChain===
+
+/* The chain before an alignment i of rank g is the longest one ending at
+ * an earlier alignment of rank <= g (non-decreasing) or >= g
+ * (non-increasing). There are only GEO_RANKS ranks, so keeping the longest
+ * chain ending in each rank (the first one on ties, as scanning j = 0..i-1
+ * with '>') gives the same chains as the O(n^2) scan in O(n*GEO_RANKS).
+ */
+
+int GeneChain(const int *rank, const int *len, const int n, const bool up, std::pmr::vector<int> &chain) {
+	std::pmr::memory_resource *mr = chain.get_allocator().resource();
+	std::pmr::vector<int> cl(n, mr);
+	std::pmr::vector<int> from(n, -1, mr);
+
+	// longest chain ending in each rank, and where it ends (-1 if none)
+	int rl[GEO_RANKS], ri[GEO_RANKS];
+	std::fill(rl, rl + GEO_RANKS, 0);
+	std::fill(ri, ri + GEO_RANKS, -1);
+
+	for (int i = 0; i < n; i++) {
+		cl[i] = len[i];
+		const int g = rank[i];
+		if (g < 0)
+			continue;
 
-	for (int i = 1; i < rec_m.aligns.size(); i++) {
-		for (int j = 0; j < i; j++) {
-			if (rec_m.aligns[j].ge != "I0" && rec_m.aligns[i].ge != "I0" &&
-					GEO[rec_m.aligns[j].ge] <= GEO[rec_m.aligns[i].ge] &&
-					(lndsl[j] + rec_m.aligns[i].alQ) > lndsl[i]) {
-				lndsl[i] = lndsl[j] + rec_m.aligns[i].alQ;
-				ndfrom[i] = j;
-			}
-			if (rec_m.aligns[j].ge != "I0" && rec_m.aligns[i].ge != "I0" &&
-					GEO[rec_m.aligns[j].ge] >= GEO[rec_m.aligns[i].ge] &&
-					(lnisl[j] + rec_m.aligns[i].alQ) > lnisl[i]) {
-				lnisl[i] = lnisl[j] + rec_m.aligns[i].alQ;
-				nifrom[i] = j;
+		// best of the ranks at or below (at or above) g, the first alignment on ties
+		int l = 0, j = -1;
+		for (int h = up ? 0 : g; h <= (up ? g : GEO_RANKS-1); h++) {
+			if (ri[h] != -1 && (j == -1 || rl[h] > l || (rl[h] == l && ri[h] < j))) {
+				l = rl[h];
+				j = ri[h];
 			}
 		}
+		if (j != -1 && l + len[i] > cl[i]) {
+			cl[i] = l + len[i];
+			from[i] = j;
+		}
+		if (ri[g] == -1 || cl[i] > rl[g]) {
+			rl[g] = cl[i];
+			ri[g] = i;
+		}
 	}
 
-
-	int ndmaxl = 0;
-	int nimaxl = 0;
-	int ndmaxi = -1;
-	int nimaxi = -1;
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if (lndsl[i] >= ndmaxl) {
-			ndmaxl = lndsl[i];
-			ndmaxi = i;
-		}
-		if (lnisl[i] >= nimaxl) {
-			nimaxl = lnisl[i];
-			nimaxi = i;
+	// the last of the longest chains
+	int maxl = 0;
+	int maxi = -1;
+	for (int i = 0; i < n; i++) {
+		if (cl[i] >= maxl) {
+			maxl = cl[i];
+			maxi = i;
 		}
 	}
 
+	chain.clear();
+	for (int i = maxi; i != -1; i = from[i])
+		chain.push_back(i);
+	std::reverse(chain.begin(), chain.end());
+	return maxl;
+}
+
+void DeltaFilter_t::LNDIS() {
+	const int n = aln_m.size();
+	std::pmr::vector<int> rank(n, mr_m);
+	std::pmr::vector<int> len(n, mr_m);
+	for (int i = 0; i < n; i++) {
+		const int r = aln_m[i];
+		rank[i] = tab_m.ge[r] == GE('I', '0') ? -1 : getGEO(tab_m.ge[r]);   // intergenic alignments are not chained
+		len[i] = tab_m.alQ[r];
+	}
+
+	std::pmr::vector<int> nd(mr_m), ni(mr_m);
+	const int ndmaxl = GeneChain(rank.data(), len.data(), n, true, nd);
+	const int nimaxl = GeneChain(rank.data(), len.data(), n, false, ni);
+
 	if (ndmaxl >= nimaxl) {
-		int ndi = ndmaxi;
-		lndisi.insert(lndisi.begin(), ndi);
-		while (ndfrom[ndi] != -1) {
-			ndi = ndfrom[ndi];
-			lndisi.insert(lndisi.begin(), ndi);
-		}
+		lndisi.assign(nd.begin(), nd.end());
 		if (ndmaxl > nimaxl && lndisi.size() > 1) {
 			ori_m = '+';
 		} else {
-			ori_m = rec_m.aligns[ndmaxi].ro;
+			ori_m = tab_m.ro[aln_m[lndisi.back()]];
 		}
 	} else {
-		int nii = nimaxi;
-		lndisi.insert(lndisi.begin(), nii);
-		while (nifrom[nii] != -1) {
-			nii = nifrom[nii];
-			lndisi.insert(lndisi.begin(), nii);
-		}
+		lndisi.assign(ni.begin(), ni.end());
 		ori_m = '-';
 	}
 }
 
 void DeltaFilter_t::update_VDJ_index() {
-	for (int i = 0; i < rec_m.aligns.size(); i++) {
-		if (rec_m.aligns[i].ge == "V0" || rec_m.aligns[i].ge == "V2") {
+	for (int i = 0; i < (int)aln_m.size(); i++) {
+		const int ge = tab_m.ge[aln_m[i]];
+		if (ge == GE('V', '0') || ge == GE('V', '2')) {
 			vi = i;
-		} else if (rec_m.aligns[i].ge == "D0" && (vi != -1 || di == -1)) {
+		} else if (ge == GE('D', '0') && (vi != -1 || di == -1)) {
 			di = i;
-		} else if (rec_m.aligns[i].ge == "J0" && (vi != -1 || di != -1 || ji == -1)) {
+		} else if (ge == GE('J', '0') && (vi != -1 || di != -1 || ji == -1)) {
 			ji = i;
 		}
 	}
@@ -1062,52 +1084,39 @@ void DeltaFilter_t::update_VDJ_index() {
 
 //=============================================
 
-void DeltaFilter_t::printResult(std::ostream &out) {
-
-	// if no alignment remains
-	if (rec_m.aligns.size() == 0)
-		return;
-
-	out << rec_m.idQ << "\t" << rec_m.lenQ;
-	out << "\t" << reg_m << "\t" << rec_m.idR << "\t" << ori_m;
-	out << "\t" << CombineVDJ_m;
-
-	out << "\t" << rec_m.aligns[0].concise_form();
-
-	for (auto m = rec_m.aligns[0].gm.begin(); m != rec_m.aligns[0].gm.end(); m++) {
-		out << "|" << m->concise_form();
+void DeltaFilter_t::getLabelSet(LabelSet_t &ls) const {
+	ls.assign(aln_m.size(), {});
+	for (size_t i = 0; i < aln_m.size(); i++) {
+		const int r = aln_m[i];
+		ls[i].resize(1 + tab_m.gmSize(r));
+		ls[i][0].load(tab_m, r);
+		for (int k = 0; k < tab_m.gmSize(r); k++)
+			ls[i][k+1].load(tab_m, tab_m.gmBegin(r)[k]);
 	}
-	for (auto i = rec_m.aligns.begin()+1; i != rec_m.aligns.end(); i++) {
-		out << " ";
-		out << i->concise_form();
-		for (auto m = i->gm.begin(); m != i->gm.end(); m++) {
-			out << "|" << m->concise_form();
-		}
-	}
-	out << "\t" << vi << "," << di << "," << ji << "\t" << al_m;
-	out << std::endl;
+}
+
+void DeltaFilter_t::printResult(std::ostream &out) {
+	out << *this;
+	if (aln_m.size() != 0)
+		out << std::endl;
 }
 
 std::ostream& operator<< (std::ostream& out, const DeltaFilter_t &df) {
+	const AlignTable_t &t = df.tab_m;
 	
 	// if no alignment remains
-	if (df.rec_m.aligns.size() == 0)
+	if (df.aln_m.size() == 0)
 		return out;
 
 	out << df.rec_m.idQ << "\t" << df.rec_m.lenQ;
 	out << "\t" << df.reg_m << "\t" << df.rec_m.idR << "\t" << df.ori_m;
 	out << "\t" << df.CombineVDJ_m;
 
-	out << "\t" << df.rec_m.aligns[0].concise_form();
-
-	for (auto m = df.rec_m.aligns[0].gm.begin(); m != df.rec_m.aligns[0].gm.end(); m++) {
-		out << "|" << m->concise_form();
-	}
-	for (auto i = df.rec_m.aligns.begin()+1; i != df.rec_m.aligns.end(); i++) {
-		out << " ";
-		out << i->concise_form();
-		for (auto m = i->gm.begin(); m != i->gm.end(); m++) {
-			out << "|" << m->concise_form();
+	for (auto i = df.aln_m.begin(); i != df.aln_m.end(); i++) {
+		out << (i == df.aln_m.begin() ? "\t" : " ");
+		out << t.concise_form(*i, DeltaFilter_t::symbols_m);
+		for (const int *m = t.gmBegin(*i); m != t.gmEnd(*i); m++) {
+			out << "|" << t.concise_form(*m, DeltaFilter_t::symbols_m);
 		}
 	}
 	out << "\t" << df.vi << "," << df.di << "," << df.ji << "\t" << df.al_m;
@@ -5,10 +5,18 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <unordered_map>
+#include <numeric>
+#include <memory_resource>
 
 #include "vdjreader.hpp"
+#include "symbols.hpp"
+#include "mapfile.hpp"
+#include "refstore.hpp"
+#include "aligntable.hpp"
+#include "label.hpp"
 
 #define MSC  3
 #define MMSC -7
@@ -41,22 +49,12 @@ struct DeltaAlignment_t {
   	int gcQ;    // count of gaps in the aligned query
 	int sc;     // score
 	float id;   // identity of alignment
-	bool tbf;   // to be filtered
 
 	// update
 	std::string idR;   // reference contig ID
 	int lenR;   // reference contig ID
-
-	std::string rseg;   // reference segment
-	std::string rlfk;   // reference left flanking bases
-	std::string rrfk;   // reference right flanking bases
-	std::string qseg;   // query segment
-	std::string vdj;    // annotated by VDJInfo_t
-	std::string vdje;   // annotated by VDJInfo_t
-	std::string ge;     // annotated by VDJInfo_t
         
 	std::vector<int> deltas;            // gap positions in delta alignment
-	std::vector<DeltaAlignment_t> gm;   // group member
 	
 	DeltaAlignment_t() {
 		clear();
@@ -69,25 +67,10 @@ struct DeltaAlignment_t {
 		go = 'o';
 		osQ = oeQ = alQ = gcQ = 0;
 		id = sc = 0;
-		tbf = false;
 
 		idR.erase();
-
-		rseg.erase();
-		rlfk.erase();
-		rrfk.erase();
-		qseg.erase();
-		vdj.erase();
 		deltas.clear();
-		gm.clear();
 	}
-
-	int overlapQ(const DeltaAlignment_t &);
-
-	std::string concise_form() const;
-
-	std::vector<std::string> getEndAlignment(const int &, bool);
-	void cutEndAlignment(const int &);
 };
 
 //=======================================================
@@ -117,30 +100,37 @@ struct DeltaRecord_t {
 		lenR = 0;
 		aligns.insert(aligns.end(), R.aligns.begin(), R.aligns.end());
 	}
+
+	void combine_rec(DeltaRecord_t &&R) {
+		idR.erase();
+		lenR = 0;
+		aligns.insert(aligns.end(), std::make_move_iterator(R.aligns.begin()),
+				std::make_move_iterator(R.aligns.end()));
+		R.aligns.clear();
+	}
 };
 
 //====================================================DeltaReader_t===
 
-// for reading a delta file (incorporated from MUMMER)
+// for reading a delta file (incorporated from MUMMER), "-" for stdin
 class DeltaReader_t
 {
 private:
 	std::string delta_path_m;     // delta input file
-	std::ifstream delta_stream_m; // delta file input stream
+	std::ifstream delta_file_m;   // delta file (or named pipe)
+	std::istream *delta_stream_m; // delta input stream
 	std::string reference_path_m; // reference file
 	std::string query_path_m;     // query file
 	std::string data_type_m;      // type of data
 	DeltaRecord_t record_m;       // current delta information record
-	bool is_record_m;             // valid record
+	bool is_record_m;             // valid record (lookahead of readNextQuery)
 	bool is_open_m;               // delta stream is open
 
-	std::streampos prepos_m;      // previous record position
-
 	bool readNextRecord (const bool read_deltas);
 	void readNextAlignment (DeltaAlignment_t & align, const bool read_deltas);
 
 	void CheckStream() {
-		if(!delta_stream_m.good()) {
+		if(!delta_stream_m->good()) {
 			std::cerr << "\033[31mERROR:\033[0m Could not parse delta file, "
 				<< delta_path_m << std::endl;
 			exit(1);
@@ -149,6 +139,7 @@ private:
 
 public:
 	DeltaReader_t() {
+		delta_stream_m = &delta_file_m;
 		is_open_m = false;
 		is_record_m = false;
 	}
@@ -160,7 +151,8 @@ public:
 	
 	void close() {
 		delta_path_m.erase();
-		delta_stream_m.close();
+		delta_file_m.close();
+		delta_stream_m = &delta_file_m;
 		reference_path_m.erase();
 		query_path_m.erase();
 		data_type_m.erase();
@@ -173,10 +165,71 @@ public:
 		return readNextRecord (getdeltas);
 	}
 
-	void seek_previous_record() {
-		delta_stream_m.seekg(prepos_m);
+	// read all records of the next query (keeping one record of lookahead)
+	bool readNextQuery (DeltaRecord_t &query, bool getdeltas = true);
+
+	const std::string &getReferencePath() const {
+		return reference_path_m;
 	}
 
+	const std::string &getQueryPath() const {
+		return query_path_m;
+	}
+
+	DeltaRecord_t &getRecord() {
+		return record_m;
+	}
+};
+
+//=================================================DeltaMapReader_t===
+
+// for reading a delta file through a read-only memory map (no stream, no seek)
+class DeltaMapReader_t
+{
+private:
+	std::string delta_path_m;     // delta input file
+	MappedFile_t map_m;           // mapped delta file
+	const char *pos_m;            // current parsing position
+	std::string reference_path_m; // reference file
+	std::string query_path_m;     // query file
+	std::string data_type_m;      // type of data
+	std::string_view idR_m;       // reference ID of the current record (in the mapping)
+	std::string_view idQ_m;       // query ID of the current record (in the mapping)
+	DeltaRecord_t record_m;       // current delta information record
+	bool is_record_m;             // valid record (lookahead of readNextQuery)
+	bool is_open_m;               // delta file is mapped
+
+	bool readNextRecord (const bool read_deltas);
+	void readNextAlignment (DeltaAlignment_t & align, const bool read_deltas);
+
+	void CheckMap(const bool good) {
+		if(!good) {
+			std::cerr << "\033[31mERROR:\033[0m Could not parse delta file, "
+				<< delta_path_m << std::endl;
+			exit(1);
+		}
+	}
+
+public:
+	DeltaMapReader_t() {
+		pos_m = NULL;
+		is_open_m = false;
+		is_record_m = false;
+	}
+	~DeltaMapReader_t() {
+		close();
+	}
+
+	void open(const std::string &delta_path);
+	void close();
+
+	bool readNext (bool getdeltas = true) {
+		return readNextRecord (getdeltas);
+	}
+
+	// read all records of the next query (keeping one record of lookahead)
+	bool readNextQuery (DeltaRecord_t &query, bool getdeltas = true);
+
 	const std::string &getReferencePath() const {
 		return reference_path_m;
 	}
@@ -185,46 +238,71 @@ public:
 		return query_path_m;
 	}
 
+	const std::string_view &getIDR() const {
+		return idR_m;
+	}
+
+	const std::string_view &getIDQ() const {
+		return idQ_m;
+	}
+
 	DeltaRecord_t &getRecord() {
 		return record_m;
 	}
 };
 
+//========================================================GeneChain===
+
+#define GEO_RANKS 9   // gene-order ranks of an exon (V0, V1, V2, D0, J0, C1, C2, C3, C4)
+
+// longest chain of alignments 0..n-1 with non-decreasing (up) or non-increasing gene-order
+// ranks (rank -1 is not chained), weighted by len; the last of the longest, in order, into
+// chain, and its length returned (of DeltaFilter_t::LNDIS, see bench-lndis.cpp)
+int GeneChain(const int *rank, const int *len, const int n, const bool up, std::pmr::vector<int> &chain);
+
 //====================================================DeltaFilter_t===
 
 // for processing alignments of a query, i.e., kernel of TRIg
 class DeltaFilter_t
 {
 private:
-	DeltaRecord_t rec_m;
+	DeltaRecord_t rec_m;        // header of the query (idR, idQ, lenR, lenQ)
+	AlignTable_t tab_m;         // alignments of the query
+	std::pmr::vector<int> aln_m;   // rows of the remaining alignments, in order
 
 	int reg_m;                  // regularity of a query
 	char ori_m;                 // orientation of a query
 	std::string CombineVDJ_m;   // combined VDJ annotation
-	std::vector<int> lndisi;    // index of longest non-decreasing sub-alignments
+	std::pmr::vector<int> lndisi;  // index of longest non-decreasing sub-alignments
+	std::pmr::memory_resource *mr_m;   // per-query allocations (e.g., the Arena_t of a worker)
 
 	int vi, di, ji;   // index of V, D, and J gene in all alignments of a query
 
 	void LNDIS();     // get longest non-decreasing or non-increasing sub-alignments
 
 	// find maximal score position in the overlapping alignments
-	int maxScorePosition(std::vector<std::string> &adjseq1, std::vector<std::string> &adjseq2,
-			std::string &rfk1, std::string &rfk2);
+	int maxScorePosition(std::string_view r1, std::string_view q1, std::string_view r2, std::string_view q2,
+			std::string_view rfk1, std::string_view rfk2);
 
 	// update vdj_index (whenever sorting rec_m.aligns) (to be discarded)
 	void update_VDJ_index();
 
+	// first gene of the annotation of a row
+	const GeneSym_t &geneOf(const int r) const {
+		return symbols_m.firstGene(tab_m.ex0[r]);
+	}
+
 public:
 	int al_m;                                                      // alignment length
 	float alf_m;                                                   // aligned length fraction
 	std::string rc_m;                                              // recombination code
-	static std::unordered_map<std::string, std::string> refseq_m;  // load reference sequence
-	std::string qryseq_m;                                          // load query sequence by one
-	static std::unordered_map< std::string, std::vector<VDJInfo_t> > VDJInfo_m;                       // load vdj information
+	static RefStore_t refseq_m;                                    // load reference sequence (2-bit packed)
+	std::string_view qryseq_m;                                     // query sequence (owned by the caller)
+	static SymbolTable_t symbols_m;                                // contigs, genes and exons of vdj information
 
-	DeltaFilter_t(DeltaRecord_t &rec) {
-                clear();
-		rec_m = rec;
+	DeltaFilter_t(DeltaRecord_t &rec, std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+		: tab_m(mr), aln_m(mr), lndisi(mr), mr_m(mr) {
+		load(rec);
 	}
 	~DeltaFilter_t() {
 		clear();
@@ -232,6 +310,8 @@ public:
 
 	void clear() {
 		rec_m.clear();
+		tab_m.clear();
+		aln_m.clear();
 		reg_m = -1;
 		ori_m = 'o';
                 al_m = 0;
@@ -239,7 +319,19 @@ public:
                 rc_m.erase();
 		vi = di = ji = 0;
 		CombineVDJ_m.erase();
-		lndisi = {};
+		lndisi.clear();
+	}
+
+	// alignments of a query, again from getOptimalSet (e.g., after AlignPatcher_t::patch)
+	void load(DeltaRecord_t &rec) {
+		clear();
+		rec_m.idR = rec.idR;
+		rec_m.idQ = rec.idQ;
+		rec_m.lenR = rec.lenR;
+		rec_m.lenQ = rec.lenQ;
+		tab_m.load(rec);
+		aln_m.resize(tab_m.size());
+		std::iota(aln_m.begin(), aln_m.end(), 0);
 	}
 
 	// TRIg functions
@@ -256,6 +348,12 @@ public:
 	const DeltaRecord_t &getREC() const {
 		return rec_m;
 	}
+	const AlignTable_t &getTAB() const {
+		return tab_m;
+	}
+	const std::pmr::vector<int> &getALN() const {
+		return aln_m;
+	}
 	const int &getREG() const {
 		return reg_m;
 	}
@@ -274,6 +372,9 @@ public:
 	const int &getJi() const {
 		return ji;
 	}
+
+	// remaining alignments with their group members (after annotateQuery)
+	void getLabelSet(LabelSet_t &ls) const;
 };
 
 #endif /* delta.h */
@@ -1,6 +1,7 @@
 #include "delta.hpp"
 #include "fastx_read.hpp"
 #include "extractCDR3.hpp"
+#include "codon.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -11,47 +12,6 @@
 #include <unordered_map>
 #include <algorithm>
 
-// initialization static object in ExtractCDR3_t
-std::map<std::string, int> ExtractCDR3_t::cdr3p_m;
-
-//================================Translate
-const std::unordered_map<std::string, std::string> aacode = {                                                                                                                   
-    {"TTT", "F"}, {"TTC", "F"}, {"TTA", "L"}, {"TTG", "L"},
-    {"TCT", "S"}, {"TCC", "S"}, {"TCA", "S"}, {"TCG", "S"},
-    {"TAT", "Y"}, {"TAC", "Y"}, {"TAA", "*"}, {"TAG", "*"},
-    {"TGT", "C"}, {"TGC", "C"}, {"TGA", "*"}, {"TGG", "W"},
-    {"CTT", "L"}, {"CTC", "L"}, {"CTA", "L"}, {"CTG", "L"},
-    {"CCT", "P"}, {"CCC", "P"}, {"CCA", "P"}, {"CCG", "P"},
-    {"CAT", "H"}, {"CAC", "H"}, {"CAA", "Q"}, {"CAG", "Q"},
-    {"CGT", "R"}, {"CGC", "R"}, {"CGA", "R"}, {"CGG", "R"},
-    {"ATT", "I"}, {"ATC", "I"}, {"ATA", "I"}, {"ATG", "M"},
-    {"ACT", "T"}, {"ACC", "T"}, {"ACA", "T"}, {"ACG", "T"},
-    {"AAT", "N"}, {"AAC", "N"}, {"AAA", "K"}, {"AAG", "K"},
-    {"AGT", "S"}, {"AGC", "S"}, {"AGA", "R"}, {"AGG", "R"},
-    {"GTT", "V"}, {"GTC", "V"}, {"GTA", "V"}, {"GTG", "V"},
-    {"GCT", "A"}, {"GCC", "A"}, {"GCA", "A"}, {"GCG", "A"},
-    {"GAT", "D"}, {"GAC", "D"}, {"GAA", "E"}, {"GAG", "E"},
-    {"GGT", "G"}, {"GGC", "G"}, {"GGA", "G"}, {"GGG", "G"},
-};
-
-std::string Translate(const std::string seq, int str = 0) {
-    int i;
-    std::string aa; 
-    for (i = str; i < seq.length()/3*3; i += 3) {
-            if (aacode.find(seq.substr(i, 3)) == aacode.end()) {
-                    aa += "*";
-            } else {
-                    aa += aacode.at(seq.substr(i, 3));
-            }
-    }
-
-    // not a multiple of three
-    if (i < seq.size())
-        aa += "_";
-
-    return aa; 
-}
-
 //================================CDRReader_t
 
 std::map<std::string, int> CDRReader_t::getCDR3(const std::string &cdr_path) {
@@ -95,10 +55,16 @@ bool CDRReader_t::readNext(){
 }
 
 void ExtractCDR3_t::extractCDR3() {
+
+	// CDR3s to be translated in one batch, and their slots in cdr3a_m
+	std::vector<std::string> cdr3s;
+	std::vector<size_t> slot;
+	
+	const AlignTable_t &t = *tab_m;
 	
 	// for all vj pairs
-	for (auto v = valn_m.gm.begin(); v != valn_m.gm.end(); v++) {
-		for (auto j = jaln_m.gm.begin(); j != jaln_m.gm.end(); j++) {
+	for (const int v : vrows_m) {
+		for (const int j : jrows_m) {
 
 			cdr3seq_m = "---";
 			cdr3qua_m = "---";
@@ -107,68 +73,81 @@ void ExtractCDR3_t::extractCDR3() {
 			// check if the CDR3 positions on the reference are available (i.e., not pseudogene)
 			// and the positions are covered by the V and J alignments (take care of V30 on the minus strand)
 			bool cdr3q = false;
-			if (cdr3p_m.find(v->vdj) != cdr3p_m.end() && cdr3p_m.find(j->vdj) != cdr3p_m.end()) {
-				if (v->sR <= cdr3p_m.at(v->vdj) && cdr3p_m.at(v->vdj) <= v->eR &&
-						j->sR <= cdr3p_m.at(j->vdj) && cdr3p_m.at(j->vdj) <= j->eR) {
+			const int vp = DeltaFilter_t::symbols_m.cdr3(t.ex0[v], t.ex1[v]);
+			const int jp = DeltaFilter_t::symbols_m.cdr3(t.ex0[j], t.ex1[j]);
+			if (vp != -1 && jp != -1) {
+				if (t.sR[v] <= vp && vp <= t.eR[v] && t.sR[j] <= jp && jp <= t.eR[j]) {
 					cdr3q = true;
 				}
 			}
 
 			// if good, first get the CDR3 starting and ending positions on the query
 			if (cdr3q) {
-				int vqp = AlignmentRpQp(*v);
-				int jqp = AlignmentRpQp(*j);
+				int vqp = AlignmentRpQp(v);
+				int jqp = AlignmentRpQp(j);
 
 				// then get the CDR3 segment on the plus strand
-				if (j->sQ < j->eQ) {
+				if (t.sQ[j] < t.eQ[j]) {
 					cdr3seq_m = fqseq_m.substr(vqp -1, jqp - vqp +1);
 					cdr3qua_m = fqqua_m.substr(vqp -1, jqp - vqp +1);
 				} else {
-					cdr3seq_m = fqseq_m.substr(jqp -1, vqp - jqp +1);
+					FASTA_t::revcom(std::string_view(fqseq_m).substr(jqp -1, vqp - jqp +1), cdr3seq_m);
 					cdr3qua_m = fqqua_m.substr(jqp -1, vqp - jqp +1);
-					cdr3seq_m = FASTA_t::revcom(cdr3seq_m);
 					std::reverse(cdr3qua_m.begin(), cdr3qua_m.end());
 				}
 
-				// translate cdr3
-				cdr3aa_m = Translate(cdr3seq_m, 0);
+				// translate cdr3 later
+				slot.push_back(cdr3a_m.size());
+				cdr3s.emplace_back(cdr3seq_m);
 			}
 
 			// push to array
-			cdr3c_m.push_back(v->vdj + ":" + cdr3seq_m + ":" + j->vdj);
+			cdr3c_m.emplace_back(DeltaFilter_t::symbols_m.vdjName(t.ex0[v], t.ex1[v]));
+			cdr3c_m.back() += ":";
+			cdr3c_m.back() += cdr3seq_m;
+			cdr3c_m.back() += ":";
+			cdr3c_m.back() += DeltaFilter_t::symbols_m.vdjName(t.ex0[j], t.ex1[j]);
 			cdr3q_m.push_back(cdr3qua_m);
 			cdr3a_m.push_back(cdr3aa_m);
 
 		}
 	}
+
+	// translate cdr3
+	std::vector<std::string> aas;
+	CODON_t::translate(cdr3s, aas);
+	for (size_t k = 0; k < slot.size(); k++)
+		cdr3a_m[slot[k]] = std::move(aas[k]);
 }
 
-int ExtractCDR3_t::AlignmentRpQp(DeltaAlignment_t align) {
+int ExtractCDR3_t::AlignmentRpQp(const int r) {
+	const AlignTable_t &t = *tab_m;
 
-	// ro = align.ro (+/-)
-	int o = align.ro == '+' ? 1 : -1;
-	// gap = align.deltas = delta (vector<int>)
-	align.deltas.pop_back();
+	// ro = t.ro[r] (+/-)
+	int o = t.ro[r] == '+' ? 1 : -1;
+	// gap = deltas of the row without the ending 0
+	const int *dt = t.deltas(r);
+	const int nd = t.dlen[r] - 1;
 
 	// bs : block size (idea from blat)
 	// rg : reference gap
 	std::vector<int> bs;
 	std::vector<int> rg;
 
-	for (const int &d : align.deltas) {
-		if (d > 0) {
-			bs.push_back(d-1);
+	for (const int *d = dt; d != dt + nd; d++) {
+		if (*d > 0) {
+			bs.push_back(*d-1);
 			rg.push_back(1);
 		} else {
-			bs.push_back(-d-1);
+			bs.push_back(-*d-1);
 			rg.push_back(0);
 		}
 	}
-	bs.push_back(align.eR - align.sR + 1 
+	bs.push_back(t.eR[r] - t.sR[r] + 1 
 			- (std::accumulate(bs.begin(), bs.end(), 0) + std::accumulate(rg.begin(), rg.end(), 0)));
 
 	// calculate query position
-	int rl = cdr3p_m.at(align.vdj) - align.sR;
+	int rl = DeltaFilter_t::symbols_m.cdr3(t.ex0[r], t.ex1[r]) - t.sR[r];
 	int ri = -1;
 	int qi = -1;
 	int bi = 0;
@@ -189,7 +168,7 @@ int ExtractCDR3_t::AlignmentRpQp(DeltaAlignment_t align) {
 		}
 		bi++;
 	}
-	return align.sQ + qi * o;
+	return t.sQ[r] + qi * o;
 }
 
 void ExtractCDR3_t::printResult(std::ofstream &cout) {
@@ -10,6 +10,8 @@
 #include <map>
 #include <vector>
 #include <numeric>
+#include <string_view>
+#include <memory_resource>
 
 //============================================CDRReader_t
 
@@ -56,44 +58,42 @@ public:
 class ExtractCDR3_t
 {
 private:
-	std::string idQ_m;
+	std::string_view idQ_m;        // query ID (owned by the record)
 	int reg_m;
 	char ori_m;
-	std::string v_m, d_m, j_m;
 
-	DeltaAlignment_t valn_m;
-	DeltaAlignment_t jaln_m;
+	const AlignTable_t *tab_m;     // alignments of the query
+	std::pmr::vector<int> vrows_m;      // V rows, i.e., group members then the representative
+	std::pmr::vector<int> jrows_m;      // J rows
 
-	std::string fqseq_m;
-	std::string fqqua_m;
+	std::string_view fqseq_m;           // fastq entry (owned by the caller)
+	std::string_view fqqua_m;
 
-	std::string cdr3seq_m;
-	std::string cdr3qua_m;
-	std::string cdr3aa_m;
+	std::pmr::string cdr3seq_m;
+	std::pmr::string cdr3qua_m;
+	std::pmr::string cdr3aa_m;
 
-	std::vector<std::string> cdr3c_m;
-	std::vector<std::string> cdr3q_m;
-	std::vector<std::string> cdr3a_m;
+	std::pmr::vector<std::pmr::string> cdr3c_m;
+	std::pmr::vector<std::pmr::string> cdr3q_m;
+	std::pmr::vector<std::pmr::string> cdr3a_m;
 
-	int AlignmentRpQp(DeltaAlignment_t align);
+	int AlignmentRpQp(const int r);
 
 public:
-	static std::map<std::string, int> cdr3p_m;
-	ExtractCDR3_t(const DeltaRecord_t &rec, const int &reg, const char &ori, const std::string &vdj, const int &vi, const int &ji) {
+	ExtractCDR3_t(const DeltaRecord_t &rec, const AlignTable_t &tab, const int &reg, const char &ori,
+			const int &vr, const int &jr, std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+		: vrows_m(mr), jrows_m(mr), cdr3seq_m(mr), cdr3qua_m(mr), cdr3aa_m(mr),
+		cdr3c_m(mr), cdr3q_m(mr), cdr3a_m(mr) {
 		idQ_m = rec.idQ;
+		tab_m = &tab;
 		reg_m = reg;
 		ori_m = ori;
 
-		std::stringstream ss(vdj);
-		getline(ss, v_m, ':');
-		getline(ss, d_m, ':');
-		getline(ss, j_m, ':');
+		vrows_m.assign(tab.gmBegin(vr), tab.gmEnd(vr));
+		vrows_m.push_back(vr);
 
-		valn_m = rec.aligns[vi];
-		valn_m.gm.push_back(valn_m);
-
-		jaln_m = rec.aligns[ji];
-		jaln_m.gm.push_back(jaln_m);
+		jrows_m.assign(tab.gmBegin(jr), tab.gmEnd(jr));
+		jrows_m.push_back(jr);
 		cdr3seq_m = cdr3qua_m = cdr3aa_m = "---";
 	}
 	~ExtractCDR3_t() {
@@ -101,15 +101,13 @@ public:
 	}
 
 	void clear() {
-		idQ_m.erase();
+		idQ_m = std::string_view();
 		reg_m = 0;
 		ori_m = 0;
-		v_m.erase(); d_m.erase(); j_m.erase();
-		valn_m.clear();
-		jaln_m.clear();
+		vrows_m.clear();
+		jrows_m.clear();
 
-		fqseq_m.erase();
-		fqqua_m.erase();
+		fqseq_m = fqqua_m = std::string_view();
 
 		cdr3seq_m.erase();
 		cdr3qua_m.erase();
@@ -120,7 +118,7 @@ public:
 		cdr3a_m.clear();
 	}
 
-	void inputFastq(std::string seq, std::string qua) {
+	void inputFastq(std::string_view seq, std::string_view qua) {
 		fqseq_m = seq;
 		fqqua_m = qua;
 	}
@@ -5,11 +5,15 @@
 #include <fstream>
 #include <unordered_map>
 #include <algorithm>
+#include <string_view>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 
 std::unordered_map<std::string, std::string> FASTA_t::getfasta(const std::string &fasta_path) {
 	std::unordered_map<std::string, std::string> fasta;
-	std::ifstream fasta_stream;
+	GzInStream_t fasta_stream;
 	fasta_stream.open(fasta_path);
 
 	// check stream
@@ -24,9 +28,8 @@ std::unordered_map<std::string, std::string> FASTA_t::getfasta(const std::string
 	while (fasta_stream.peek() != EOF) {
 		fasta_stream.get();
 		fasta_stream >> uid;
-		fasta_stream >> seq;
-		fasta[uid] = seq;
-		while(fasta_stream.get() != '\n');
+		fasta[uid].clear();
+		while(fasta_stream.get() != '\n');   // description after the ID
 		while(fasta_stream.peek() != EOF && fasta_stream.peek() != '>') {
 			fasta_stream >> seq;
 			fasta[uid] += seq;
@@ -44,36 +47,129 @@ std::string FASTA_t::subseq(const std::string &seq, const int str, const int end
 	return seq.substr(pos, len);
 }
 
-std::string FASTA_t::revcom(std::string seq) {
-	reverse(seq.begin(), seq.end());
-	for (size_t i = 0; i < seq.length(); i++) {
-		switch (seq[i]) {
-			case 'A' :
-				seq[i] = 'T';
-				break;
-			case 'C' :
-				seq[i] = 'G';
-				break;
-			case 'G' :
-				seq[i] = 'C';
-				break;
-			case 'T' :
-				seq[i] = 'A';
-				break;
-			case 'a' :
-				seq[i] = 't';
-				break;
-			case 'c' :
-				seq[i] = 'g';
-				break;
-			case 'g' :
-				seq[i] = 'c';
-				break;
-			case 't' :
-				seq[i] = 'a';
-				break;
-		}
+//========================================================revcom===
+
+// complement of every byte (case kept, non-ACGT unchanged)
+static const struct ComplementTable_t {
+	char c[256];
+	ComplementTable_t() {
+		for (int i = 0; i < 256; i++)
+			c[i] = i;
+		const char *f = "ACGTacgt", *r = "TGCAtgca";
+		for (int i = 0; i < 8; i++)
+			c[(unsigned char)f[i]] = r[i];
+	}
+} COMP;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* A<->T and C<->G differ by the xor masks 0x15 and 0x04 in both cases,
+ * so a block is complemented by comparing the uppercased bytes and
+ * xoring the matching ones.
+ */
+
+// reverse complement of 16 bytes (SSE2)
+static inline __m128i revcom16(__m128i x) {
+	const __m128i u = _mm_and_si128(x, _mm_set1_epi8((char)0xDF));
+	const __m128i at = _mm_or_si128(_mm_cmpeq_epi8(u, _mm_set1_epi8('A')), _mm_cmpeq_epi8(u, _mm_set1_epi8('T')));
+	const __m128i cg = _mm_or_si128(_mm_cmpeq_epi8(u, _mm_set1_epi8('C')), _mm_cmpeq_epi8(u, _mm_set1_epi8('G')));
+	x = _mm_xor_si128(x, _mm_or_si128(_mm_and_si128(at, _mm_set1_epi8(0x15)), _mm_and_si128(cg, _mm_set1_epi8(0x04))));
+
+	// reverse dwords, words in dwords, then bytes in words
+	x = _mm_shuffle_epi32(x, 0x1B);
+	x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xB1), 0xB1);
+	return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+// reverse complement of 32 bytes (AVX2)
+__attribute__((target("avx2")))
+static inline __m256i revcom32(__m256i x) {
+	const __m256i u = _mm256_and_si256(x, _mm256_set1_epi8((char)0xDF));
+	const __m256i at = _mm256_or_si256(_mm256_cmpeq_epi8(u, _mm256_set1_epi8('A')), _mm256_cmpeq_epi8(u, _mm256_set1_epi8('T')));
+	const __m256i cg = _mm256_or_si256(_mm256_cmpeq_epi8(u, _mm256_set1_epi8('C')), _mm256_cmpeq_epi8(u, _mm256_set1_epi8('G')));
+	x = _mm256_xor_si256(x, _mm256_or_si256(_mm256_and_si256(at, _mm256_set1_epi8(0x15)), _mm256_and_si256(cg, _mm256_set1_epi8(0x04))));
+
+	const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, rev), 0x4E);
+}
+
+// swap and reverse complement blocks from both ends, return the number of bytes done on each side
+__attribute__((target("avx2")))
+static size_t revcomBlocksAVX2(char *l, char *r) {
+	size_t k = 0;
+	while (r - l >= 64) {
+		r -= 32;
+		__m256i a = _mm256_loadu_si256((const __m256i *)l);
+		__m256i b = _mm256_loadu_si256((const __m256i *)r);
+		_mm256_storeu_si256((__m256i *)l, revcom32(b));
+		_mm256_storeu_si256((__m256i *)r, revcom32(a));
+		l += 32;
+		k += 32;
+	}
+	return k;
+}
+
+__attribute__((target("avx2")))
+static size_t revcomCopyAVX2(const char *p, size_t n, char *o) {
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32)
+		_mm256_storeu_si256((__m256i *)(o + i), revcom32(_mm256_loadu_si256((const __m256i *)(p + n - i - 32))));
+	return i;
+}
+
+static bool hasAVX2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+static const bool HAS_AVX2 = hasAVX2();
+
+#endif
+
+void FASTA_t::revcomInPlace(char *seq, const size_t n) {
+	char *l = seq;
+	char *r = l + n;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2) {
+		size_t k = revcomBlocksAVX2(l, r);
+		l += k;
+		r -= k;
+	}
+	while (r - l >= 32) {
+		r -= 16;
+		__m128i a = _mm_loadu_si128((const __m128i *)l);
+		__m128i b = _mm_loadu_si128((const __m128i *)r);
+		_mm_storeu_si128((__m128i *)l, revcom16(b));
+		_mm_storeu_si128((__m128i *)r, revcom16(a));
+		l += 16;
+	}
+#endif
+
+	// the rest by table
+	while (r - l > 1) {
+		char c = COMP.c[(unsigned char)*--r];
+		*r = COMP.c[(unsigned char)*l];
+		*l++ = c;
 	}
+	if (r - l == 1)
+		*l = COMP.c[(unsigned char)*l];
+}
+
+void FASTA_t::revcom(const char *p, const size_t n, char *o) {
+	size_t i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2)
+		i = revcomCopyAVX2(p, n, o);
+	for (; i + 16 <= n; i += 16)
+		_mm_storeu_si128((__m128i *)(o + i), revcom16(_mm_loadu_si128((const __m128i *)(p + n - i - 16))));
+#endif
+	for (; i < n; i++)
+		o[i] = COMP.c[(unsigned char)p[n - i - 1]];
+}
+
+std::string FASTA_t::revcom(std::string seq) {
+	revcomInPlace(seq);
 	return seq;
 }
 
@@ -96,8 +192,7 @@ bool FastaReader_t::readNext() {
 	std::string seq;
 	fasta_stream_m.get();
 	fasta_stream_m >> uid_m;
-	fasta_stream_m >> seq_m;
-	while(fasta_stream_m.get() != '\n');
+	while(fasta_stream_m.get() != '\n');   // description after the ID
 	while(fasta_stream_m.peek() != EOF && fasta_stream_m.peek() != '>') {
 		fasta_stream_m >> seq;
 		seq_m += seq;
@@ -136,3 +231,76 @@ bool FastqReader_t::readNext() {
 
     return true;
 }
+
+//=============================================FastqIndex_t
+
+// first whitespace-delimited word of a line
+static std::string_view lineWord(const char *p, const char *end) {
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	const char *s = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+		p++;
+	return std::string_view(s, p - s);
+}
+
+void FastqIndex_t::open(const std::string &fastq_path) {
+	fastq_path_m = fastq_path;
+
+	// load a compressed fastq into memory (hash join on read IDs)
+	if (isGzipFile(fastq_path_m)) {
+		FastqReader_t fr;
+		fr.open(fastq_path_m);
+		while (fr.readNext()) {
+			uid_m.push_back(fr.getUID());
+			seq_m.push_back(fr.getSEQ());
+			qua_m.push_back(fr.getQUA());
+		}
+		for (size_t i = 0; i < uid_m.size(); i++)
+			index_m.emplace(std::string_view(uid_m[i]), i);
+		fetched_m.assign(uid_m.size(), false);
+		return;
+	}
+
+	CheckMap(map_m.open(fastq_path_m));
+
+	// record the offset of each entry (4 lines per entry)
+	const char *p = map_m.data();
+	const char *end = map_m.end();
+	while (p < end && *p == '@') {
+		const size_t i = offset_m.size();
+		offset_m.push_back(p - map_m.data());
+		index_m.emplace(lineWord(p+1, end), i);
+		for (int l = 0; l < 4 && p < end; l++)
+			p = findNewline(p, end) + 1;
+	}
+	fetched_m.assign(offset_m.size(), false);
+}
+
+bool FastqIndex_t::fetch(const std::string &uid, std::string &seq, std::string &qua) {
+	auto e = index_m.find(std::string_view(uid));
+	if (e == index_m.end())
+		return false;
+	std::string id;
+	getEntry(e->second, id, seq, qua);
+	fetched_m[e->second] = true;
+	return true;
+}
+
+void FastqIndex_t::getEntry(const size_t i, std::string &uid, std::string &seq, std::string &qua) const {
+	if (offset_m.empty()) {
+		uid = uid_m[i];
+		seq = seq_m[i];
+		qua = qua_m[i];
+		return;
+	}
+
+	const char *p = map_m.data() + offset_m[i];
+	const char *end = map_m.end();
+	uid = lineWord(p+1, end);
+	p = findNewline(p, end) + 1;
+	seq = lineWord(p, end);
+	p = findNewline(p, end) + 1;
+	p = findNewline(p, end) + 1;
+	qua = lineWord(p, end);
+}
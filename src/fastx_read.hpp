@@ -4,8 +4,13 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <string_view>
+#include <vector>
 #include <unordered_map>
 
+#include "mapfile.hpp"
+#include "gzstream.hpp"
+
 namespace FASTA_t
 {
 	// load fasta file and convert to unordered map
@@ -16,6 +21,27 @@ namespace FASTA_t
 
 	// reverse complement
 	std::string revcom(std::string seq);
+
+	// reverse complement of n bases in place (case kept, non-ACGT unchanged)
+	void revcomInPlace(char *seq, const size_t n);
+
+	// reverse complement in place, a std::string or a std::pmr::string
+	template <class String>
+	void revcomInPlace(String &seq) {
+		if (!seq.empty())
+			revcomInPlace(&seq[0], seq.length());
+	}
+
+	// reverse complement of n bases from seq written into out
+	void revcom(const char *seq, const size_t n, char *out);
+
+	// reverse complement of seq written into out, a std::string or a std::pmr::string
+	template <class String>
+	void revcom(std::string_view seq, String &out) {
+		out.resize(seq.length());
+		if (!out.empty())
+			revcom(seq.data(), seq.length(), &out[0]);
+	}
 }
 
 // load fasta file using "while"
@@ -23,7 +49,7 @@ class FastaReader_t
 {
 private:
 	std::string fasta_path_m;      // path
-	std::ifstream fasta_stream_m;  // stream
+	GzInStream_t fasta_stream_m;   // stream (plain, gzip or BGZF)
 	bool is_open_m;                // stream is open
 
 	std::string uid_m;             // fasta id(>)
@@ -61,7 +87,7 @@ class FastqReader_t
 {
 private:
 	std::string fastq_path_m;
-	std::ifstream fastq_stream_m;
+	GzInStream_t fastq_stream_m;   // stream (plain, gzip or BGZF)
 	bool is_open_m;
 
 	std::string uid_m;
@@ -103,4 +129,41 @@ public:
 	};
 };
 
+// one-time offset index over a mapped fastq file, for fetching reads by ID
+// (a compressed fastq cannot be mapped, so its entries are held in memory instead)
+class FastqIndex_t
+{
+private:
+	std::string fastq_path_m;
+	MappedFile_t map_m;                                      // mapped fastq file
+	std::vector<size_t> offset_m;                            // offset of each entry
+	std::vector<std::string> uid_m, seq_m, qua_m;            // entries of a compressed fastq
+	std::vector<bool> fetched_m;                             // entry has been fetched
+	std::unordered_map<std::string_view, size_t> index_m;   // read ID to entry
+
+	void CheckMap(const bool good) {
+		if (!good) {
+			std::cerr << "\033[31mERROR:\033[0m Could not parse fastq file, "
+				<< fastq_path_m << std::endl;
+			exit(1);
+		}
+	}
+
+public:
+	void open(const std::string &fastq_path);
+
+	// load a read by ID and mark it fetched, false if not indexed
+	bool fetch(const std::string &uid, std::string &seq, std::string &qua);
+
+	// load the i-th entry in file order
+	void getEntry(const size_t i, std::string &uid, std::string &seq, std::string &qua) const;
+
+	size_t size() const {
+		return fetched_m.size();
+	}
+	bool isFetched(const size_t i) const {
+		return fetched_m[i];
+	}
+};
+
 #endif /* fastx_read.hpp  */
@@ -0,0 +1,270 @@
+#include "gzstream.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <zlib.h>
+
+#define GZBUF   (1 << 17)   // size of the gzip stream buffer
+#define BGZFHDR 18          // size of the BGZF block header
+
+int GzInStream_t::threads = 1;
+
+
+//==================================================GzStreamBuf_t===
+
+bool GzStreamBuf_t::open(const std::string &path) {
+	close();
+	gz_m = gzopen(path.c_str(), "rb");
+	if (gz_m == NULL)
+		return false;
+	gzbuffer(gz_m, GZBUF);
+	buf_m.resize(GZBUF);
+	setg(buf_m.data(), buf_m.data(), buf_m.data());
+	return true;
+}
+
+void GzStreamBuf_t::close() {
+	if (gz_m != NULL)
+		gzclose(gz_m);
+	gz_m = NULL;
+}
+
+int GzStreamBuf_t::underflow() {
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+	if (gz_m == NULL)
+		return traits_type::eof();
+
+	int n = gzread(gz_m, buf_m.data(), buf_m.size());
+	if (n <= 0)
+		return traits_type::eof();
+	setg(buf_m.data(), buf_m.data(), buf_m.data() + n);
+	return traits_type::to_int_type(*gptr());
+}
+
+//================================================BgzfStreamBuf_t===
+
+bool BgzfStreamBuf_t::open(const std::string &path, const int threads) {
+	close();
+	path_m = path;
+	fp_m = fopen(path.c_str(), "rb");
+	if (fp_m == NULL)
+		return false;
+
+	int n = threads > 1 ? threads : 1;
+	ring_m.assign(4 * n, Block_t());
+	for (auto &b : ring_m)
+		b.state = EMPTY;
+	take_m = total_m = 0;
+	eof_m = stop_m = error_m = false;
+	setg(NULL, NULL, NULL);
+
+	loader_m = std::thread(&BgzfStreamBuf_t::load, this);
+	for (int i = 0; i < n; i++)
+		workers_m.push_back(std::thread(&BgzfStreamBuf_t::work, this));
+	return true;
+}
+
+void BgzfStreamBuf_t::close() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_m);
+		stop_m = true;
+	}
+	load_cv_m.notify_all();
+	work_cv_m.notify_all();
+	ready_cv_m.notify_all();
+	if (loader_m.joinable())
+		loader_m.join();
+	for (auto &w : workers_m)
+		w.join();
+	workers_m.clear();
+	work_m.clear();
+	ring_m.clear();
+	if (fp_m != NULL)
+		fclose(fp_m);
+	fp_m = NULL;
+}
+
+// read compressed blocks in order
+void BgzfStreamBuf_t::load() {
+	for (size_t serial = 0; ; serial++) {
+		Block_t &b = ring_m[serial % ring_m.size()];
+		{
+			std::unique_lock<std::mutex> lock(mutex_m);
+			load_cv_m.wait(lock, [this, &b]{ return b.state == EMPTY || stop_m; });
+			if (stop_m)
+				return;
+		}
+
+		// block header, then the rest of the block (BSIZE is the block size - 1)
+		unsigned char h[BGZFHDR];
+		size_t n = fread(h, 1, BGZFHDR, fp_m);
+		bool ok = n == BGZFHDR && h[0] == 31 && h[1] == 139 && (h[3] & 4) &&
+			h[12] == 'B' && h[13] == 'C';
+		if (ok) {
+			size_t bsize = (h[16] | (h[17] << 8)) + 1;
+			b.cdata.resize(bsize);
+			memcpy(b.cdata.data(), h, BGZFHDR);
+			ok = bsize > BGZFHDR + 8 &&
+				fread(b.cdata.data() + BGZFHDR, 1, bsize - BGZFHDR, fp_m) == bsize - BGZFHDR;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_m);
+		if (!ok) {
+			error_m = n != 0;   // clean end of file if nothing is left
+			eof_m = true;
+			total_m = serial;
+			work_cv_m.notify_all();
+			ready_cv_m.notify_all();
+			return;
+		}
+		b.state = LOADED;
+		work_m.push_back(serial);
+		work_cv_m.notify_one();
+	}
+}
+
+// inflate loaded blocks in any order
+void BgzfStreamBuf_t::work() {
+	while (true) {
+		size_t serial;
+		{
+			std::unique_lock<std::mutex> lock(mutex_m);
+			work_cv_m.wait(lock, [this]{ return !work_m.empty() || eof_m || stop_m; });
+			if (stop_m || work_m.empty())
+				return;
+			serial = work_m.front();
+			work_m.pop_front();
+		}
+
+		Block_t &b = ring_m[serial % ring_m.size()];
+		b.ok = inflateBlock(b);
+
+		std::lock_guard<std::mutex> lock(mutex_m);
+		b.state = READY;
+		ready_cv_m.notify_all();
+	}
+}
+
+bool BgzfStreamBuf_t::inflateBlock(Block_t &b) {
+	const size_t bsize = b.cdata.size();
+	const unsigned char *t = (const unsigned char *)b.cdata.data() + bsize - 4;
+	const size_t isize = t[0] | (t[1] << 8) | (t[2] << 16) | ((size_t)t[3] << 24);
+	const size_t xlen = (unsigned char)b.cdata[10] | ((unsigned char)b.cdata[11] << 8);
+	const size_t cstart = 12 + xlen;
+	b.data.resize(isize);
+	if (isize == 0)
+		return true;
+	if (cstart + 8 > bsize)
+		return false;
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, -15) != Z_OK)
+		return false;
+	zs.next_in = (Bytef *)b.cdata.data() + cstart;
+	zs.avail_in = bsize - cstart - 8;
+	zs.next_out = (Bytef *)b.data.data();
+	zs.avail_out = isize;
+	int ret = inflate(&zs, Z_FINISH);
+	inflateEnd(&zs);
+	return ret == Z_STREAM_END && zs.total_out == isize;
+}
+
+int BgzfStreamBuf_t::underflow() {
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	std::unique_lock<std::mutex> lock(mutex_m);
+	while (true) {
+
+		// hand the parsed block back to the loader
+		if (take_m > 0) {
+			Block_t &prev = ring_m[(take_m - 1) % ring_m.size()];
+			if (prev.state == READY) {
+				prev.state = EMPTY;
+				load_cv_m.notify_one();
+			}
+		}
+
+		Block_t &b = ring_m[take_m % ring_m.size()];
+		ready_cv_m.wait(lock, [this, &b]{
+				return b.state == READY || (eof_m && take_m >= total_m) || stop_m; });
+		if (b.state != READY) {
+			if (error_m) {
+				std::cerr << "\033[31mERROR:\033[0m Could not parse bgzf file, "
+					<< path_m << std::endl;
+				exit(1);
+			}
+			setg(NULL, NULL, NULL);
+			return traits_type::eof();
+		}
+		if (!b.ok) {
+			std::cerr << "\033[31mERROR:\033[0m Could not inflate bgzf block, "
+				<< path_m << std::endl;
+			exit(1);
+		}
+		take_m++;
+
+		// skip empty blocks (e.g., the EOF marker)
+		if (b.data.empty())
+			continue;
+		setg(b.data.data(), b.data.data(), b.data.data() + b.data.size());
+		return traits_type::to_int_type(*gptr());
+	}
+}
+
+//===================================================GzInStream_t===
+
+bool isGzipFile(const std::string &path) {
+	unsigned char m[2] = {0, 0};
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+	size_t n = fread(m, 1, 2, fp);
+	fclose(fp);
+	return n == 2 && m[0] == 31 && m[1] == 139;
+}
+
+// true if the first gzip member carries the BGZF extra subfield
+static bool isBgzfFile(const std::string &path) {
+	unsigned char h[BGZFHDR];
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+	size_t n = fread(h, 1, BGZFHDR, fp);
+	fclose(fp);
+	return n == BGZFHDR && h[0] == 31 && h[1] == 139 && (h[3] & 4) &&
+		h[10] == 6 && h[12] == 'B' && h[13] == 'C' && h[14] == 2;
+}
+
+void GzInStream_t::open(const std::string &path) {
+	close();
+
+	bool ok;
+	if (isBgzfFile(path)) {
+		bgzf_m.reset(new BgzfStreamBuf_t());
+		ok = bgzf_m->open(path, threads);
+		rdbuf(bgzf_m.get());
+	} else if (isGzipFile(path)) {
+		gz_m.reset(new GzStreamBuf_t());
+		ok = gz_m->open(path);
+		rdbuf(gz_m.get());
+	} else {
+		ok = file_m.open(path, std::ios::in | std::ios::binary) != NULL;
+		rdbuf(&file_m);
+	}
+	if (!ok)
+		setstate(std::ios::failbit);
+}
+
+void GzInStream_t::close() {
+	rdbuf(NULL);
+	bgzf_m.reset();
+	gz_m.reset();
+	if (file_m.is_open())
+		file_m.close();
+}
@@ -0,0 +1,125 @@
+#ifndef GZSTREAM_HPP
+#define GZSTREAM_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <zlib.h>
+
+/*
+  usage:
+  GzInStream_t in;
+  in.open("read.fq.gz");   // plain, gzip or BGZF (detected from the magic bytes)
+  in >> uid;
+*/
+
+//==================================================GzStreamBuf_t===
+
+// stream buffer over a gzip file (multi-member) using zlib
+class GzStreamBuf_t : public std::streambuf
+{
+private:
+	gzFile gz_m;
+	std::vector<char> buf_m;
+
+protected:
+	int underflow();
+
+public:
+	GzStreamBuf_t() {
+		gz_m = NULL;
+	}
+	~GzStreamBuf_t() {
+		close();
+	}
+
+	bool open(const std::string &path);
+	void close();
+};
+
+//================================================BgzfStreamBuf_t===
+
+// stream buffer over a BGZF file, blocks are inflated by a pool of threads ahead of the reader
+class BgzfStreamBuf_t : public std::streambuf
+{
+private:
+	enum { EMPTY, LOADED, READY };
+
+	struct Block_t {
+		std::vector<char> cdata;   // whole compressed block
+		std::vector<char> data;    // inflated block
+		int state;
+		bool ok;
+	};
+
+	std::string path_m;
+	FILE *fp_m;
+	std::vector<Block_t> ring_m;       // blocks in flight, indexed by serial % size
+	std::deque<size_t> work_m;         // serials of loaded blocks
+	size_t take_m;                     // serial of the next block to be parsed
+	size_t total_m;                    // number of blocks (known at end of file)
+	bool eof_m;                        // all blocks loaded
+	bool stop_m;                       // closing
+	bool error_m;                      // malformed block
+
+	std::thread loader_m;
+	std::vector<std::thread> workers_m;
+	std::mutex mutex_m;
+	std::condition_variable load_cv_m;    // a block is emptied
+	std::condition_variable work_cv_m;    // a block is loaded
+	std::condition_variable ready_cv_m;   // a block is inflated
+
+	void load();
+	void work();
+	bool inflateBlock(Block_t &b);
+
+protected:
+	int underflow();
+
+public:
+	BgzfStreamBuf_t() {
+		fp_m = NULL;
+		take_m = total_m = 0;
+		eof_m = stop_m = error_m = false;
+	}
+	~BgzfStreamBuf_t() {
+		close();
+	}
+
+	bool open(const std::string &path, const int threads);
+	void close();
+};
+
+//===================================================GzInStream_t===
+
+// input stream over a plain, gzip or BGZF file
+class GzInStream_t : public std::istream
+{
+private:
+	std::filebuf file_m;
+	std::unique_ptr<GzStreamBuf_t> gz_m;
+	std::unique_ptr<BgzfStreamBuf_t> bgzf_m;
+
+public:
+	static int threads;   // threads inflating BGZF blocks
+
+	GzInStream_t() : std::istream(NULL) {
+	}
+	~GzInStream_t() {
+		close();
+	}
+
+	void open(const std::string &path);
+	void close();
+};
+
+// true if the file starts with the gzip magic bytes
+bool isGzipFile(const std::string &path);
+
+#endif /* gzstream.hpp */
@@ -0,0 +1,84 @@
+#include "kmerfilter.hpp"
+#include "fastx_read.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+// 2-bit code of a base, -1 if not ACGT (case-insensitive)
+static inline int baseCode(const char c) {
+	switch (c | 0x20) {
+		case 'a': return 0;
+		case 'c': return 1;
+		case 'g': return 2;
+		case 't': return 3;
+		default:  return -1;
+	}
+}
+
+/* The forward code shifts a base in at the right and the reverse one
+ * shifts its complement (3 - code) in at the left, so both are updated in
+ * O(1) per base.
+ */
+
+// call visit(canonical code) for each k-mer of ACGT bases in seq, until it returns true
+template <class Visit>
+static bool forKmers(std::string_view seq, const int k, Visit visit) {
+	const uint64_t mask = k == 32 ? ~(uint64_t)0 : ((uint64_t)1 << (2 * k)) - 1;
+	const int shift = 2 * (k - 1);
+	uint64_t fw = 0, rv = 0;
+	int valid = 0;
+	for (const char c : seq) {
+		const int b = baseCode(c);
+		if (b < 0) {
+			valid = 0;
+			continue;
+		}
+		fw = ((fw << 2) | b) & mask;
+		rv = (rv >> 2) | ((uint64_t)(3 - b) << shift);
+		if (++valid >= k && visit(std::min(fw, rv)))
+			return true;
+	}
+	return false;
+}
+
+void KmerFilter_t::build(const std::string &fasta_path, const int minmatch) {
+	if (minmatch < 1) {
+		std::cerr << "\033[31mERROR:\033[0m Minimal match must be positive, " << minmatch << std::endl;
+		exit(1);
+	}
+	kmer_m = std::min(minmatch, 32);
+
+	kmers_m.clear();
+	FastaReader_t fr;
+	fr.open(fasta_path);
+	while (fr.readNext()) {
+		forKmers(fr.getSEQ(), kmer_m, [&](const uint64_t code) {
+			kmers_m.push_back(code);
+			return false;
+		});
+	}
+	std::sort(kmers_m.begin(), kmers_m.end());
+	kmers_m.erase(std::unique(kmers_m.begin(), kmers_m.end()), kmers_m.end());
+
+	// first code of each prefix
+	pbits_m = std::min(2 * kmer_m, 22);
+	bucket_m.assign(((size_t)1 << pbits_m) + 1, 0);
+	for (const uint64_t x : kmers_m)
+		bucket_m[(x >> (2 * kmer_m - pbits_m)) + 1]++;
+	for (size_t i = 1; i < bucket_m.size(); i++)
+		bucket_m[i] += bucket_m[i-1];
+}
+
+bool KmerFilter_t::has(const uint64_t code) const {
+	const uint64_t pre = code >> (2 * kmer_m - pbits_m);
+	return std::binary_search(kmers_m.begin() + bucket_m[pre], kmers_m.begin() + bucket_m[pre+1], code);
+}
+
+bool KmerFilter_t::hit(std::string_view seq) const {
+	return forKmers(seq, kmer_m, [&](const uint64_t code) {
+		return has(code);
+	});
+}
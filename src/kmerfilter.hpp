@@ -0,0 +1,54 @@
+#ifndef KMERFILTER_HPP
+#define KMERFILTER_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/*
+  usage:
+  KmerFilter_t kf;
+  kf.build("hsa_trb.fa", 15);   // k-mers of the references (both strands)
+  if (kf.hit(seq)) ...          // seq shares a k-mer with the references
+*/
+
+//==================================================KmerFilter_t===
+
+/* A read aligned by nucmer -l m has a maximal match of at least m bases,
+ * so it shares an m-mer with the references and k = min(m, 32) loses
+ * none of them. K-mers are kept canonical (the smaller code of the two
+ * strands) in a sorted array, looked up through the bucket of their first
+ * bases.
+ */
+
+class KmerFilter_t
+{
+private:
+	int kmer_m;                       // k-mer length
+	int pbits_m;                      // bits of a code looked up in bucket_m
+	std::vector<uint64_t> kmers_m;    // canonical codes, sorted and unique
+	std::vector<uint32_t> bucket_m;   // first code of each prefix
+
+	bool has(const uint64_t code) const;
+
+public:
+	KmerFilter_t() {
+		kmer_m = pbits_m = 0;
+	}
+
+	void build(const std::string &fasta_path, const int minmatch);
+
+	// true if seq shares a k-mer with the references on either strand
+	bool hit(std::string_view seq) const;
+
+	int kmer() const {
+		return kmer_m;
+	}
+	size_t size() const {
+		return kmers_m.size();
+	}
+};
+
+#endif /* kmerfilter.hpp */
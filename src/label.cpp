@@ -0,0 +1,273 @@
+#include "label.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+
+
+// s as a pattern of gene classes, each optional if followed by '?' (e.g., "v?VD?JC?")
+static bool matches(const char *s, const char *p) {
+	if (*p == '\0')
+		return *s == '\0';
+	if (p[1] == '?')
+		return (*s == *p && matches(s + 1, p + 2)) || matches(s, p + 2);
+	return *s == *p && matches(s + 1, p + 1);
+}
+
+//====================================================LabelAln_t===
+
+void LabelAln_t::load(const AlignTable_t &t, const int r) {
+	ref = t.refs[t.ref[r]];
+	e0 = t.ex0[r];
+	e1 = t.ex1[r];
+	sR = t.sR[r];
+	eR = t.eR[r];
+	sQ = t.sQ[r];
+	eQ = t.eQ[r];
+	const int *dt = t.deltas(r);
+	tail = std::to_string(t.mmgp[r]) + ":" + std::to_string(dt[0]);
+	for (int i = 1; i < t.dlen[r]; i++)
+		tail += "," + std::to_string(dt[i]);
+}
+
+std::string LabelAln_t::text(const SymbolTable_t &st) const {
+	return st.vdjeName(e0, e1) + ":" + std::to_string(sR) + "-" + std::to_string(eR) + ":" +
+		std::to_string(sQ) + "-" + std::to_string(eQ) + ":" + tail;
+}
+
+//=================================================RecombLabel_t===
+
+int RecombLabel_t::order(const std::string &cat) {
+	static const char *cats[] = {"CH", "AS", "AR", "CR", "PCR", "PR", "PPR", "NR", "NS", "UC"};
+	for (int k = 0; k < 10; k++) {
+		if (cat == cats[k])
+			return k;
+	}
+	return 10;
+}
+
+//===============================================RecombLabeler_t===
+
+void RecombLabeler_t::load(const SymbolTable_t &st, const std::string &rss_path) {
+	st_m = &st;
+	rss_m.clear();
+
+	jstart_m.assign(st.numContigs(), INT_MAX);
+	for (int c = 0; c < st.numContigs(); c++) {
+		for (int e = st.contig(c).first; e < st.contig(c).last; e++) {
+			if (st.firstGene(e).cls == 'J')
+				jstart_m[c] = std::min(jstart_m[c], st.exon(e).start);
+		}
+	}
+
+	// RSS23 positions (type, position, ...), within 30 bases after and 3 bases before
+	std::ifstream in(rss_path);
+	if (!in.good())
+		return;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.compare(0, 6, "RSS12\t") == 0)
+			continue;
+		const size_t t = line.find('\t');
+		if (t == std::string::npos)
+			continue;
+		const int l = atoi(line.c_str() + t + 1);
+		for (int i = l - 30; i <= l + 3; i++)
+			rss_m.insert(i);
+	}
+}
+
+int RecombLabeler_t::geneStart(const int c, const int g) const {
+	if (c < 0)
+		return 0;
+	const ContigSym_t &cs = st_m->contig(c);
+	int s = -1;
+	for (int e = cs.first; e < cs.last; e++) {
+		const ExonSym_t &x = st_m->exon(e);
+		if (x.gene == g && (s < 0 || x.start < s))
+			s = x.start;
+	}
+	return s < 0 ? 0 : s;
+}
+
+int RecombLabeler_t::downstreamC(const int c, const int e, const int pos) const {
+	if (c < 0)
+		return -1;
+	const ContigSym_t &cs = st_m->contig(c);
+	int best = -1;
+	for (int x = cs.first; x < cs.last; x++) {
+		const ExonSym_t &ex = st_m->exon(x);
+		if (st_m->gene(ex.gene).cls != 'C' || ex.num != st_m->exon(e).num || ex.start <= pos)
+			continue;
+		if (best < 0 || ex.start < st_m->exon(best).start)
+			best = x;
+	}
+	return best;
+}
+
+void RecombLabeler_t::resolveC(LabelSet_t &d) const {
+	// a group after a J to its C right downstream of the J, e.g., J1 C1|C2 to J1 C1
+	for (size_t i = 1; i < d.size(); i++) {
+		const LabelAln_t &j = d[i-1][0];
+		if (d[i].size() < 2 || cls(j) != 'J')
+			continue;
+		int m = -1;
+		for (size_t k = 0; k < d[i].size(); k++) {
+			const LabelAln_t &a = d[i][k];
+			if (cls(a) == 'C' && a.sR > j.eR && (m < 0 || a.sR < d[i][m].sR))
+				m = k;
+		}
+		if (m >= 0)
+			d[i] = { d[i][m] };
+	}
+
+	// a C upstream of the J before it, moved to that C downstream of the J, e.g., J2 C1 to J2 C2
+	for (size_t i = 1; i < d.size(); i++) {
+		const LabelAln_t &j = d[i-1][0];
+		LabelAln_t &a = d[i][0];
+		if (cls(j) != 'J' || cls(a) != 'C' || a.e0 != a.e1 || a.sR > j.eR)
+			continue;
+		const int e = downstreamC(st_m->contigID(a.ref), a.e0, j.eR);
+		if (e < 0)
+			continue;
+		const int shift = st_m->exon(e).start - st_m->exon(a.e0).start;
+		a.e0 = a.e1 = e;
+		a.sR += shift;
+		a.eR += shift;
+		break;
+	}
+}
+
+std::string RecombLabeler_t::processJC(const LabelAln_t &a) const {
+	bool pseudo = false;
+	for (int e = a.e0; e <= a.e1; e++)
+		pseudo |= st_m->gene(st_m->exon(e).gene).name.find('P') != std::string::npos;
+	const int gul = geneStart(st_m->contigID(a.ref), st_m->exon(a.e1).gene) - a.sR;
+	return gul >= LABEL_GERMLINE || pseudo ? "NR" : "UC";
+}
+
+std::string RecombLabeler_t::processC(const LabelAln_t &a) const {
+	const int gul = geneStart(st_m->contigID(a.ref), st_m->exon(a.e0).gene) - a.sR;
+	return gul >= LABEL_GERMLINE ? "NS" : "UC";
+}
+
+std::string RecombLabeler_t::processIJC(const LabelAln_t &i) const {
+	// an intergenic piece ending right before a D
+	const int c = st_m->contigID(i.ref);
+	if (c >= 0) {
+		const ContigSym_t &cs = st_m->contig(c);
+		for (int e = cs.first; e < cs.last; e++) {
+			const ExonSym_t &x = st_m->exon(e);
+			if (st_m->gene(x.gene).cls == 'D' && x.start - LABEL_DFLANK <= i.eR && i.eR < x.start)
+				return "PPR";
+		}
+	}
+	return rss_m.count(i.eR) ? "AR" : "AS";
+}
+
+void RecombLabeler_t::label(const LabelSet_t &ls, const int reg, RecombLabel_t &lab) const {
+	LabelSet_t d;
+	for (const auto &a : ls) {
+		if (!a.empty())
+			d.push_back(a);
+	}
+
+	// orientations on the query in order of appearance
+	std::string uo;
+	for (const auto &a : d) {
+		const char o = a[0].sQ < a[0].eQ ? '+' : '-';
+		if (uo.find(o) == std::string::npos)
+			uo += o;
+	}
+
+	// in the order of the reference, then the Cs after Js
+	if (d.size() > 2 && uo.size() == 1 && d[0][0].sR > d[1][0].sR)
+		std::reverse(d.begin(), d.end());
+	if (uo.size() == 1)
+		resolveC(d);
+
+	// V leader exons (v), then the gene class of each alignment
+	std::vector<bool> leader(d.size());
+	lab.genes.clear();
+	for (size_t i = 0; i < d.size(); i++) {
+		const LabelAln_t &a = d[i][0];
+		bool span = false;
+		for (const auto &m : d[i])
+			span |= m.e0 != m.e1;
+		leader[i] = cls(a) == 'V' && !span && st_m->exon(a.e0).num == '1';
+		lab.genes += leader[i] ? 'v' : cls(a);
+	}
+
+	// a good V is one gene without broken pieces
+	std::map<std::string, int> vc, vec;
+	for (size_t i = 0; i < d.size(); i++) {
+		const LabelAln_t &a = d[i][0];
+		if (cls(a) != 'V' || leader[i])
+			continue;
+		const std::string v = st_m->vdjName(a.e0, a.e1);
+		vc[v]++;
+		vec[v + st_m->exon(a.e1).num]++;
+	}
+	int vemaxc = 0;
+	for (const auto &v : vec)
+		vemaxc = std::max(vemaxc, v.second);
+	const bool vgood = vc.size() == 1 && vemaxc <= 1;
+
+	// reference starts not decreasing, but inverted Vs
+	bool increasing = true;
+	int last = -1;
+	for (const auto &a : d) {
+		const int c = st_m->contigID(a[0].ref);
+		if (cls(a[0]) == 'V' && c >= 0 && a[0].sR > jstart_m[c])
+			continue;
+		if (a[0].sR < last) {
+			increasing = false;
+			break;
+		}
+		last = a[0].sR;
+	}
+
+	const char *g = lab.genes.c_str();
+	const int cc = std::count(lab.genes.begin(), lab.genes.end(), 'C');
+	if (reg == 2)
+		lab.cat = "CR";
+	else if (uo.size() > 1 || cc > 1 || !increasing)
+		lab.cat = "CH";
+	else if (matches(g, "v?VD?JC?"))
+		lab.cat = "CR";
+	else if (matches(g, "DJC?"))
+		lab.cat = "PR";
+	else if (lab.genes == "D")
+		lab.cat = "PPR";
+	else if (matches(g, "JC?"))
+		lab.cat = processJC(d[0][0]);
+	else if (matches(g, "v?VD?") && vgood)
+		lab.cat = "PCR";
+	else if (lab.genes == "C")
+		lab.cat = processC(d[0][0]);
+	else if (lab.genes == "I" || lab.genes == "v")
+		lab.cat = "UC";
+	else if (matches(g, "IJC?"))
+		lab.cat = processIJC(d[0][0]);
+	else
+		lab.cat = "AS";
+	lab.junction = lab.cat == "UC" || lab.cat == "CH" ? 0 : 1;
+
+	// the corrected alignments
+	lab.aln.clear();
+	for (size_t i = 0; i < d.size(); i++) {
+		if (i)
+			lab.aln += " ";
+		for (size_t k = 0; k < d[i].size(); k++) {
+			std::string t = d[i][k].text(*st_m);
+			if (k == 0 && leader[i])
+				t[3] = 'v';
+			lab.aln += (k ? "|" : "") + t;
+		}
+	}
+}
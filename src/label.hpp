@@ -0,0 +1,115 @@
+#ifndef LABEL_HPP
+#define LABEL_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "symbols.hpp"
+#include "aligntable.hpp"
+
+/*
+  usage:
+  RecombLabeler_t rl;
+  rl.load(DeltaFilter_t::symbols_m, "hsa_trb_rss.txt");   // RSS23 positions are optional
+  LabelSet_t ls;
+  df.getLabelSet(ls);                                      // after annotateQuery
+  RecombLabel_t lab;
+  rl.label(ls, df.getREG(), lab);
+  out << lab.cat << "\t" << lab.genes << "\t" << lab.junction << ...
+*/
+
+//====================================================LabelAln_t===
+
+// an alignment as in its concise form, without the reference prefix
+struct LabelAln_t {
+	std::string ref;    // reference contig
+	int e0, e1;         // annotation (see SymbolTable_t)
+	int sR, eR;         // coordinates on the reference
+	int sQ, eQ;         // coordinates on the query
+	std::string tail;   // mismatches and deltas
+
+	// row r of an alignment table
+	void load(const AlignTable_t &t, const int r);
+
+	std::string text(const SymbolTable_t &st) const;
+};
+
+// alignments of a query in VDJ order, each with the members of its group
+// (the first is the representative)
+typedef std::vector< std::vector<LabelAln_t> > LabelSet_t;
+
+//=================================================RecombLabel_t===
+
+// a line of the .lab file before the .vdjdelta fields
+struct RecombLabel_t {
+	std::string cat;    // category
+	std::string genes;  // gene class of each alignment, e.g., VDJC ("v" for a V leader)
+	int junction;       // 0 for UC and CH, else 1
+	std::string aln;    // alignments after the corrections
+
+	// rank of a category, CH first and UC last
+	static int order(const std::string &cat);
+};
+
+//===============================================RecombLabeler_t===
+
+/* Port of LabelRecombination.pl, on the alignments of a query instead of
+ * its .vdjdelta line. Alignments of mixed orientations, more than one C
+ * or going back on the reference are chimeric (CH); else the classes of
+ * the genes in VDJ order give complete (CR: VDJ, VJ, ...), partial (PR:
+ * DJ, PPR: a D alone or an intergenic piece ending right before a D),
+ * potential (PCR: a single V without a J), aberrant (AR: an intergenic
+ * piece ending at a RSS23 before a J) and abnormal (AS) recombination. A
+ * J or a C starting at least 15 bases into the germline upstream of it is
+ * not rearranged (NR) or not spliced (NS), else unclassified (UC).
+ *
+ * The TRB specific rules are taken from the gene table: a C (or group of
+ * Cs) after a J is the one right downstream of the J (C1 after J1, C2
+ * after J2), a V downstream of the Js is inverted (TRBV30, the distal
+ * IGKVs) and left out of the reference order, the D intervals are those
+ * of the D genes, and a J with a P in its name (TRBJ2-2P) is never
+ * rearranged.
+ */
+
+#define LABEL_GERMLINE 15   // bases upstream of a J or C of a germline alignment
+#define LABEL_DFLANK   30   // bases before a D of a partial recombination
+
+class RecombLabeler_t
+{
+private:
+	const SymbolTable_t *st_m;
+	std::vector<int> jstart_m;       // first J start of each contig (a V after it is inverted)
+	std::unordered_set<int> rss_m;   // positions near a RSS23
+
+	// class of the first gene of a span
+	char cls(const LabelAln_t &a) const {
+		return st_m->firstGene(a.e0).cls;
+	}
+
+	// start of gene g on a contig
+	int geneStart(const int c, const int g) const;
+
+	// the same exon as e of the C nearest downstream of pos, -1 if none
+	int downstreamC(const int c, const int e, const int pos) const;
+
+	// the Cs after the Js (CorrectAmbiguousRegion and CorrectC1C2Ambiguous)
+	void resolveC(LabelSet_t &d) const;
+
+	std::string processJC(const LabelAln_t &a) const;
+	std::string processC(const LabelAln_t &a) const;
+	std::string processIJC(const LabelAln_t &i) const;
+
+public:
+	RecombLabeler_t() {
+		st_m = nullptr;
+	}
+
+	void load(const SymbolTable_t &st, const std::string &rss_path);
+
+	// reg is the regularity of the query
+	void label(const LabelSet_t &ls, const int reg, RecombLabel_t &lab) const;
+};
+
+#endif /* label.hpp */
@@ -0,0 +1,42 @@
+#include "mapfile.hpp"
+
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+bool MappedFile_t::open(const std::string &path) {
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	data_m = (const char *)map;
+	size_m = st.st_size;
+	return true;
+}
+
+void MappedFile_t::close() {
+	if (data_m != NULL)
+		munmap((void *)data_m, size_m);
+	data_m = NULL;
+	size_m = 0;
+}
+
+bool isRegularFile(const std::string &path) {
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
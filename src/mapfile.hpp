@@ -0,0 +1,65 @@
+#ifndef MAPFILE_HPP
+#define MAPFILE_HPP
+
+#include <string>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+  usage:
+  MappedFile_t mf;
+  if (mf.open(path)) { const char *p = mf.data(); ... }
+*/
+
+// read-only memory map of a whole file
+class MappedFile_t
+{
+private:
+	const char *data_m;   // mapped file
+	size_t size_m;        // size of the mapping
+
+public:
+	MappedFile_t() {
+		data_m = NULL;
+		size_m = 0;
+	}
+	~MappedFile_t() {
+		close();
+	}
+
+	// false if the file cannot be mapped (e.g., missing, empty, or a pipe)
+	bool open(const std::string &path);
+	void close();
+
+	const char *data() const {
+		return data_m;
+	}
+	const char *end() const {
+		return data_m + size_m;
+	}
+	size_t size() const {
+		return size_m;
+	}
+};
+
+// true if path is a regular file (i.e., can be mapped)
+bool isRegularFile(const std::string &path);
+
+// position of the next newline (or the end), scanning 16 bytes at a time
+inline const char *findNewline(const char *p, const char *end) {
+#if defined(__SSE2__)
+	const __m128i nl = _mm_set1_epi8('\n');
+	while (p + 16 <= end) {
+		int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), nl));
+		if (m)
+			return p + __builtin_ctz(m);
+		p += 16;
+	}
+#endif
+	const char *n = (const char *)memchr(p, '\n', end - p);
+	return n ? n : end;
+}
+
+#endif /* mapfile.hpp */
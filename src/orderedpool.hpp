@@ -0,0 +1,175 @@
+#ifndef ORDEREDPOOL_HPP
+#define ORDEREDPOOL_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+  usage:
+  OrderedPool_t<Batch_t> pool(threads, process, {&out0, &out1});   // (nullptr for an output not written)
+  pool.push(batch);   // batches are processed by workers in any order
+  pool.finish();      // and batch.out[k] written to out k in the order they were pushed
+
+  Batch_t has a serial (size_t), an out (std::vector<std::string>) and a clear()
+*/
+
+//=================================================OrderedPool_t===
+
+// workers process batches in parallel, a writer outputs them in input order
+template <class Batch_t>
+class OrderedPool_t
+{
+private:
+	int threads_m;                        // number of workers
+	size_t max_inflight_m;                // batches queued, processed or waiting to be written
+	void (*process_m)(Batch_t &);         // per-batch work
+	std::vector<std::ostream *> out_m;    // outputs of the batches in turn (none if null)
+
+	std::vector<std::thread> workers_m;
+	std::thread writer_m;
+	std::mutex mutex_m;
+	std::condition_variable work_cv_m;    // a batch is queued or input is done
+	std::condition_variable done_cv_m;    // a batch is processed or input is done
+	std::condition_variable space_cv_m;   // a batch is written
+
+	std::deque<Batch_t> queue_m;          // batches to be processed
+	std::map<size_t, Batch_t> done_m;     // processed batches by serial
+	size_t next_serial_m;                 // serial of the next pushed batch
+	size_t inflight_m;
+	bool closed_m;
+
+	void output(const Batch_t &batch) {
+		for (size_t k = 0; k < out_m.size() && k < batch.out.size(); k++)
+			if (out_m[k])
+				*out_m[k] << batch.out[k];
+	}
+
+	void work();
+	void write();
+
+public:
+	OrderedPool_t(int threads, void (*process)(Batch_t &), std::vector<std::ostream *> out);
+	~OrderedPool_t() {
+		finish();
+	}
+
+	void push(Batch_t &batch);
+	void finish();
+};
+
+//==============================================================
+
+template <class Batch_t>
+OrderedPool_t<Batch_t>::OrderedPool_t(int threads, void (*process)(Batch_t &), std::vector<std::ostream *> out)
+	: out_m(std::move(out)) {
+	threads_m = threads;
+	max_inflight_m = threads > 1 ? 4 * threads : 1;
+	process_m = process;
+	next_serial_m = 0;
+	inflight_m = 0;
+	closed_m = false;
+
+	// a single thread works in the caller
+	if (threads_m <= 1)
+		return;
+
+	for (int i = 0; i < threads_m; i++)
+		workers_m.push_back(std::thread(&OrderedPool_t::work, this));
+	writer_m = std::thread(&OrderedPool_t::write, this);
+}
+
+template <class Batch_t>
+void OrderedPool_t<Batch_t>::push(Batch_t &batch) {
+	batch.serial = next_serial_m++;
+
+	// process and write in place
+	if (threads_m <= 1) {
+		process_m(batch);
+		output(batch);
+		batch.clear();
+		return;
+	}
+
+	// wait until the writer catches up
+	std::unique_lock<std::mutex> lock(mutex_m);
+	space_cv_m.wait(lock, [this]{ return inflight_m < max_inflight_m; });
+	inflight_m++;
+	queue_m.push_back(std::move(batch));
+	lock.unlock();
+	work_cv_m.notify_one();
+	batch.clear();
+}
+
+template <class Batch_t>
+void OrderedPool_t<Batch_t>::finish() {
+	if (threads_m <= 1 || closed_m)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_m);
+		closed_m = true;
+	}
+	work_cv_m.notify_all();
+	for (auto &w : workers_m)
+		w.join();
+
+	// no more batches to come
+	done_cv_m.notify_all();
+	writer_m.join();
+	workers_m.clear();
+}
+
+template <class Batch_t>
+void OrderedPool_t<Batch_t>::work() {
+	while (true) {
+		std::unique_lock<std::mutex> lock(mutex_m);
+		work_cv_m.wait(lock, [this]{ return !queue_m.empty() || closed_m; });
+		if (queue_m.empty())
+			return;
+		Batch_t batch = std::move(queue_m.front());
+		queue_m.pop_front();
+		lock.unlock();
+
+		process_m(batch);
+
+		lock.lock();
+		size_t serial = batch.serial;
+		done_m.emplace(serial, std::move(batch));
+		lock.unlock();
+		done_cv_m.notify_all();
+	}
+}
+
+template <class Batch_t>
+void OrderedPool_t<Batch_t>::write() {
+	size_t serial = 0;
+	while (true) {
+		std::unique_lock<std::mutex> lock(mutex_m);
+		done_cv_m.wait(lock, [this, serial]{
+				return done_m.count(serial) > 0 ||
+				(closed_m && queue_m.empty() && done_m.empty() && inflight_m == 0); });
+		auto d = done_m.find(serial);
+		if (d == done_m.end())
+			return;
+		Batch_t batch = std::move(d->second);
+		done_m.erase(d);
+		lock.unlock();
+
+		// write outside the lock
+		output(batch);
+		serial++;
+
+		lock.lock();
+		inflight_m--;
+		lock.unlock();
+		space_cv_m.notify_one();
+	}
+}
+
+#endif /* orderedpool.hpp */
@@ -0,0 +1,360 @@
+#include "pairend.hpp"
+#include "mapfile.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+
+//==================================================MateResult_t===
+
+void MateResult_t::load(const DeltaFilter_t &df, const bool label) {
+	const AlignTable_t &t = df.getTAB();
+	ls.clear();
+	if (label)
+		df.getLabelSet(ls);
+	aln.clear();
+	for (const int r : df.getALN()) {
+		std::string a = t.concise_form(r, DeltaFilter_t::symbols_m);
+		for (const int *m = t.gmBegin(r); m != t.gmEnd(r); m++)
+			a += "|" + t.concise_form(*m, DeltaFilter_t::symbols_m);
+		aln.push_back(a);
+	}
+
+	std::string al;
+	for (size_t i = 0; i < aln.size(); i++)
+		al += (i ? " " : "") + aln[i];
+	const DeltaRecord_t &rec = df.getREC();
+	f = { rec.idQ, std::to_string(rec.lenQ), std::to_string(df.getREG()), rec.idR,
+		std::string(1, df.getORI()), df.getVDJ(), al,
+		std::to_string(df.getVi()) + "," + std::to_string(df.getDi()) + "," + std::to_string(df.getJi()),
+		std::to_string(df.al_m) };
+}
+
+void MateResult_t::none(const std::string &idQ, const size_t lenQ) {
+	f = { idQ, std::to_string(lenQ), "---" };
+	aln.clear();
+	ls.clear();
+}
+
+//=========================================================PAIR_t===
+
+// fields of s split at c, without the empty trailing ones (as perl split)
+static std::vector<std::string> split(const std::string &s, const char c) {
+	std::vector<std::string> v;
+	size_t b = 0;
+	while (true) {
+		const size_t e = s.find(c, b);
+		v.push_back(s.substr(b, e == std::string::npos ? std::string::npos : e - b));
+		if (e == std::string::npos)
+			break;
+		b = e + 1;
+	}
+	while (!v.empty() && v.back().empty())
+		v.pop_back();
+	return v;
+}
+
+static std::string join(const std::vector<std::string> &v, const char *c) {
+	std::string s;
+	for (size_t i = 0; i < v.size(); i++)
+		s += (i ? c : "") + v[i];
+	return s;
+}
+
+// index of element i of n, counted from the end if negative (-1 if out of range, as a perl array)
+static int index(const size_t n, int i) {
+	if (i < 0)
+		i += n;
+	return i >= 0 && i < (int)n ? i : -1;
+}
+
+// keep the members of alignment k of a labelled mate as its text was cut to them
+static void keepMembers(MateResult_t &a, const int k, const std::vector<size_t> &keep) {
+	if (k >= (int)a.ls.size())
+		return;
+	std::vector<LabelAln_t> m;
+	for (const size_t i : keep) {
+		if (i < a.ls[k].size())
+			m.push_back(a.ls[k][i]);
+	}
+	a.ls[k] = std::move(m);
+}
+
+// gene of an alignment, as /([VDJC][\d-]+)/
+static bool geneOf(const std::string &a, std::string &g) {
+	for (size_t i = 0; i + 1 < a.size(); i++) {
+		if (!strchr("VDJC", a[i]) || a[i] == '\0')
+			continue;
+		size_t e = i + 1;
+		while (e < a.size() && (isdigit(a[e]) || a[e] == '-'))
+			e++;
+		if (e > i + 1) {
+			g = a.substr(i, e - i);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Vs of v1 also in v2, with their alignments in aln1 (members kept in keep)
+static std::string consensusV(const std::string &v1, const std::string &v2, const std::string &aln1,
+		std::string &caln, std::vector<size_t> &keep) {
+	const std::vector<std::string> vv1 = split(v1, '|'), va1 = split(aln1, '|'), vv2 = split(v2, '|');
+	keep.clear();
+	if (v2 == "---") {
+		for (size_t i = 0; i < va1.size(); i++)
+			keep.push_back(i);
+		caln = aln1;
+		return v1;
+	}
+	std::vector<std::string> cv, ca;
+	for (size_t i = 0; i < vv1.size(); i++) {
+		if (std::find(vv2.begin(), vv2.end(), vv1[i]) != vv2.end()) {
+			cv.push_back(vv1[i]);
+			ca.push_back(i < va1.size() ? va1[i] : "");
+			keep.push_back(i);
+		}
+	}
+	caln = join(ca, "|");
+	return join(cv, "|");
+}
+
+static std::string consensusD(const std::string &d1, const std::string &d2) {
+	if (d1 == "---" && d2 == "---")
+		return "---";
+	if (d2 == "---")
+		return d1;
+	if (d1 == "---" || d1 == d2)
+		return d1 == "---" ? d2 : d1;
+	return "";
+}
+
+static std::string consensusJ(const std::string &j1, const std::string &j2) {
+	if (j2 == "---" || j1 == j2)
+		return j1;
+	return "";
+}
+
+// V:D:J of the better mate a (strictly regular) or its possible VJ recombination (non-regular)
+static void consensusVDJ(MateResult_t &a, MateResult_t &b, const bool first) {
+	std::vector<std::string> vdja = split(a.f[5], ':'), vdjb = split(b.f[5], ':');
+	vdja.resize(3);
+	vdjb.resize(3);
+	const std::vector<std::string> ia = split(a.f[7], ','), ib = split(b.f[7], ',');
+	const int vai = atoi(ia[0].c_str()), jai = ia.size() > 2 ? atoi(ia[2].c_str()) : 0;
+	const int vbi = atoi(ib[0].c_str()), jbi = ib.size() > 2 ? atoi(ib[2].c_str()) : 0;
+
+	const int reg = atoi(a.f[2].c_str());
+	if (reg == 2) {
+		// if orientation of the other mate is consistent
+		if (a.f[4] != b.f[4]) {
+			const int vk = index(a.aln.size(), vai);
+			std::string *va = vk >= 0 ? &a.aln[vk] : nullptr;
+			std::string caln;
+			std::vector<size_t> keep;
+			const std::string cv = consensusV(vdja[0], vdjb[0], va ? *va : "", caln, keep);
+			const std::string cd = consensusD(vdja[1], vdjb[1]);
+			const std::string cj = consensusJ(vdja[2], vdjb[2]);
+
+			// if the Vs, Ds, or Js are inconsistent, lower the regularity
+			if (cv.empty() || cd.empty() || cj.empty()) {
+				a.f[2] = "1";
+
+			// if the Vs and Js are consistent, deambiguity if possible
+			} else if (cv != vdja[0]) {
+				a.f[5] = cv + ":" + cd + ":" + cj;
+				if (va) {
+					*va = caln;
+					keepMembers(a, vk, keep);
+				} else {
+					a.aln.push_back(caln);
+					if (!a.ls.empty())
+						a.ls.emplace_back();
+				}
+				a.f[6] = join(a.aln, " ");
+			}
+		}
+	} else if (reg == 0) {
+		// D of read 1 first whichever mate is better
+		const std::string cd = first ? consensusD(vdja[1], vdjb[1]) : consensusD(vdjb[1], vdja[1]);
+		if (vai == -1 && vbi != -1 && jai != -1 && jbi == -1)
+			a.f[5] = vdjb[0] + ":" + cd + ":" + vdja[2];
+		else if (vai != -1 && vbi == -1 && jai == -1 && jbi != -1)
+			a.f[5] = vdja[0] + ":" + cd + ":" + vdjb[2];
+	}
+}
+
+// resolve the ambiguous alignments of a by the genes of the unambiguous b
+static void resolveAmbiguity(MateResult_t &a, const MateResult_t &b) {
+	std::map<std::string, int> gc;
+	std::string g;
+	for (const auto &t : b.aln) {
+		if (geneOf(t, g))
+			gc[g]++;
+	}
+	if (gc.empty())
+		return;
+
+	for (size_t k = 0; k < a.aln.size(); k++) {
+		std::string &t = a.aln[k];
+		if (t.find('|') == std::string::npos)
+			continue;
+		std::vector<std::string> ta = split(t, '|'), gs;
+		for (const auto &e : ta) {
+			if (geneOf(e, g))
+				gs.push_back(g);
+		}
+		if (gs.empty())
+			continue;
+		for (const auto &e : gs)
+			gc[e];
+		std::stable_sort(gs.begin(), gs.end(),
+				[&](const std::string &x, const std::string &y) { return gc[x] > gc[y]; });
+		const int c1 = gs.size() > 1 ? gc[gs[1]] : 0;
+		const char *sub = nullptr;
+		if (gc[gs[0]] > c1)
+			sub = gs[0].c_str();
+		else if (t.find('C') != std::string::npos && gc.count("J2") && gc["J2"])
+			sub = "C2";
+		if (sub) {
+			auto m = std::find_if(ta.begin(), ta.end(),
+					[&](const std::string &e) { return e.find(sub) != std::string::npos; });
+			t = m != ta.end() ? *m : "";
+			keepMembers(a, k, m != ta.end() ? std::vector<size_t>{ (size_t)(m - ta.begin()) } : std::vector<size_t>());
+		}
+	}
+	a.f[6] = join(a.aln, " ");
+}
+
+// read 1 is written first, i.e., the aligned mate or else the one with the longer alignment
+static bool firstMate(const MateResult_t &m1, const MateResult_t &m2) {
+	if (!m1.aligned() || !m2.aligned())
+		return !m2.aligned();
+	return atoi(m1.f[8].c_str()) >= atoi(m2.f[8].c_str());
+}
+
+// the mates in order, each preceded by its number (with the alignments of a and b in place of f[6], if any)
+static void printPair(std::ostream &out, const MateResult_t &a, const char *na, const MateResult_t &b, const char *nb,
+		const std::string *aa = nullptr, const std::string *ab = nullptr) {
+	out << a.f[0] << "\t" << na;
+	for (size_t i = 1; i < a.f.size(); i++)
+		out << "\t" << (i == 6 && aa ? *aa : a.f[i]);
+	out << "\t" << nb;
+	for (size_t i = 1; i < b.f.size(); i++)
+		out << "\t" << (i == 6 && ab ? *ab : b.f[i]);
+	out << "\n";
+}
+
+void PAIR_t::combineVDJ(MateResult_t &m1, MateResult_t &m2, std::ostream &out) {
+	const bool first = firstMate(m1, m2);
+
+	// if one of the mates is not aligned
+	if (!m1.aligned() || !m2.aligned()) {
+		if (first)
+			printPair(out, m1, "1", m2, "2");
+		else
+			printPair(out, m2, "2", m1, "1");
+		return;
+	}
+
+	// combine VDJ annotation based on the better alignment
+	if (first)
+		consensusVDJ(m1, m2, true);
+	else
+		consensusVDJ(m2, m1, false);
+
+	// resolve read1,2 ambiguity
+	const bool amb1 = m1.f[6].find('|') != std::string::npos;
+	const bool amb2 = m2.f[6].find('|') != std::string::npos;
+	if (amb1 && !amb2)
+		resolveAmbiguity(m1, m2);
+	else if (!amb1 && amb2)
+		resolveAmbiguity(m2, m1);
+
+	if (first)
+		printPair(out, m1, "1", m2, "2");
+	else
+		printPair(out, m2, "2", m1, "1");
+}
+
+void PAIR_t::labelVDJ(const MateResult_t &m1, const MateResult_t &m2, const RecombLabeler_t &rl, std::ostream &out) {
+	const bool first = firstMate(m1, m2);
+	const MateResult_t &a = first ? m1 : m2, &b = first ? m2 : m1;
+	if (!a.aligned())
+		return;
+
+	// the first category of the mates, read first on a tie
+	RecombLabel_t la, lb;
+	rl.label(a.ls, atoi(a.f[2].c_str()), la);
+	const RecombLabel_t *l = &la;
+	if (b.aligned()) {
+		rl.label(b.ls, atoi(b.f[2].c_str()), lb);
+		if (RecombLabel_t::order(lb.cat) < RecombLabel_t::order(la.cat))
+			l = &lb;
+	}
+	out << l->cat << "\t" << l->genes << "\t" << l->junction << "\t";
+	printPair(out, a, first ? "1" : "2", b, first ? "2" : "1", &la.aln, b.aligned() ? &lb.aln : nullptr);
+}
+
+void PAIR_t::combineCDR3(const std::string &c1, const std::string &c2, std::ostream &out) {
+	if (c1 == c2) {
+		out << c1;
+		return;
+	}
+
+	// the mate with a CDR3, else with a V:J, read 1 on a tie
+	std::string l1 = c1, l2 = c2;
+	if (!l1.empty() && l1.back() == '\n')
+		l1.pop_back();
+	if (!l2.empty() && l2.back() == '\n')
+		l2.pop_back();
+	const std::vector<std::string> a1 = split(l1, '\t'), a2 = split(l2, '\t');
+	const std::string n1 = a1.size() > 2 ? a1[2] : "", n2 = a2.size() > 2 ? a2[2] : "";
+	if (n1 == "---" && n2 == "---")
+		out << (a1.size() > 1 && a1[1] != "---" ? c1 : c2);
+	else if (n1 != "---" && n2 != "---")
+		out << c1;
+	else
+		out << (n1 != "---" ? c1 : c2);
+}
+
+//==================================================MateReader_t===
+
+void MateReader_t::open(const std::string &delta_path) {
+	mapq_m = delta_path != "-" && isRegularFile(delta_path);
+	if (mapq_m)
+		dmr_m.open(delta_path);
+	else
+		dsr_m.open(delta_path);
+
+	// fastq of the query fasta (e.g., um1_read.1.fq for um1_read.1.fa)
+	const std::string &qrypath_fa = mapq_m ? dmr_m.getQueryPath() : dsr_m.getQueryPath();
+	std::string qrypath_fq = qrypath_fa.substr(0, qrypath_fa.length()-2) + "fq";
+	if (!isRegularFile(qrypath_fq) && isRegularFile(qrypath_fq + ".gz"))
+		qrypath_fq += ".gz";
+	fr_m.open(qrypath_fq);
+
+	more_m = readNextQuery(next_m);
+}
+
+bool MateReader_t::next(QueryJob_t &job) {
+	if (!fr_m.readNext())
+		return false;
+
+	job.clear();
+	job.uid = fr_m.getUID();
+	job.seq = fr_m.getSEQ();
+	job.qua = fr_m.getQUA();
+	if (more_m && next_m.idQ == job.uid) {
+		job.found = true;
+		std::swap(job.rec, next_m);
+		next_m.clear();
+		more_m = readNextQuery(next_m);
+	}
+	return true;
+}
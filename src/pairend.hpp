@@ -0,0 +1,91 @@
+#ifndef PAIREND_HPP
+#define PAIREND_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "delta.hpp"
+#include "fastx_read.hpp"
+#include "querypool.hpp"
+
+/*
+  usage:
+  MateReader_t mr;
+  mr.open("um1_initial.1.delta");                 // and um1_read.1.fq (or .fq.gz) of its header
+  while (mr.next(job)) ...                        // each fastq entry with its delta records, if any
+  MateResult_t m1, m2;
+  m1.load(df);                                    // or m1.none(uid, len) for a read without alignments
+  PAIR_t::combineVDJ(m1, m2, OUT_V);              // as CombinePEVDJDelta.pl
+  PAIR_t::labelVDJ(m1, m2, rl, OUT_L);            // and its .lab line (mates loaded with labels)
+  PAIR_t::combineCDR3(c1, c2, OUT_C);             // as CombinePECDR3.pl (a .cdr3 line of each mate)
+*/
+
+//==================================================MateResult_t===
+
+// .vdjdelta fields of a mate: query, length, then "---", or regularity,
+// reference, orientation, V:D:J, alignments, V,D,J indices and alignment length
+struct MateResult_t {
+	std::vector<std::string> f;     // fields as joined by tabs
+	std::vector<std::string> aln;   // alignments (f[6] split by spaces)
+	LabelSet_t ls;                  // the same alignments with their members, if labelled
+
+	void load(const DeltaFilter_t &df, const bool label = false);
+	void none(const std::string &idQ, const size_t lenQ);
+
+	bool aligned() const {
+		return f.size() > 3;
+	}
+};
+
+//=====================================================PAIR_t===
+
+/* Consensus of the two mates of a pair, ported from CombinePEVDJDelta.pl
+ * (ConsensusV, ConsensusD and ConsensusJ) and CombinePECDR3.pl. The mate
+ * with the longer alignment (read 1 on a tie) comes first, each mate
+ * preceded by its number. Its .lab line takes the first category (in the
+ * order of RecombLabel_t::order) of the aligned mates, with the members
+ * kept by the consensus.
+ */
+
+namespace PAIR_t
+{
+	void combineVDJ(MateResult_t &m1, MateResult_t &m2, std::ostream &out);
+	void labelVDJ(const MateResult_t &m1, const MateResult_t &m2, const RecombLabeler_t &rl, std::ostream &out);
+	void combineCDR3(const std::string &c1, const std::string &c2, std::ostream &out);
+}
+
+//==================================================MateReader_t===
+
+// fastq entries of a mate in order, each with its records in the delta (in the same order)
+class MateReader_t
+{
+private:
+	bool mapq_m;                   // delta mapped (else streamed)
+	DeltaMapReader_t dmr_m;
+	DeltaReader_t dsr_m;
+	FastqReader_t fr_m;
+	DeltaRecord_t next_m;          // records of the next query in the delta
+	bool more_m;                   // next_m is valid
+
+	bool readNextQuery(DeltaRecord_t &rec) {
+		return mapq_m ? dmr_m.readNextQuery(rec) : dsr_m.readNextQuery(rec);
+	}
+
+public:
+	MateReader_t() {
+		mapq_m = more_m = false;
+	}
+
+	// the delta, then the fastq of the query fasta in its header
+	void open(const std::string &delta_path);
+
+	// next fastq entry into job, with an empty job.rec if it has no records
+	bool next(QueryJob_t &job);
+
+	const std::string &getReferencePath() const {
+		return mapq_m ? dmr_m.getReferencePath() : dsr_m.getReferencePath();
+	}
+};
+
+#endif /* pairend.hpp */
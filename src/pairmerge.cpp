@@ -0,0 +1,108 @@
+#include "pairmerge.hpp"
+#include "score.hpp"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+
+static inline char complement(const char c) {
+	switch (c) {
+		case 'A': return 'T';
+		case 'C': return 'G';
+		case 'G': return 'C';
+		case 'T': return 'A';
+		case 'a': return 't';
+		case 'c': return 'g';
+		case 'g': return 'c';
+		case 't': return 'a';
+		default:  return 'N';
+	}
+}
+
+// error probability of a Phred score, at most that of a random call
+static double errorOf(const int q) {
+	return std::min(pow(10.0, -q / 10.0), 0.75);
+}
+
+static uint8_t phredOf(const double p) {
+	const double q = p > 0 ? -10.0 * log10(p) : MERGE_QMAX;
+	return (uint8_t)std::min(std::max((int)lround(q), 0), MERGE_QMAX);
+}
+
+void PairMerger_t::tabulate() {
+	for (int a = 0; a < 64; a++) {
+		for (int b = 0; b < 64; b++) {
+			const double pa = errorOf(a), pb = errorOf(b);
+			// both calls wrong with the same base, over both agreeing
+			qagree_m[a][b] = phredOf((pa * pb / 3) / (1 - pa - pb + 4 * pa * pb / 3));
+			// call a wrong and b right, over the calls differing
+			qdiffer_m[a][b] = phredOf(pa * (1 - pb / 3) / (pa + pb - 4 * pa * pb / 3));
+		}
+	}
+}
+
+static inline int phred(const char c) {
+	return std::min(std::max(c - 33, 0), 63);
+}
+
+bool PairMerger_t::merge(const std::string &s1, const std::string &q1,
+		const std::string &s2, const std::string &q2,
+		std::string &seq, std::string &qua) const {
+	const int l1 = s1.size(), l2 = s2.size();
+	if (l1 < par_m.minovlen || l2 < par_m.minovlen)
+		return false;
+
+	// read 2 on the strand of read 1
+	static thread_local std::string r2, rq2;
+	r2.resize(l2);
+	rq2.resize(l2);
+	for (int i = 0; i < l2; i++) {
+		r2[i] = complement(s2[l2 - 1 - i]);
+		rq2[i] = q2[l2 - 1 - i];
+	}
+
+	// best overlap, read 2 starting at offset o of read 1
+	int best = -1, bscore = 0;
+	for (int o = std::max(0, l1 - l2); o <= l1 - par_m.minovlen; o++) {
+		if (o + l2 < par_m.minmergelen)
+			continue;
+		const int ovl = l1 - o;
+		const int diffs = SCORE_t::countMismatches(s1.data() + o, r2.data(), ovl);
+		if (diffs > par_m.maxdiffs || (ovl - diffs) * 100 < par_m.pctid * ovl)
+			continue;
+		const int score = ovl - 5 * diffs;
+		if (best < 0 || score > bscore) {
+			best = o;
+			bscore = score;
+		}
+	}
+	if (best < 0)
+		return false;
+
+	// read 1 before the overlap, the overlap, then read 2 after it
+	const int o = best, ovl = l1 - o;
+	seq.assign(s1, 0, o);
+	qua.assign(q1, 0, o);
+	for (int i = 0; i < ovl; i++) {
+		const char a = s1[o + i], b = r2[i];
+		const int qa = phred(q1[o + i]), qb = phred(rq2[i]);
+		if (a == b) {
+			seq += a;
+			qua += (char)(qagree_m[qa][qb] + 33);
+		} else if (a == 'N' || b == 'N') {
+			seq += a == 'N' ? b : a;
+			qua += a == 'N' ? rq2[i] : q1[o + i];
+		} else if (qa >= qb) {
+			seq += a;
+			qua += (char)(qdiffer_m[qa][qb] + 33);
+		} else {
+			seq += b;
+			qua += (char)(qdiffer_m[qb][qa] + 33);
+		}
+	}
+	seq.append(r2, ovl, l2 - ovl);
+	qua.append(rq2, ovl, l2 - ovl);
+	return true;
+}
@@ -0,0 +1,72 @@
+#ifndef PAIRMERGE_HPP
+#define PAIRMERGE_HPP
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+/*
+  usage:
+  PairMerger_t pm;                                   // usearch -fastq_mergepairs defaults of trig.pl
+  if (pm.merge(s1, q1, s2, q2, seq, qua)) ...        // read 2 as sequenced, qualities in Phred+33
+*/
+
+//=================================================MergeParam_t===
+
+// thresholds of a merge, as -fastq_minovlen, -fastq_minmergelen, -fastq_pctid and -fastq_maxdiffs
+struct MergeParam_t {
+	int minovlen;      // minimal overlap
+	int minmergelen;   // minimal length of the merged read
+	int pctid;         // minimal identity (%) of the overlap
+	int maxdiffs;      // maximal mismatches in the overlap
+
+	MergeParam_t() {
+		minovlen = 20;
+		minmergelen = 30;
+		pctid = 90;
+		maxdiffs = 10;
+	}
+};
+
+//==================================================PairMerger_t===
+
+/* Read 1 is overlapped with the reverse complement of read 2 on every
+ * offset where read 2 starts within read 1 and ends at or after it
+ * (staggered pairs are not merged), the mismatches of each overlap are
+ * counted with SCORE_t::countMismatches, and the overlap passing the
+ * thresholds with the best matches - 4 * mismatches (the longest on a tie)
+ * is taken. A merged base has the posterior error of the two calls given
+ * their qualities (the better call when they differ), capped at Q41.
+ */
+
+#define MERGE_QMAX 41
+
+class PairMerger_t
+{
+private:
+	MergeParam_t par_m;
+	uint8_t qagree_m[64][64];      // merged quality of two agreeing calls
+	uint8_t qdiffer_m[64][64];     // merged quality of the better of two differing calls
+
+	void tabulate();
+
+public:
+	PairMerger_t() {
+		tabulate();
+	}
+	PairMerger_t(const MergeParam_t &par) {
+		par_m = par;
+		tabulate();
+	}
+
+	// merged read of a pair into seq and qua, false if they do not merge
+	bool merge(const std::string &s1, const std::string &q1,
+			const std::string &s2, const std::string &q2,
+			std::string &seq, std::string &qua) const;
+
+	const MergeParam_t &param() const {
+		return par_m;
+	}
+};
+
+#endif /* pairmerge.hpp */
@@ -0,0 +1,251 @@
+#include "patch.hpp"
+#include "score.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+static inline char upper(const char c) {
+	return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+static inline char complement(const char c) {
+	switch (upper(c)) {
+		case 'A': return 'T';
+		case 'C': return 'G';
+		case 'G': return 'C';
+		case 'T': return 'A';
+		default:  return 'N';
+	}
+}
+
+// bases match only if they are the same ACGT
+static inline bool same(const char a, const char b) {
+	return a == b && a != 'N';
+}
+
+//================================================AlignPatcher_t===
+
+void AlignPatcher_t::load(const SymbolTable_t &st, const RefStore_t &rs, const int minmatch) {
+	minmatch_m = minmatch;
+	j_m.clear();
+	c_m.clear();
+
+	// the Js, and the first exon of each C if numbered 1 (a C0 after a J is not regular, see
+	// annotateQuery, e.g., IGKC)
+	for (int c = 0; c < st.numContigs(); c++) {
+		const ContigSym_t &cs = st.contig(c);
+		if (!rs.has(cs.name))
+			continue;
+		for (int e = cs.first; e < cs.last; e++) {
+			const ExonSym_t &x = st.exon(e);
+			const char cls = st.gene(x.gene).cls;
+			if (cls != 'J' && (cls != 'C' || x.num != '1'))
+				continue;
+			PatchEntry_t p;
+			p.ctg = cs.name;
+			p.start = x.start;
+			rs.subseq(cs.name, x.start, x.end, p.seq);
+			std::transform(p.seq.begin(), p.seq.end(), p.seq.begin(), upper);
+			(cls == 'J' ? j_m : c_m).push_back(std::move(p));
+		}
+	}
+}
+
+bool AlignPatcher_t::traceHit(const PatchEntry_t &e, std::string_view rq, const int qe, const int re,
+		const int fs, const int fe, const bool rev, DeltaAlignment_t &a, std::pmr::memory_resource *mr) const {
+	// scores and moves of rows 0..qe on diagonals j-i within PATCH_BAND of the end
+	// ('M', 'I' and 'D' as in SeedAligner_t, 0 at a start), column k for diagonal d0+k-PATCH_BAND
+	const int w = 2 * PATCH_BAND + 1;
+	const int d0 = re - qe;
+	const char *r = e.seq.data();
+	std::pmr::vector<int> h((qe + 1) * w, 0, mr);
+	std::pmr::string mv((qe + 1) * w, '\0', mr);
+	for (int i = 1; i <= qe; i++) {
+		for (int k = 0; k < w; k++) {
+			const int j = i + d0 + k - PATCH_BAND;
+			if (j < 1 || j > re)
+				continue;
+			int best = 0;
+			char m = '\0';
+			const int s = h[(i-1)*w + k] + (same(rq[i-1], r[j-1]) ? MSC : MMSC);
+			if (s > best) {
+				best = s;
+				m = 'M';
+			}
+			if (k + 1 < w && h[(i-1)*w + k+1] + GSC > best) {
+				best = h[(i-1)*w + k+1] + GSC;
+				m = 'I';
+			}
+			if (k > 0 && h[i*w + k-1] + GSC > best) {
+				best = h[i*w + k-1] + GSC;
+				m = 'D';
+			}
+			h[i*w + k] = best;
+			mv[i*w + k] = m;
+		}
+	}
+	if (h[qe*w + PATCH_BAND] <= 0)
+		return false;
+
+	// columns from the end back to a start
+	std::pmr::string ops(mr);
+	int i = qe, k = PATCH_BAND;
+	while (mv[i*w + k]) {
+		const char m = mv[i*w + k];
+		ops += m;
+		if (m == 'M') {
+			i--;
+		} else if (m == 'I') {
+			i--;
+			k++;
+		} else {
+			k--;
+		}
+	}
+	std::reverse(ops.begin(), ops.end());
+	const int qs = i, rs = i + d0 + k - PATCH_BAND;
+
+	// deltas and the number of mismatches and gaps, as in SeedAligner_t::extendChain
+	a.clear();
+	int qi = qs, ri = rs;
+	int run = 0, mism = 0;
+	int gapT = 0;   // total gaps
+	int gapQ = 0;   // query gaps
+	for (const char t : ops) {
+		if (t == 'M') {
+			mism += !same(rq[qi], r[ri]);
+			qi++;
+			ri++;
+			run++;
+		} else if (t == 'D') {
+			a.deltas.push_back(run + 1);
+			ri++;
+			run = 0;
+			gapQ++;
+			gapT++;
+		} else {
+			a.deltas.push_back(-(run + 1));
+			qi++;
+			run = 0;
+			gapT++;
+		}
+	}
+	a.deltas.push_back(0);
+
+	a.idR = e.ctg;
+	a.sR = e.start + rs;
+	a.eR = e.start + ri - 1;
+	a.sQ = rev ? fe - qs : fs + qs;
+	a.eQ = rev ? fe - qi + 1 : fs + qi - 1;
+	a.mmgp = mism + gapT;
+
+	// as read from a delta file
+	a.ro = a.sQ < a.eQ ? '+' : '-';
+	a.go = a.ro;
+	a.osQ = a.sQ < a.eQ ? a.sQ : a.eQ;
+	a.oeQ = a.sQ < a.eQ ? a.eQ : a.sQ;
+	a.alQ = a.oeQ - a.osQ + 1;
+
+	int mismatch = a.mmgp - gapT;
+	int match    = a.alQ + gapQ - a.mmgp;
+	a.id         = match / (float)(a.alQ + gapQ);
+	a.sc         = match * MSC + mismatch * MMSC + gapT * GSC;
+	return true;
+}
+
+bool AlignPatcher_t::alignFlank(const std::vector<PatchEntry_t> &panel, std::string_view q, const int fs, const int fe,
+		const bool rev, DeltaRecord_t &rec, std::pmr::memory_resource *mr) const {
+	const int n = panel.size();
+	if (n == 0 || fe - fs + 1 < minmatch_m)
+		return false;
+
+	// the flank on the strand of the panel
+	std::pmr::string rq(mr);
+	for (int i = fs; i <= fe; i++)
+		rq += rev ? complement(q[fe + fs - i - 1]) : upper(q[i-1]);
+
+	std::pmr::vector<const char *> rs(n, mr);
+	std::pmr::vector<int> rl(n, 0, mr), sc(n, 0, mr), qe(n, 0, mr), re(n, 0, mr);
+	for (int k = 0; k < n; k++) {
+		rs[k] = panel[k].seq.data();
+		rl[k] = panel[k].seq.size();
+	}
+	SCORE_t::localScores(rq.data(), rq.size(), rs.data(), rl.data(), n, sc.data(), qe.data(), re.data());
+	const int best = *std::max_element(sc.begin(), sc.end());
+	if (best < PATCH_MINLEN * MSC)
+		return false;
+
+	// each best hit after the alignments of its contig, unless already there
+	bool added = false;
+	for (int k = 0; k < n; k++) {
+		DeltaAlignment_t a;
+		if (sc[k] != best || !traceHit(panel[k], rq, qe[k], re[k], fs, fe, rev, a, mr) || a.alQ < PATCH_MINLEN)
+			continue;
+		auto pos = rec.aligns.end();
+		bool dup = false;
+		for (auto it = rec.aligns.begin(); it != rec.aligns.end(); it++) {
+			if (it->idR != a.idR)
+				continue;
+			dup |= it->sR == a.sR && it->eR == a.eR && it->sQ == a.sQ && it->eQ == a.eQ;
+			pos = it + 1;
+		}
+		if (dup)
+			continue;
+		rec.aligns.insert(pos, std::move(a));
+		added = true;
+	}
+	return added;
+}
+
+bool AlignPatcher_t::patch(const DeltaFilter_t &df, DeltaRecord_t &rec, std::pmr::memory_resource *mr) const {
+	const AlignTable_t &t = df.getTAB();
+	const std::pmr::vector<int> &aln = df.getALN();
+	const SymbolTable_t &st = DeltaFilter_t::symbols_m;
+	std::string_view q = df.qryseq_m;
+	const char ori = df.getORI();
+	const int na = aln.size();
+	if (na == 0 || q.empty() || (ori != '+' && ori != '-'))
+		return false;
+	const bool rev = ori == '-';
+
+	// the query after row k in VDJ order, up to the next row or the query end
+	auto flank = [&](const int k, int &fs, int &fe) {
+		const int r = aln[k];
+		if (rev) {
+			fs = k + 1 < na ? t.oeQ[aln[k+1]] + 1 : 1;
+			fe = t.osQ[r] - 1;
+		} else {
+			fs = t.oeQ[r] + 1;
+			fe = k + 1 < na ? t.osQ[aln[k+1]] - 1 : (int)q.size();
+		}
+	};
+	auto cls = [&](const int k) {
+		return st.firstGene(t.ex0[aln[k]]).cls;
+	};
+
+	int fs, fe;
+	if (df.getJi() == -1) {
+		// a J after the last V or D, before a C if any
+		int k = na - 1;
+		while (k >= 0 && t.ge[aln[k]] != GE('V', '0') && t.ge[aln[k]] != GE('V', '2') && t.ge[aln[k]] != GE('D', '0'))
+			k--;
+		if (k < 0 || (k + 1 < na && cls(k + 1) != 'C'))
+			return false;
+		flank(k, fs, fe);
+		return alignFlank(j_m, q, fs, fe, rev, rec, mr);
+	}
+
+	// a C after a J (or an intergenic piece after it) at the end
+	for (int k = 0; k < na; k++) {
+		if (cls(k) == 'C')
+			return false;
+	}
+	const int ge = t.ge[aln[na-1]];
+	if (ge != GE('J', '0') && ge != GE('I', '0'))
+		return false;
+	flank(na - 1, fs, fe);
+	return alignFlank(c_m, q, fs, fe, rev, rec, mr);
+}
@@ -0,0 +1,76 @@
+#ifndef PATCH_HPP
+#define PATCH_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+
+#include "delta.hpp"
+
+/*
+  usage:
+  AlignPatcher_t ap;
+  ap.load(DeltaFilter_t::symbols_m, DeltaFilter_t::refseq_m, 15);   // J and C panels (minimal flank 15)
+  ...
+  df.annotateQuery();
+  if (ap.patch(df, rec, &arena))   // a J or a C added to rec
+      df.load(rec);                // filter again from getOptimalSet
+*/
+
+//==================================================PatchEntry_t===
+
+// a J or the first exon of a C (C1) on a reference contig
+struct PatchEntry_t {
+	std::string ctg;   // reference contig ID
+	int start;         // start on the reference
+	std::string seq;   // uppercase sequence of the exon
+};
+
+//================================================AlignPatcher_t===
+
+/* In place of PatchAlignment.pl: a query with a V (or a D) but no J, or
+ * ending with a J (or an intergenic piece) without a C, has the part of
+ * it after that alignment in VDJ order (up to the next alignment or the
+ * end of the query, at least minmatch bases) aligned locally to all the
+ * Js (or C1 exons) of the gene table at once, one per 16-bit lane of
+ * SCORE_t::localScores. The best hits (all of them on ties, e.g., TRBC1
+ * and TRBC2) are traced back within PATCH_BAND diagonals of their end and
+ * added to the query as delta alignments on the reference contig, so that
+ * the DeltaFilter_t steps see them as if from nucmer. A hit needs
+ * PATCH_MINLEN query bases and a score of PATCH_MINLEN matches.
+ */
+
+#define PATCH_MINLEN 15   // query bases of a hit (qal of ublast in PatchAlignment.pl)
+#define PATCH_BAND   8    // diagonals on each side of the end of a hit in its traceback
+
+class AlignPatcher_t
+{
+private:
+	std::vector<PatchEntry_t> j_m;   // J panel
+	std::vector<PatchEntry_t> c_m;   // C panel
+	int minmatch_m;                  // minimal flank
+
+	// best hits of the flank [fs, fe] (1-based on the query, reverse complemented if rev)
+	// added to rec, false if none
+	bool alignFlank(const std::vector<PatchEntry_t> &panel, std::string_view q, const int fs, const int fe,
+			const bool rev, DeltaRecord_t &rec, std::pmr::memory_resource *mr) const;
+
+	// traceback of the hit of the flank rq (as in alignFlank) on e ending before qe and re, into a
+	bool traceHit(const PatchEntry_t &e, std::string_view rq, const int qe, const int re,
+			const int fs, const int fe, const bool rev, DeltaAlignment_t &a, std::pmr::memory_resource *mr) const;
+
+public:
+	AlignPatcher_t() {
+		minmatch_m = PATCH_MINLEN;
+	}
+
+	void load(const SymbolTable_t &st, const RefStore_t &rs, const int minmatch);
+
+	// after annotateQuery (qryseq_m set), a J or a C added to rec; false if none
+	bool patch(const DeltaFilter_t &df, DeltaRecord_t &rec,
+			std::pmr::memory_resource *mr = std::pmr::get_default_resource()) const;
+};
+
+#endif /* patch.hpp */
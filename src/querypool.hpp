@@ -0,0 +1,68 @@
+#ifndef QUERYPOOL_HPP
+#define QUERYPOOL_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "delta.hpp"
+#include "orderedpool.hpp"
+
+/*
+  usage:
+  QueryPool_t pool(threads, ProcessBatch, {&OUT_V, &OUT_C, &OUT_L});   // (nullptr if not labelled)
+  pool.push(batch);   // batches are processed by workers in any order
+  pool.finish();      // and written in the order they were pushed
+*/
+
+//====================================================QueryJob_t===
+
+// all delta records of a query and its fastq entry
+struct QueryJob_t {
+	DeltaRecord_t rec;    // merged delta records of the query
+	bool found;           // query sequence found in fastq
+	std::string uid;      // fastq entry paired with the query
+	std::string seq;
+	std::string qua;
+	std::string skip_v;   // output of preceding fastq entries without delta information
+	std::string skip_c;
+
+	QueryJob_t() {
+		clear();
+	}
+
+	void clear() {
+		rec.clear();
+		found = false;
+		uid.erase();
+		seq.erase();
+		qua.erase();
+		skip_v.erase();
+		skip_c.erase();
+	}
+};
+
+//==================================================QueryBatch_t===
+
+// consecutive queries processed by one worker
+struct QueryBatch_t {
+	size_t serial;                  // input order of the batch
+	std::vector<QueryJob_t> jobs;
+	std::vector<std::string> out;   // .vdjdelta, .cdr3 and .lab lines of the batch (if labelled)
+
+	QueryBatch_t() {
+		clear();
+	}
+
+	void clear() {
+		serial = 0;
+		jobs.clear();
+		out.clear();
+	}
+};
+
+//===================================================QueryPool_t===
+
+typedef OrderedPool_t<QueryBatch_t> QueryPool_t;
+
+#endif /* querypool.hpp */
@@ -0,0 +1,135 @@
+#include "refstore.hpp"
+#include "fastx_read.hpp"
+#include "bundle.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+
+// 2-bit code of a base, -1 if not ACGT (case-insensitive)
+static inline int baseCode(const char c) {
+	switch (c | 0x20) {
+		case 'a': return 0;
+		case 'c': return 1;
+		case 'g': return 2;
+		case 't': return 3;
+		default:  return -1;
+	}
+}
+
+void RefStore_t::load(const std::string &fasta_path) {
+	FastaReader_t fr;
+	fr.open(fasta_path);
+	while (fr.readNext())
+		add(fr.getUID(), fr.getSEQ());
+}
+
+void RefStore_t::add(const std::string &id, const std::string &seq) {
+	RefContig_t &c = contig_m[id];
+	c.len = seq.size();
+	c.bases_v.assign((c.len + 31) / 32, 0);
+	c.lower_v.assign((c.len + 63) / 64, 0);
+	c.opos_v.clear();
+	c.obase_v.clear();
+
+	for (int i = 0; i < c.len; i++) {
+		const char b = seq[i];
+		int code = baseCode(b);
+		if (code < 0) {
+			c.opos_v.push_back(i);
+			c.obase_v.push_back(b);
+			code = 0;
+		}
+		c.bases_v[i >> 5] |= (uint64_t)code << ((i & 31) * 2);
+		if (b >= 'a' && b <= 'z')
+			c.lower_v[i >> 6] |= (uint64_t)1 << (i & 63);
+	}
+
+	// the node of a contig stays in place, so do its views
+	c.bases = c.bases_v.data();
+	c.lower = c.lower_v.data();
+	c.opos = c.opos_v.data();
+	c.obase = c.obase_v.data();
+	c.nother = c.opos_v.size();
+}
+
+void RefStore_t::save(BundleWriter_t &out) const {
+
+	// contigs in name order
+	std::vector<std::string> ids;
+	for (auto &c : contig_m)
+		ids.push_back(c.first);
+	std::sort(ids.begin(), ids.end());
+
+	out.put<uint32_t>(ids.size());
+	for (auto &id : ids) {
+		const RefContig_t &c = contig_m.at(id);
+		out.putString(id);
+		out.put<int32_t>(c.len);
+		out.put<int32_t>(c.nother);
+		out.putArray(c.bases, (c.len + 31) / 32);
+		out.putArray(c.lower, (c.len + 63) / 64);
+		out.putArray(c.opos, c.nother);
+		out.putArray(c.obase, c.nother);
+	}
+}
+
+void RefStore_t::map(BundleReader_t &in) {
+	contig_m.clear();
+	const uint32_t n = in.get<uint32_t>();
+	for (uint32_t k = 0; k < n; k++) {
+		RefContig_t &c = contig_m[in.getString()];
+		c.len = in.get<int32_t>();
+		c.nother = in.get<int32_t>();
+		c.bases = in.getArray<uint64_t>((c.len + 31) / 32);
+		c.lower = in.getArray<uint64_t>((c.len + 63) / 64);
+		c.opos = in.getArray<int32_t>(c.nother);
+		c.obase = in.getArray<char>(c.nother);
+	}
+}
+
+size_t RefStore_t::span(const RefContig_t &c, const int str, const int end) const {
+
+	// same bounds as std::string::substr
+	const int pos = str - 1;
+	if (pos < 0 || pos > c.len)
+		throw std::out_of_range("RefStore_t::subseq");
+	return std::min((size_t)(end - str + 1), (size_t)(c.len - pos));
+}
+
+void RefStore_t::decode(const RefContig_t &c, const int pos, const size_t len, char *o) const {
+	static const char ACGT[4] = {'A', 'C', 'G', 'T'};
+	char *const out = o;
+	int i = pos;
+	const int e = pos + len;
+	while (i < e) {
+
+		// decode the rest of the current word
+		uint64_t w = c.bases[i >> 5] >> ((i & 31) * 2);
+		uint64_t m = c.lower[i >> 6] >> (i & 63);
+		const int n = std::min(e - i, std::min(32 - (i & 31), 64 - (i & 63)));
+		for (int k = 0; k < n; k++) {
+			*o++ = ACGT[w & 3] | ((m & 1) << 5);
+			w >>= 2;
+			m >>= 1;
+		}
+		i += n;
+	}
+
+	// restore non-ACGT bases
+	for (int k = std::lower_bound(c.opos, c.opos + c.nother, pos) - c.opos; k < c.nother && c.opos[k] < e; k++)
+		out[c.opos[k] - pos] = c.obase[k];
+}
+
+size_t RefStore_t::bytes() const {
+	size_t n = 0;
+	for (auto &c : contig_m) {
+		n += (c.second.len + 31) / 32 * sizeof(uint64_t);
+		n += (c.second.len + 63) / 64 * sizeof(uint64_t);
+		n += c.second.nother * (sizeof(int32_t) + sizeof(char));
+	}
+	return n;
+}
@@ -0,0 +1,94 @@
+#ifndef REFSTORE_HPP
+#define REFSTORE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+  usage:
+  RefStore_t rs;
+  rs.load("hsa_trb.fa");
+  rs.subseq("hsa_trb", 101, 200, seg);   // decode into a reusable buffer
+*/
+
+class BundleWriter_t;
+class BundleReader_t;
+
+// a reference contig packed 2 bits per base, in its own storage or a mapped bundle
+struct RefContig_t {
+	int len;                  // contig length
+	const uint64_t *bases;    // 32 bases per word (A=0, C=1, G=2, T=3)
+	const uint64_t *lower;    // soft mask, 64 bases per word (1: lowercase)
+	const int32_t *opos;      // positions of non-ACGT bases (e.g., N), ascending
+	const char *obase;        // and the bases
+	int nother;
+
+	// storage of a contig added from its sequence
+	std::vector<uint64_t> bases_v, lower_v;
+	std::vector<int32_t> opos_v;
+	std::vector<char> obase_v;
+
+	RefContig_t() {
+		len = nother = 0;
+		bases = lower = NULL;
+		opos = NULL;
+		obase = NULL;
+	}
+};
+
+// reference sequences stored 2-bit packed, decoded on demand
+class RefStore_t
+{
+private:
+	std::unordered_map<std::string, RefContig_t> contig_m;
+
+	// length of [str, end] on a contig (same bounds as std::string::substr)
+	size_t span(const RefContig_t &c, const int str, const int end) const;
+
+	// decode len bases from pos (0-based) into o
+	void decode(const RefContig_t &c, const int pos, const size_t len, char *o) const;
+
+public:
+	void load(const std::string &fasta_path);
+	void add(const std::string &id, const std::string &seq);
+
+	// write the contigs to a bundle section, or view them in a mapped one
+	void save(BundleWriter_t &out) const;
+	void map(BundleReader_t &in);
+	void clear() {
+		contig_m.clear();
+	}
+
+	bool has(const std::string &id) const {
+		return contig_m.find(id) != contig_m.end();
+	}
+	int length(const std::string &id) const {
+		return contig_m.at(id).len;
+	}
+
+	// subsequence (position start from 1, same bounds as FASTA_t::subseq) decoded into out,
+	// a std::string or a std::pmr::string
+	template <class String>
+	void subseq(const std::string &id, const int str, const int end, String &out) const {
+		const RefContig_t &c = contig_m.at(id);
+		out.resize(span(c, str, end));
+		decode(c, str - 1, out.size(), &out[0]);
+	}
+
+	// the same written to out (with room for end-str+1 bases), return the length
+	size_t subseq(const std::string &id, const int str, const int end, char *out) const {
+		const RefContig_t &c = contig_m.at(id);
+		const size_t n = span(c, str, end);
+		decode(c, str - 1, n, out);
+		return n;
+	}
+
+	// memory held by the packed contigs
+	size_t bytes() const;
+};
+
+#endif /* refstore.hpp */
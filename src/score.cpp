@@ -0,0 +1,413 @@
+#include "score.hpp"
+#include "delta.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+//========================================================scalar===
+
+static inline int8_t columnScore(const char r, const char q) {
+	if (r == '_' || q == '_')
+		return GSC;
+	if (r == q)
+		return MSC + EXB;
+	if (r - 32 == q)
+		return MSC;
+	return MMSC;
+}
+
+static inline char upper(const char c) {
+	return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+#define LOCAL_PAD -1000   // score of a lane past the end of its reference
+
+static inline int baseCode(const char c) {
+	switch (upper(c)) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+		default:  return 4;
+	}
+}
+
+// scores of L lanes, query base code c against lane k at position j in prof[(c*m + j)*L + k]
+static void localProfile(const char *const *rs, const int *rl, const int n, const int L, const int m, int16_t *prof) {
+	for (int c = 0; c < 5; c++) {
+		for (int j = 0; j < m; j++) {
+			for (int k = 0; k < L; k++) {
+				int16_t s = LOCAL_PAD;
+				if (k < n && j < rl[k])
+					s = (c < 4 && baseCode(rs[k][j]) == c) ? MSC : MMSC;
+				prof[(c*m + j)*L + k] = s;
+			}
+		}
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* Lanes are combined with and/andnot/or (no blendv in SSE2). Comparing
+ * r with q+32 only for q < 96 keeps the 8-bit sum from wrapping, so it is
+ * the same test as r-32 == q on ints.
+ */
+
+//==========================================================SSE2===
+
+static inline __m128i select16(const __m128i m, const __m128i a, const __m128i b) {
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+static inline __m128i columnScores16(const __m128i r, const __m128i q) {
+	const __m128i gap = _mm_or_si128(_mm_cmpeq_epi8(r, _mm_set1_epi8('_')), _mm_cmpeq_epi8(q, _mm_set1_epi8('_')));
+	const __m128i eq = _mm_cmpeq_epi8(r, q);
+	const __m128i lo = _mm_and_si128(_mm_cmpeq_epi8(r, _mm_add_epi8(q, _mm_set1_epi8(32))),
+			_mm_cmplt_epi8(q, _mm_set1_epi8(96)));
+	__m128i s = select16(lo, _mm_set1_epi8(MSC), _mm_set1_epi8(MMSC));
+	s = select16(eq, _mm_set1_epi8(MSC + EXB), s);
+	return select16(gap, _mm_set1_epi8(GSC), s);
+}
+
+static inline __m128i upper16(const __m128i x) {
+	const __m128i az = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('z' + 1)));
+	return _mm_sub_epi8(x, _mm_and_si128(az, _mm_set1_epi8(32)));
+}
+
+// 4 int8 at p as int32
+static inline __m128i load4(const int8_t *p) {
+	int w;
+	memcpy(&w, p, 4);
+	__m128i x = _mm_cvtsi32_si128(w);
+	x = _mm_unpacklo_epi8(x, x);
+	x = _mm_unpacklo_epi16(x, x);
+	return _mm_srai_epi32(x, 24);
+}
+
+// local alignment of 8 lanes, out as 8 scores, 8 query ends and 8 reference ends
+static void localBlock8(const char *q, const int nq, const int16_t *prof, const int m, int16_t *h, int16_t *out) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i gap = _mm_set1_epi16(GSC);
+	__m128i vmax = zero, vi = zero, vj = zero;
+	std::fill(h, h + m * 8, 0);
+	for (int i = 0; i < nq; i++) {
+		const int16_t *p = prof + baseCode(q[i]) * m * 8;
+		const __m128i ii = _mm_set1_epi16(i + 1);
+		__m128i diag = zero, left = zero;
+		for (int j = 0; j < m; j++) {
+			const __m128i up = _mm_loadu_si128((const __m128i *)(h + j * 8));
+			__m128i x = _mm_adds_epi16(diag, _mm_loadu_si128((const __m128i *)(p + j * 8)));
+			x = _mm_max_epi16(x, _mm_adds_epi16(_mm_max_epi16(up, left), gap));
+			x = _mm_max_epi16(x, zero);
+			_mm_storeu_si128((__m128i *)(h + j * 8), x);
+			const __m128i gt = _mm_cmpgt_epi16(x, vmax);
+			vmax = _mm_max_epi16(x, vmax);
+			vi = select16(gt, ii, vi);
+			vj = select16(gt, _mm_set1_epi16(j + 1), vj);
+			diag = up;
+			left = x;
+		}
+	}
+	_mm_storeu_si128((__m128i *)out, vmax);
+	_mm_storeu_si128((__m128i *)(out + 8), vi);
+	_mm_storeu_si128((__m128i *)(out + 16), vj);
+}
+
+//==========================================================AVX2===
+
+__attribute__((target("avx2")))
+static inline __m256i select32(const __m256i m, const __m256i a, const __m256i b) {
+	return _mm256_blendv_epi8(b, a, m);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i columnScores32(const __m256i r, const __m256i q) {
+	const __m256i gap = _mm256_or_si256(_mm256_cmpeq_epi8(r, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(q, _mm256_set1_epi8('_')));
+	const __m256i eq = _mm256_cmpeq_epi8(r, q);
+	const __m256i lo = _mm256_and_si256(_mm256_cmpeq_epi8(r, _mm256_add_epi8(q, _mm256_set1_epi8(32))),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8(96), q));
+	__m256i s = select32(lo, _mm256_set1_epi8(MSC), _mm256_set1_epi8(MMSC));
+	s = select32(eq, _mm256_set1_epi8(MSC + EXB), s);
+	return select32(gap, _mm256_set1_epi8(GSC), s);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i upper32(const __m256i x) {
+	const __m256i az = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('a' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), x));
+	return _mm256_sub_epi8(x, _mm256_and_si256(az, _mm256_set1_epi8(32)));
+}
+
+__attribute__((target("avx2")))
+static int columnScoresAVX2(const char *ra, const char *qa, const int n, int8_t *sc) {
+	int i = 0;
+	for (; i + 32 <= n; i += 32) {
+		const __m256i r = _mm256_loadu_si256((const __m256i *)(ra + i));
+		const __m256i q = _mm256_loadu_si256((const __m256i *)(qa + i));
+		_mm256_storeu_si256((__m256i *)(sc + i), columnScores32(r, q));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int spliceBonusAVX2(const char *s, const int n, const char c0, const char c1, int8_t *bn) {
+	int i = 0;
+	for (; i + 33 <= n; i += 32) {
+		const __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(s + i)), _mm256_set1_epi8((char)0xDF));
+		const __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(s + i + 1)), _mm256_set1_epi8((char)0xDF));
+		const __m256i m = _mm256_and_si256(_mm256_cmpeq_epi8(a, _mm256_set1_epi8(c0)), _mm256_cmpeq_epi8(b, _mm256_set1_epi8(c1)));
+		_mm256_storeu_si256((__m256i *)(bn + i), _mm256_and_si256(m, _mm256_set1_epi8(SPC)));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int countMismatchesAVX2(const char *ra, const char *qa, const int n, int &i) {
+	int c = 0;
+	for (i = 0; i + 32 <= n; i += 32) {
+		const __m256i r = upper32(_mm256_loadu_si256((const __m256i *)(ra + i)));
+		const __m256i q = _mm256_loadu_si256((const __m256i *)(qa + i));
+		c += 32 - __builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, q)));
+	}
+	return c;
+}
+
+// running prefix sums of 8 values per step, keeping the first max of each lane
+__attribute__((target("avx2")))
+static int maxPrefixAVX2(const int8_t *d, const int8_t *bn, const int n, int &sum, int &best, int &pos) {
+	__m256i carry = _mm256_set1_epi32(sum);
+	__m256i vmax = _mm256_set1_epi32(INT_MIN);
+	__m256i vpos = _mm256_set1_epi32(INT_MAX);
+	__m256i idx = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+	int k = 0;
+	for (; k + 8 <= n; k += 8) {
+		__m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(d + k)));
+		x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+		x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+		x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_setzero_si256(),
+					_mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(3)), 0xF0));
+		x = _mm256_add_epi32(x, carry);
+		carry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+
+		const __m256i v = _mm256_add_epi32(x, _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(bn + k + 1))));
+		const __m256i gt = _mm256_cmpgt_epi32(v, vmax);
+		vmax = select32(gt, v, vmax);
+		vpos = select32(gt, idx, vpos);
+		idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+	}
+	sum = _mm256_extract_epi32(carry, 0);
+
+	int lmax[8], lpos[8];
+	_mm256_storeu_si256((__m256i *)lmax, vmax);
+	_mm256_storeu_si256((__m256i *)lpos, vpos);
+	for (int l = 0; l < 8; l++) {
+		if (lmax[l] > best || (lmax[l] == best && lpos[l] < pos)) {
+			best = lmax[l];
+			pos = lpos[l];
+		}
+	}
+	return k;
+}
+
+// local alignment of 16 lanes, as localBlock8
+__attribute__((target("avx2")))
+static void localBlock16(const char *q, const int nq, const int16_t *prof, const int m, int16_t *h, int16_t *out) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i gap = _mm256_set1_epi16(GSC);
+	__m256i vmax = zero, vi = zero, vj = zero;
+	std::fill(h, h + m * 16, 0);
+	for (int i = 0; i < nq; i++) {
+		const int16_t *p = prof + baseCode(q[i]) * m * 16;
+		const __m256i ii = _mm256_set1_epi16(i + 1);
+		__m256i diag = zero, left = zero;
+		for (int j = 0; j < m; j++) {
+			const __m256i up = _mm256_loadu_si256((const __m256i *)(h + j * 16));
+			__m256i x = _mm256_adds_epi16(diag, _mm256_loadu_si256((const __m256i *)(p + j * 16)));
+			x = _mm256_max_epi16(x, _mm256_adds_epi16(_mm256_max_epi16(up, left), gap));
+			x = _mm256_max_epi16(x, zero);
+			_mm256_storeu_si256((__m256i *)(h + j * 16), x);
+			const __m256i gt = _mm256_cmpgt_epi16(x, vmax);
+			vmax = _mm256_max_epi16(x, vmax);
+			vi = select32(gt, ii, vi);
+			vj = select32(gt, _mm256_set1_epi16(j + 1), vj);
+			diag = up;
+			left = x;
+		}
+	}
+	_mm256_storeu_si256((__m256i *)out, vmax);
+	_mm256_storeu_si256((__m256i *)(out + 16), vi);
+	_mm256_storeu_si256((__m256i *)(out + 32), vj);
+}
+
+static bool hasAVX2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+static const bool HAS_AVX2 = hasAVX2();
+
+#else
+
+// local alignment of one lane, out as score, query end, reference end
+static void localBlock1(const char *q, const int nq, const int16_t *prof, const int m, int16_t *h, int16_t *out) {
+	int best = 0, bi = 0, bj = 0;
+	std::fill(h, h + m, 0);
+	for (int i = 0; i < nq; i++) {
+		const int16_t *p = prof + baseCode(q[i]) * m;
+		int diag = 0, left = 0;
+		for (int j = 0; j < m; j++) {
+			const int up = h[j];
+			const int x = std::max(std::max(diag + p[j], 0), std::max(up, left) + GSC);
+			h[j] = x;
+			if (x > best) {
+				best = x;
+				bi = i + 1;
+				bj = j + 1;
+			}
+			diag = up;
+			left = x;
+		}
+	}
+	out[0] = best;
+	out[1] = bi;
+	out[2] = bj;
+}
+
+#endif
+
+//=========================================================SCORE_t===
+
+void SCORE_t::columnScores(const char *ra, const char *qa, const int n, int8_t *sc) {
+	int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2)
+		i = columnScoresAVX2(ra, qa, n, sc);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i r = _mm_loadu_si128((const __m128i *)(ra + i));
+		const __m128i q = _mm_loadu_si128((const __m128i *)(qa + i));
+		_mm_storeu_si128((__m128i *)(sc + i), columnScores16(r, q));
+	}
+#endif
+	for (; i < n; i++)
+		sc[i] = columnScore(ra[i], qa[i]);
+}
+
+void SCORE_t::spliceBonus(const char *s, const int n, const char c0, const char c1, int8_t *bn) {
+	int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2)
+		i = spliceBonusAVX2(s, n, c0, c1, bn);
+	for (; i + 17 <= n; i += 16) {
+		const __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(s + i)), _mm_set1_epi8((char)0xDF));
+		const __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(s + i + 1)), _mm_set1_epi8((char)0xDF));
+		const __m128i m = _mm_and_si128(_mm_cmpeq_epi8(a, _mm_set1_epi8(c0)), _mm_cmpeq_epi8(b, _mm_set1_epi8(c1)));
+		_mm_storeu_si128((__m128i *)(bn + i), _mm_and_si128(m, _mm_set1_epi8(SPC)));
+	}
+#endif
+	for (; i + 1 < n; i++)
+		bn[i] = (upper(s[i]) == c0 && upper(s[i+1]) == c1) ? SPC : 0;
+}
+
+int SCORE_t::maxPrefixPosition(const int8_t *d, const int8_t *bn, const int n) {
+	int sum = 0;
+	int best = bn[0];
+	int pos = 0;
+	int k = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2) {
+		k = maxPrefixAVX2(d, bn, n, sum, best, pos);
+	} else {
+		__m128i carry = _mm_setzero_si128();
+		__m128i vmax = _mm_set1_epi32(INT_MIN);
+		__m128i vpos = _mm_set1_epi32(INT_MAX);
+		__m128i idx = _mm_setr_epi32(1, 2, 3, 4);
+		for (; k + 4 <= n; k += 4) {
+			__m128i x = load4(d + k);
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carry);
+			carry = _mm_shuffle_epi32(x, 0xFF);
+
+			const __m128i v = _mm_add_epi32(x, load4(bn + k + 1));
+			const __m128i gt = _mm_cmpgt_epi32(v, vmax);
+			vmax = select16(gt, v, vmax);
+			vpos = select16(gt, idx, vpos);
+			idx = _mm_add_epi32(idx, _mm_set1_epi32(4));
+		}
+		sum = _mm_cvtsi128_si32(carry);
+
+		int lmax[4], lpos[4];
+		_mm_storeu_si128((__m128i *)lmax, vmax);
+		_mm_storeu_si128((__m128i *)lpos, vpos);
+		for (int l = 0; l < 4; l++) {
+			if (lmax[l] > best || (lmax[l] == best && lpos[l] < pos)) {
+				best = lmax[l];
+				pos = lpos[l];
+			}
+		}
+	}
+#endif
+	for (; k < n; k++) {
+		sum += d[k];
+		if (sum + bn[k+1] > best) {
+			best = sum + bn[k+1];
+			pos = k + 1;
+		}
+	}
+	return pos;
+}
+
+int SCORE_t::countMismatches(const char *ra, const char *qa, const int n) {
+	int c = 0;
+	int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (HAS_AVX2)
+		c = countMismatchesAVX2(ra, qa, n, i);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i r = upper16(_mm_loadu_si128((const __m128i *)(ra + i)));
+		const __m128i q = _mm_loadu_si128((const __m128i *)(qa + i));
+		c += 16 - __builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(r, q)));
+	}
+#endif
+	for (; i < n; i++)
+		c += upper(ra[i]) != qa[i];
+	return c;
+}
+
+void SCORE_t::localScores(const char *q, const int nq, const char *const *rs, const int *rl, const int n,
+		int *sc, int *qe, int *re) {
+	int L = 1;
+#if defined(__x86_64__) || defined(__i386__)
+	L = HAS_AVX2 ? 16 : 8;
+#endif
+	static thread_local std::vector<int16_t> prof, h;
+	int16_t out[48];
+	for (int b = 0; b < n; b += L) {
+		const int nb = std::min(L, n - b);
+		const int m = *std::max_element(rl + b, rl + b + nb);
+		prof.resize(5 * m * L);
+		h.resize(m * L);
+		localProfile(rs + b, rl + b, nb, L, m, prof.data());
+#if defined(__x86_64__) || defined(__i386__)
+		if (HAS_AVX2)
+			localBlock16(q, nq, prof.data(), m, h.data(), out);
+		else
+			localBlock8(q, nq, prof.data(), m, h.data(), out);
+#else
+		localBlock1(q, nq, prof.data(), m, h.data(), out);
+#endif
+		for (int k = 0; k < nb; k++) {
+			sc[b+k] = out[k];
+			qe[b+k] = out[L+k];
+			re[b+k] = out[2*L+k];
+		}
+	}
+}
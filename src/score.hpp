@@ -0,0 +1,41 @@
+#ifndef SCORE_HPP
+#define SCORE_HPP
+
+#include <cstdint>
+
+/*
+  usage:
+  SCORE_t::columnScores(ra, qa, n, sc);                 // per column of an aligned segment
+  SCORE_t::spliceBonus(rs, n+2, 'G', 'T', bn);          // donor (or 'A', 'G' acceptor) sites
+  int k = SCORE_t::maxPrefixPosition(d, bn, n);         // breakpoint with the max score
+  int mm = SCORE_t::countMismatches(ra, qa, n);
+  SCORE_t::localScores(q, nq, rs, rl, n, sc, qe, re);    // q against each of n references
+  (AVX2 or SSE2 chosen at run time, scalar elsewhere)
+*/
+
+namespace SCORE_t
+{
+	// score of each column of an aligned reference ra and query qa ('_' for gap):
+	// GSC for a gap, MSC+EXB for the same base, MSC for a lowercase (e.g., soft-masked)
+	// reference base matching the query, and MMSC otherwise
+	void columnScores(const char *ra, const char *qa, const int n, int8_t *sc);
+
+	// bn[i] = SPC if s[i..i+1] is c0 c1 (case-insensitive), 0 otherwise, for i < n-1
+	void spliceBonus(const char *s, const int n, const char c0, const char c1, int8_t *bn);
+
+	// first k in [0, n] maximizing d[0] + ... + d[k-1] + bn[k]
+	int maxPrefixPosition(const int8_t *d, const int8_t *bn, const int n);
+
+	// number of columns where the uppercased reference base differs from the query
+	int countMismatches(const char *ra, const char *qa, const int n);
+
+	// best local alignment (MSC, MMSC and linear GSC, case-insensitive, N mismatching) of the
+	// query q against each reference rs[k] of length rl[k]: score sc[k] (0 if none), ending
+	// before query position qe[k] and reference position re[k] (the first best cell, by query
+	// then by reference position); the references run side by side in 16-bit lanes, so nq and
+	// the rl[k] are below 32768
+	void localScores(const char *q, const int nq, const char *const *rs, const int *rl, const int n,
+			int *sc, int *qe, int *re);
+}
+
+#endif /* score.hpp */
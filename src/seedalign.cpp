@@ -0,0 +1,445 @@
+#include "seedalign.hpp"
+#include "fastx_read.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <numeric>
+#include <tuple>
+
+static const int   MAXGAP     = 90;     // longest gap between chained matches (nucmer -g)
+static const int   DIAGDIFF   = 5;      // diagonal difference allowed for any gap (nucmer -D)
+static const float DIAGFACTOR = 0.12;   // diagonal difference as a fraction of the gap (nucmer -d)
+static const int   EXTBAND    = 8;      // diagonals on either side searched by an extension
+static const int   NEGINF     = INT_MIN / 2;
+
+
+// 2-bit code of an (uppercase) base, -1 if not ACGT
+static inline int baseCode(const char c) {
+	switch (c) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+		default:  return -1;
+	}
+}
+
+static inline char upper(const char c) {
+	return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+// bases match only if they are the same ACGT
+static inline bool same(const char a, const char b) {
+	return a == b && baseCode(a) >= 0;
+}
+
+//=====================================================alignment===
+
+/* Columns are built as 'M' (a query base against a reference base), 'I'
+ * (a query base against a gap) and 'D' (a reference base against a gap),
+ * with ties broken in that order.
+ */
+
+// global alignment of a[0..na) and b[0..nb), columns appended to ops
+static void alignGap(const char *a, const int na, const char *b, const int nb,
+		std::pmr::string &ops, std::pmr::memory_resource *mr) {
+	const int w = nb + 1;
+	std::pmr::vector<int> h((na+1) * w, 0, mr);
+	std::pmr::vector<char> tr((na+1) * w, 'M', mr);
+	for (int j = 1; j <= nb; j++) {
+		h[j] = j * GSC;
+		tr[j] = 'D';
+	}
+	for (int i = 1; i <= na; i++) {
+		h[i*w] = i * GSC;
+		tr[i*w] = 'I';
+		for (int j = 1; j <= nb; j++) {
+			int s = h[(i-1)*w + j-1] + (same(a[i-1], b[j-1]) ? MSC : MMSC);
+			char t = 'M';
+			if (h[(i-1)*w + j] + GSC > s) {
+				s = h[(i-1)*w + j] + GSC;
+				t = 'I';
+			}
+			if (h[i*w + j-1] + GSC > s) {
+				s = h[i*w + j-1] + GSC;
+				t = 'D';
+			}
+			h[i*w + j] = s;
+			tr[i*w + j] = t;
+		}
+	}
+
+	// trace back
+	const size_t o = ops.size();
+	int i = na, j = nb;
+	while (i > 0 || j > 0) {
+		const char t = tr[i*w + j];
+		ops += t;
+		if (t != 'D')
+			i--;
+		if (t != 'I')
+			j--;
+	}
+	std::reverse(ops.begin() + o, ops.end());
+}
+
+/* The extension from an end of a chain walks away from it, i.e. a[i*dir]
+ * and b[j*dir] are the i-th query and j-th reference bases, within
+ * EXTBAND diagonals. It stops once breaklen query bases have passed the
+ * best score and ends at the best score (the first reached), so it is
+ * empty unless the score rises above 0.
+ */
+
+// columns of the extension (from the chain outwards) into ops
+static void extendEnd(const char *a, const int na, const char *b, const int nb, const int dir,
+		const int breaklen, std::pmr::string &ops, std::pmr::memory_resource *mr) {
+	const int W = 2 * EXTBAND + 1;   // cell (i, j) at i*W + j-i+EXTBAND
+	std::pmr::vector<int> prv(W, NEGINF, mr), cur(W, NEGINF, mr);
+	std::pmr::vector<char> tr(W, 'M', mr);
+
+	for (int j = 0; j <= std::min(nb, EXTBAND); j++) {
+		prv[j+EXTBAND] = j * GSC;
+		tr[j+EXTBAND] = 'D';
+	}
+	int best = 0, bi = 0, bj = 0;
+	for (int i = 1; i <= na; i++) {
+		const int lo = std::max(0, i - EXTBAND);
+		const int hi = std::min(nb, i + EXTBAND);
+		if (lo > hi)
+			break;
+		tr.resize((i+1) * W, 'M');
+		std::fill(cur.begin(), cur.end(), NEGINF);
+		for (int j = lo; j <= hi; j++) {
+			const int k = j - i + EXTBAND;
+			int s = NEGINF;
+			char t = 'M';
+			if (j > 0 && prv[k] != NEGINF)
+				s = prv[k] + (same(a[(i-1)*dir], b[(j-1)*dir]) ? MSC : MMSC);
+			if (k+1 < W && prv[k+1] != NEGINF && prv[k+1] + GSC > s) {
+				s = prv[k+1] + GSC;
+				t = 'I';
+			}
+			if (k > 0 && j > lo && cur[k-1] + GSC > s) {
+				s = cur[k-1] + GSC;
+				t = 'D';
+			}
+			cur[k] = s;
+			tr[i*W + k] = t;
+			if (s > best) {
+				best = s;
+				bi = i;
+				bj = j;
+			}
+		}
+		std::swap(prv, cur);
+		if (i - bi > breaklen)
+			break;
+	}
+
+	// trace back
+	const size_t o = ops.size();
+	int i = bi, j = bj;
+	while (i > 0 || j > 0) {
+		const char t = tr[i*W + j-i+EXTBAND];
+		ops += t;
+		if (t != 'D')
+			i--;
+		if (t != 'I')
+			j--;
+	}
+	std::reverse(ops.begin() + o, ops.end());
+}
+
+//=================================================SeedAligner_t===
+
+void SeedAligner_t::build(const std::string &fasta_path, const int minmatch) {
+	if (minmatch < 1) {
+		std::cerr << "\033[31mERROR:\033[0m Minimal match must be positive, " << minmatch << std::endl;
+		exit(1);
+	}
+	minmatch_m = minmatch;
+	kmer_m = std::min(minmatch, 16);
+
+	// references in file order
+	FastaReader_t fr;
+	fr.open(fasta_path);
+	while (fr.readNext()) {
+		const std::string &seq = fr.getSEQ();
+		ids_m.push_back(fr.getUID());
+		offs_m.push_back(text_m.size());
+		lens_m.push_back(seq.size());
+		for (const char c : seq)
+			text_m += upper(c);
+		text_m += '$';
+	}
+
+	// k-mers of ACGT only
+	const uint64_t mask = ((uint64_t)1 << (2 * kmer_m)) - 1;
+	uint64_t code = 0;
+	int valid = 0;
+	kmers_m.clear();
+	for (int p = 0; p < (int)text_m.size(); p++) {
+		const int b = baseCode(text_m[p]);
+		if (b < 0) {
+			valid = 0;
+			continue;
+		}
+		code = ((code << 2) | b) & mask;
+		if (++valid >= kmer_m)
+			kmers_m.push_back(code << 32 | (uint64_t)(p - kmer_m + 1));
+	}
+	std::sort(kmers_m.begin(), kmers_m.end());
+
+	// first k-mer of each prefix of the code
+	pbits_m = std::min(2 * kmer_m, 20);
+	bucket_m.assign(((size_t)1 << pbits_m) + 1, 0);
+	for (const uint64_t x : kmers_m)
+		bucket_m[((x >> 32) >> (2 * kmer_m - pbits_m)) + 1]++;
+	for (size_t i = 1; i < bucket_m.size(); i++)
+		bucket_m[i] += bucket_m[i-1];
+}
+
+void SeedAligner_t::findMatches(std::string_view q, std::pmr::vector<SeedMatch_t> &mt) const {
+	const uint64_t mask = ((uint64_t)1 << (2 * kmer_m)) - 1;
+	const int nq = q.size();
+	uint64_t code = 0;
+	int valid = 0;
+	for (int i = 0; i < nq; i++) {
+		const int b = baseCode(q[i]);
+		if (b < 0) {
+			valid = 0;
+			continue;
+		}
+		code = ((code << 2) | b) & mask;
+		if (++valid < kmer_m)
+			continue;
+
+		// k-mers of the reference with the same code
+		const int s = i - kmer_m + 1;
+		const uint64_t pre = code >> (2 * kmer_m - pbits_m);
+		auto x = std::lower_bound(kmers_m.begin() + bucket_m[pre], kmers_m.begin() + bucket_m[pre+1],
+				code << 32);
+		for (; x != kmers_m.end() && (*x >> 32) == code; x++) {
+			const int p = *x & 0xffffffff;
+
+			// found once, at the start of the maximal match
+			if (s > 0 && p > 0 && same(q[s-1], text_m[p-1]))
+				continue;
+			int len = kmer_m;
+			while (s + len < nq && same(q[s+len], text_m[p+len]))
+				len++;
+			if (len >= minmatch_m)
+				mt.push_back(SeedMatch_t{s, p, len});
+		}
+	}
+}
+
+/* Matches (sorted by query, then reference) are chained when both ends
+ * advance, the gap is at most MAXGAP and the diagonals differ by at most
+ * max(DIAGDIFF, DIAGFACTOR * gap), scoring matched bases with overlaps
+ * removed. The best chain is taken and the rest chained again, until a
+ * chain has fewer than minmatch bases.
+ */
+
+// chains of m[0..n) as indices in chain, each starting at cb[c]
+void SeedAligner_t::chainMatches(std::pmr::vector<SeedMatch_t> &m, std::pmr::vector<int> &chain,
+		std::pmr::vector<int> &cb, std::pmr::memory_resource *mr) const {
+	const int n = m.size();
+	std::pmr::vector<int> sc(n, 0, mr), from(n, -1, mr);
+	std::pmr::vector<char> used(n, 0, mr);
+	chain.clear();
+	cb.clear();
+	while (true) {
+		int best = -1;
+		for (int i = 0; i < n; i++) {
+			if (used[i])
+				continue;
+			sc[i] = m[i].len;
+			from[i] = -1;
+			const int qe = m[i].q + m[i].len, re = m[i].r + m[i].len;
+			for (int j = 0; j < i; j++) {
+				if (used[j] || m[j].q >= m[i].q || m[j].r >= m[i].r)
+					continue;
+				const int qej = m[j].q + m[j].len, rej = m[j].r + m[j].len;
+				if (qej >= qe || rej >= re)
+					continue;
+				const int gap = std::max(m[i].q - qej, m[i].r - rej);
+				const int dd = std::abs((m[i].r - m[i].q) - (m[j].r - m[j].q));
+				if (gap > MAXGAP || dd > std::max((float)DIAGDIFF, DIAGFACTOR * gap))
+					continue;
+				const int s = sc[j] + m[i].len - std::max(0, std::max(qej - m[i].q, rej - m[i].r));
+				if (s > sc[i]) {
+					sc[i] = s;
+					from[i] = j;
+				}
+			}
+			if (best == -1 || sc[i] > sc[best])
+				best = i;
+		}
+		if (best == -1 || sc[best] < minmatch_m)
+			break;
+
+		cb.push_back(chain.size());
+		for (int i = best; i != -1; i = from[i]) {
+			chain.push_back(i);
+			used[i] = 1;
+		}
+		std::reverse(chain.begin() + cb.back(), chain.end());
+	}
+}
+
+// alignment of the chain m[0..n) (on the reverse strand of the query if rev)
+void SeedAligner_t::extendChain(std::string_view q, const SeedMatch_t *m, const int n, const bool rev,
+		DeltaAlignment_t &a, std::pmr::memory_resource *mr) const {
+	const char *rt = text_m.data();
+	const int c = std::upper_bound(offs_m.begin(), offs_m.end(), m[0].r) - offs_m.begin() - 1;
+	const int cs = offs_m[c], ce = cs + lens_m[c];
+	const int nq = q.size();
+
+	// matches and the gaps between them
+	std::pmr::string ops(mr);
+	int qs = m[0].q, rs = m[0].r;
+	int qe = qs + m[0].len, re = rs + m[0].len;
+	ops.append(m[0].len, 'M');
+	for (int k = 1; k < n; k++) {
+		const int ov = std::max(0, std::max(qe - m[k].q, re - m[k].r));
+		const int qk = m[k].q + ov, rk = m[k].r + ov;
+		alignGap(q.data() + qe, qk - qe, rt + re, rk - re, ops, mr);
+		ops.append(m[k].len - ov, 'M');
+		qe = qk + m[k].len - ov;
+		re = rk + m[k].len - ov;
+	}
+
+	// extend both ends
+	std::pmr::string ext(mr);
+	extendEnd(q.data() + qs - 1, qs, rt + rs - 1, rs - cs, -1, minmatch_m, ext, mr);
+	for (const char t : ext) {
+		qs -= t != 'D';
+		rs -= t != 'I';
+	}
+	std::reverse(ext.begin(), ext.end());
+	ops.insert(0, ext);
+	extendEnd(q.data() + qe, nq - qe, rt + re, ce - re, 1, minmatch_m, ops, mr);
+
+	// deltas and the number of mismatches and gaps
+	a.clear();
+	int qi = qs, ri = rs;
+	int run = 0, mism = 0;
+	int gapT = 0;   // total gaps
+	int gapQ = 0;   // query gaps
+	for (const char t : ops) {
+		if (t == 'M') {
+			mism += !same(q[qi], rt[ri]);
+			qi++;
+			ri++;
+			run++;
+		} else if (t == 'D') {
+			a.deltas.push_back(run + 1);
+			ri++;
+			run = 0;
+			gapQ++;
+			gapT++;
+		} else {
+			a.deltas.push_back(-(run + 1));
+			qi++;
+			run = 0;
+			gapT++;
+		}
+	}
+	a.deltas.push_back(0);
+
+	a.idR = ids_m[c];
+	a.sR = rs - cs + 1;
+	a.eR = ri - cs;
+	a.sQ = rev ? nq - qs : qs + 1;
+	a.eQ = rev ? nq - qi + 1 : qi;
+	a.mmgp = mism + gapT;
+
+	// as read from a delta file
+	a.ro = a.sQ < a.eQ ? '+' : '-';
+	a.go = a.ro;
+	a.osQ = a.sQ < a.eQ ? a.sQ : a.eQ;
+	a.oeQ = a.sQ < a.eQ ? a.eQ : a.sQ;
+	a.alQ = a.oeQ - a.osQ + 1;
+
+	int mismatch = a.mmgp - gapT;
+	int match    = a.alQ + gapQ - a.mmgp;
+	a.id         = match / (float)(a.alQ + gapQ);
+	a.sc         = match * MSC + mismatch * MMSC + gapT * GSC;
+}
+
+void SeedAligner_t::align(const std::string &seq, DeltaRecord_t &rec, std::pmr::memory_resource *mr) const {
+	rec.idR.erase();
+	rec.lenR = 0;
+	rec.aligns.clear();
+
+	// both strands of the query, uppercase
+	std::pmr::string fq(seq.size(), ' ', mr), rq(mr);
+	std::transform(seq.begin(), seq.end(), fq.begin(), upper);
+	FASTA_t::revcom(fq, rq);
+
+	std::pmr::vector<SeedMatch_t> mt(mr), sub(mr), cm(mr);
+	std::pmr::vector<int> chain(mr), cb(mr);
+	std::pmr::vector<int> ctg(mr);   // contig of each alignment
+	for (int rev = 0; rev <= 1; rev++) {
+		std::string_view q = rev ? std::string_view(rq) : std::string_view(fq);
+		mt.clear();
+		findMatches(q, mt);
+
+		// by contig, then along the query
+		auto contigOf = [&](const SeedMatch_t &x) {
+			return std::upper_bound(offs_m.begin(), offs_m.end(), x.r) - offs_m.begin() - 1;
+		};
+		std::sort(mt.begin(), mt.end(), [&](const SeedMatch_t &x, const SeedMatch_t &y) {
+			const int cx = contigOf(x), cy = contigOf(y);
+			if (cx != cy)
+				return cx < cy;
+			return x.q != y.q ? x.q < y.q : x.r < y.r;
+		});
+
+		for (size_t b = 0, e; b < mt.size(); b = e) {
+			const int c = contigOf(mt[b]);
+			for (e = b + 1; e < mt.size() && contigOf(mt[e]) == c; e++);
+			sub.assign(mt.begin() + b, mt.begin() + e);
+			chainMatches(sub, chain, cb, mr);
+			for (size_t k = 0; k < cb.size(); k++) {
+				const int ke = k + 1 < cb.size() ? cb[k+1] : chain.size();
+				cm.clear();
+				for (int i = cb[k]; i < ke; i++)
+					cm.push_back(sub[chain[i]]);
+				rec.aligns.emplace_back();
+				extendChain(q, cm.data(), cm.size(), rev, rec.aligns.back(), mr);
+				ctg.push_back(c);
+			}
+		}
+	}
+
+	// by reference, then by coordinates, without duplicates
+	std::pmr::vector<int> ord(rec.aligns.size(), 0, mr);
+	std::iota(ord.begin(), ord.end(), 0);
+	auto key = [&](const int i) {
+		const DeltaAlignment_t &a = rec.aligns[i];
+		return std::make_tuple(ctg[i], a.sR, a.eR, a.osQ, a.oeQ, a.ro);
+	};
+	std::sort(ord.begin(), ord.end(), [&](const int x, const int y) {
+		return key(x) < key(y);
+	});
+	std::vector<DeltaAlignment_t> aligns;
+	aligns.reserve(ord.size());
+	for (size_t k = 0; k < ord.size(); k++) {
+		if (k > 0 && key(ord[k]) == key(ord[k-1]))
+			continue;
+		aligns.push_back(std::move(rec.aligns[ord[k]]));
+	}
+	rec.aligns.swap(aligns);
+
+	// a record of one reference keeps its ID, as from the delta file
+	if (!ord.empty() && ctg[ord.front()] == ctg[ord.back()]) {
+		rec.idR = ids_m[ctg[ord.front()]];
+		rec.lenR = lens_m[ctg[ord.front()]];
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef SEEDALIGN_HPP
+#define SEEDALIGN_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory_resource>
+
+#include "delta.hpp"
+
+/*
+  usage:
+  SeedAligner_t sa;
+  sa.build("hsa_trb.fa", 15);       // index the references (minimal match 15)
+  sa.align(seq, rec, &arena);       // alignments of a read into rec, as read from a nucmer delta
+*/
+
+//===================================================SeedMatch_t===
+
+// maximal exact match between a strand of the query and the reference text
+struct SeedMatch_t {
+	int q;     // start on the query strand (0-based)
+	int r;     // start on the reference text (0-based)
+	int len;   // length
+};
+
+//=================================================SeedAligner_t===
+
+/* In place of nucmer --maxmatch -l m -c m -b m: all maximal exact matches
+ * of at least m bases on both strands are chained along the diagonals of
+ * each reference (a chain of at least m matched bases), the gaps between
+ * them are aligned globally, and the ends are extended until the score has
+ * not improved for m query bases. Alignments use the MSC, MMSC and GSC of
+ * delta.hpp and are written as delta records (1-based, query end before
+ * start on the reverse strand).
+ */
+
+class SeedAligner_t
+{
+private:
+	int minmatch_m;                    // minimal length of a match, a chain and an extension break
+	int kmer_m;                        // length of the indexed k-mers (at most 16)
+	int pbits_m;                       // bits of a k-mer code looked up in bucket_m
+	std::string text_m;                // references (uppercase) each followed by '$'
+	std::vector<std::string> ids_m;    // reference contig IDs in file order
+	std::vector<int> offs_m;           // start of each contig in text_m
+	std::vector<int> lens_m;           // length of each contig
+	std::vector<uint64_t> kmers_m;     // k-mer code << 32 | position in text_m, sorted
+	std::vector<uint32_t> bucket_m;    // first k-mer of each code prefix
+
+	void findMatches(std::string_view q, std::pmr::vector<SeedMatch_t> &mt) const;
+	void chainMatches(std::pmr::vector<SeedMatch_t> &mt, std::pmr::vector<int> &chain,
+			std::pmr::vector<int> &cb, std::pmr::memory_resource *mr) const;
+	void extendChain(std::string_view q, const SeedMatch_t *m, const int n, const bool rev,
+			DeltaAlignment_t &a, std::pmr::memory_resource *mr) const;
+
+public:
+	SeedAligner_t() {
+		minmatch_m = kmer_m = pbits_m = 0;
+	}
+
+	void build(const std::string &fasta_path, const int minmatch);
+
+	// all alignments of seq (rec.idQ and rec.lenQ are kept)
+	void align(const std::string &seq, DeltaRecord_t &rec,
+			std::pmr::memory_resource *mr = std::pmr::get_default_resource()) const;
+
+	int size() const {
+		return ids_m.size();
+	}
+};
+
+#endif /* seedalign.hpp */
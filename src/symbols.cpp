@@ -0,0 +1,193 @@
+#include "symbols.hpp"
+#include "bundle.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+
+int SymbolTable_t::internGene(const std::string &name) {
+	auto g = gene_id_m.find(name);
+	if (g != gene_id_m.end())
+		return g->second;
+
+	GeneSym_t gs;
+	gs.name = name;
+	gs.chain = name.size() > 2 ? name[2] : '\0';
+	gs.cls = name.size() > 3 ? name[3] : '\0';
+	gs.sub = name.size() > 4 ? name[4] : '\0';
+	gs.cdr3 = -1;
+	genes_m.push_back(gs);
+	gene_id_m[name] = genes_m.size() - 1;
+	return genes_m.size() - 1;
+}
+
+int SymbolTable_t::internExonName(const std::string &name) {
+	auto e = exon_name_id_m.find(name);
+	if (e != exon_name_id_m.end())
+		return e->second;
+
+	exon_names_m.push_back(name);
+	exon_name_id_m[name] = exon_names_m.size() - 1;
+	return exon_names_m.size() - 1;
+}
+
+void SymbolTable_t::build(const std::unordered_map< std::string, std::vector<VDJInfo_t> > &info,
+		const std::map<std::string, int> &cdr3p) {
+
+	// contigs in name order
+	std::vector<std::string> names;
+	for (auto &c : info)
+		names.push_back(c.first);
+	std::sort(names.begin(), names.end());
+
+	for (auto &n : names) {
+		const std::vector<VDJInfo_t> &vi = info.at(n);
+		ContigSym_t cs;
+		cs.name = n;
+		cs.first = exons_m.size();
+		for (auto &v : vi) {
+			ExonSym_t es;
+			es.name = internExonName(v.vdj_exon);
+			es.gene = internGene(v.vdj);
+			es.num = v.vdj_exon.back();
+			es.start = v.exon_start;
+			es.end = v.exon_end;
+			exons_m.push_back(es);
+		}
+		cs.last = exons_m.size();
+
+		// intergenic region of the locus, e.g., TRBI and TRBI_0
+		const std::string gene = vi.empty() ? n : vi[0].gene;
+		ExonSym_t is;
+		is.name = internExonName(gene + "I_0");
+		is.gene = internGene(gene + "I");
+		is.num = '0';
+		is.start = is.end = 0;
+		exons_m.push_back(is);
+		cs.inter = exons_m.size() - 1;
+
+		contig_id_m[n] = contigs_m.size();
+		contigs_m.push_back(cs);
+	}
+
+	// CDR3 anchors
+	for (auto &c : cdr3p) {
+		auto g = gene_id_m.find(c.first);
+		if (g != gene_id_m.end())
+			genes_m[g->second].cdr3 = c.second;
+	}
+
+	auto v30 = gene_id_m.find("TRBV30");
+	trbv30 = v30 == gene_id_m.end() ? -1 : v30->second;
+	auto c1 = gene_id_m.find("TRBC1");
+	trbc1 = c1 == gene_id_m.end() ? -1 : c1->second;
+}
+
+void SymbolTable_t::save(BundleWriter_t &out) const {
+	out.put<uint32_t>(contigs_m.size());
+	for (auto &c : contigs_m) {
+		out.putString(c.name);
+		out.put<int32_t>(c.first);
+		out.put<int32_t>(c.last);
+		out.put<int32_t>(c.inter);
+	}
+	out.put<uint32_t>(genes_m.size());
+	for (auto &g : genes_m) {
+		out.putString(g.name);
+		out.put<char>(g.cls);
+		out.put<char>(g.chain);
+		out.put<char>(g.sub);
+		out.put<int32_t>(g.cdr3);
+	}
+	out.put<uint32_t>(exon_names_m.size());
+	for (auto &n : exon_names_m)
+		out.putString(n);
+	out.put<uint32_t>(exons_m.size());
+	for (auto &e : exons_m) {
+		out.put<int32_t>(e.name);
+		out.put<int32_t>(e.gene);
+		out.put<char>(e.num);
+		out.put<int32_t>(e.start);
+		out.put<int32_t>(e.end);
+	}
+	out.put<int32_t>(trbv30);
+	out.put<int32_t>(trbc1);
+}
+
+void SymbolTable_t::map(BundleReader_t &in) {
+	contigs_m.resize(in.get<uint32_t>());
+	contig_id_m.clear();
+	for (size_t i = 0; i < contigs_m.size(); i++) {
+		ContigSym_t &c = contigs_m[i];
+		c.name = in.getString();
+		c.first = in.get<int32_t>();
+		c.last = in.get<int32_t>();
+		c.inter = in.get<int32_t>();
+		contig_id_m[c.name] = i;
+	}
+	genes_m.resize(in.get<uint32_t>());
+	gene_id_m.clear();
+	for (size_t i = 0; i < genes_m.size(); i++) {
+		GeneSym_t &g = genes_m[i];
+		g.name = in.getString();
+		g.cls = in.get<char>();
+		g.chain = in.get<char>();
+		g.sub = in.get<char>();
+		g.cdr3 = in.get<int32_t>();
+		gene_id_m[g.name] = i;
+	}
+	exon_names_m.resize(in.get<uint32_t>());
+	exon_name_id_m.clear();
+	for (size_t i = 0; i < exon_names_m.size(); i++) {
+		exon_names_m[i] = in.getString();
+		exon_name_id_m[exon_names_m[i]] = i;
+	}
+	exons_m.resize(in.get<uint32_t>());
+	for (auto &e : exons_m) {
+		e.name = in.get<int32_t>();
+		e.gene = in.get<int32_t>();
+		e.num = in.get<char>();
+		e.start = in.get<int32_t>();
+		e.end = in.get<int32_t>();
+	}
+	trbv30 = in.get<int32_t>();
+	trbc1 = in.get<int32_t>();
+}
+
+bool SymbolTable_t::sameGenes(const int a0, const int a1, const int b0, const int b1) const {
+	if (a1 - a0 != b1 - b0)
+		return false;
+	for (int k = 0; k <= a1 - a0; k++) {
+		if (exons_m[a0+k].gene != exons_m[b0+k].gene)
+			return false;
+	}
+	return true;
+}
+
+bool SymbolTable_t::sameExons(const int a0, const int a1, const int b0, const int b1) const {
+	if (a1 - a0 != b1 - b0)
+		return false;
+	for (int k = 0; k <= a1 - a0; k++) {
+		if (exons_m[a0+k].name != exons_m[b0+k].name)
+			return false;
+	}
+	return true;
+}
+
+std::string SymbolTable_t::vdjName(const int e0, const int e1) const {
+	std::string n = genes_m[exons_m[e0].gene].name;
+	for (int e = e0+1; e <= e1; e++)
+		n += "~" + genes_m[exons_m[e].gene].name;
+	return n;
+}
+
+std::string SymbolTable_t::vdjeName(const int e0, const int e1) const {
+	std::string n = exon_names_m[exons_m[e0].name];
+	for (int e = e0+1; e <= e1; e++)
+		n += "~" + exon_names_m[exons_m[e].name];
+	return n;
+}
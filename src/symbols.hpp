@@ -0,0 +1,136 @@
+#ifndef SYMBOLS_HPP
+#define SYMBOLS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include "vdjreader.hpp"
+
+class BundleWriter_t;
+class BundleReader_t;
+
+/*
+  usage:
+  SymbolTable_t st;
+  st.build(vr.getallVDJInfo("hsa_trb.vdj"), cr.getCDR3("hsa_trb.cdr"));
+  int e = st.contig(st.contigID("hsa_trb")).first;
+  std::string vdj = st.vdjName(e, e);   // e.g., TRBV1
+*/
+
+// code of a gene class and an exon number, e.g., GE('V', '2') for "V2"
+constexpr int GE(const char g, const char e) {
+	return (g << 8) | e;
+}
+
+// a gene (e.g., TRBV5-1), or the intergenic region of a locus (e.g., TRBI)
+struct GeneSym_t {
+	std::string name;
+	char cls;     // gene class, i.e., name[3] (V, D, J, C, ..., I for intergenic)
+	char chain;   // name[2], e.g., B of TRB
+	char sub;     // name[4] ('\0' if none), e.g., 2 of TRBJ2-1
+	int cdr3;     // CDR3 anchor on the reference (-1 if not available)
+};
+
+// an exon of a gene on a reference contig
+struct ExonSym_t {
+	int name;     // exon name ID (e.g., TRBV5-1_2)
+	int gene;     // gene ID
+	char num;     // exon number, i.e., the last char of the exon name
+	int start;    // exon start on the reference
+	int end;      // exon end on the reference
+};
+
+// a reference contig and its exons
+struct ContigSym_t {
+	std::string name;
+	int first;    // first exon (in the order of the vdj file)
+	int last;     // one past the last exon
+	int inter;    // pseudo exon of the intergenic region (e.g., TRBI_0)
+};
+
+/* An annotation is a span [e0, e1] of exons of one contig. Its vdj name
+ * joins the gene names of the exons with "~" and its vdje name joins the
+ * exon names, so two spans share a name if their gene (or exon name) IDs
+ * agree one by one.
+ */
+
+// symbols of contigs, genes and exons, built once from the vdj and cdr files
+class SymbolTable_t
+{
+private:
+	std::vector<ContigSym_t> contigs_m;
+	std::vector<GeneSym_t> genes_m;
+	std::vector<ExonSym_t> exons_m;
+	std::vector<std::string> exon_names_m;
+	std::unordered_map<std::string, int> contig_id_m;
+	std::unordered_map<std::string, int> gene_id_m;
+	std::unordered_map<std::string, int> exon_name_id_m;
+
+	int internGene(const std::string &name);
+	int internExonName(const std::string &name);
+
+public:
+	int trbv30;   // gene ID of TRBV30 (inverted in the locus), -1 if absent
+	int trbc1;    // gene ID of TRBC1, -1 if absent
+
+	SymbolTable_t() {
+		trbv30 = trbc1 = -1;
+	}
+
+	void build(const std::unordered_map< std::string, std::vector<VDJInfo_t> > &info,
+			const std::map<std::string, int> &cdr3p);
+
+	// write the tables to a bundle section, or read them from a mapped one
+	void save(BundleWriter_t &out) const;
+	void map(BundleReader_t &in);
+
+	// contig ID (-1 if not found)
+	int contigID(const std::string &name) const {
+		auto c = contig_id_m.find(name);
+		return c == contig_id_m.end() ? -1 : c->second;
+	}
+
+	int numContigs() const {
+		return contigs_m.size();
+	}
+
+	const ContigSym_t &contig(const int c) const {
+		return contigs_m[c];
+	}
+	const ExonSym_t &exon(const int e) const {
+		return exons_m[e];
+	}
+	const GeneSym_t &gene(const int g) const {
+		return genes_m[g];
+	}
+
+	// first gene of a span
+	const GeneSym_t &firstGene(const int e0) const {
+		return genes_m[exons_m[e0].gene];
+	}
+
+	// same vdj name, i.e., same genes
+	bool sameGenes(const int a0, const int a1, const int b0, const int b1) const;
+
+	// same vdje name, i.e., same exons
+	bool sameExons(const int a0, const int a1, const int b0, const int b1) const;
+
+	// span is exactly gene g (e.g., vdj == "TRBV30")
+	bool isGene(const int e0, const int e1, const int g) const {
+		return g >= 0 && e0 == e1 && exons_m[e0].gene == g;
+	}
+
+	// CDR3 anchor of a span (-1 unless a single exon of a gene with a CDR3)
+	int cdr3(const int e0, const int e1) const {
+		return e0 == e1 ? genes_m[exons_m[e0].gene].cdr3 : -1;
+	}
+
+	// names for output
+	std::string vdjName(const int e0, const int e1) const;
+	std::string vdjeName(const int e0, const int e1) const;
+};
+
+#endif /* symbols.hpp */
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <climits>
+#include <unistd.h>
+#include <getopt.h>
+#include "clone.hpp"
+#include "clonestat.hpp"
+#include "mapfile.hpp"
+#include "gzstream.hpp"
+
+using namespace std;
+
+//====================================================Options===
+string    OPT_Species    = "hsa";
+string    OPT_Gene       = "trb";
+string    OPT_Stat;                  // prefix of the clone statistics
+int       OPT_Clone      = 0;        // input is a clone.txt
+int       OPT_Threads    = 1;
+
+//===================================================Function===
+void ParseArgs(int argc, char ** argv, string &inpath);
+string VDJPath();
+void help();
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	string inpath;
+	ParseArgs(argc, argv, inpath);
+	GzInStream_t::threads = OPT_Threads;
+
+	// statistics of a clone.txt, as CloneStat.pl
+	if (OPT_Clone) {
+		CloneStat_t cs(OPT_Threads);
+		cs.genes(VDJPath());
+		cs.load(inpath);
+		cs.write(OPT_Stat);
+		return 0;
+	}
+
+	CloneEngine_t ce(OPT_Threads);
+	ce.load(inpath);
+	ce.rescue();
+	ce.cluster();
+
+	ios::sync_with_stdio(false);
+	ce.print(cout);
+
+	// and of the clones in memory
+	if (!OPT_Stat.empty()) {
+		vector<CloneRow_t> rows;
+		ce.rows(rows);
+		CloneStat_t cs(OPT_Threads);
+		cs.genes(VDJPath());
+		cs.add(rows);
+		cs.write(OPT_Stat);
+	}
+	return 0;
+}
+
+//====================================================VDJPath===
+// species_gene.vdj of the working directory (as linked by trig.pl), else of trig2/gene
+string VDJPath() {
+	const string vdj = OPT_Species + "_" + OPT_Gene + ".vdj";
+	if (isRegularFile(vdj))
+		return vdj;
+	char exe[PATH_MAX];
+	const ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+	string dir = n > 0 ? string(exe, n) : "";
+	for (int k = 0; k < 2 && dir.find('/') != string::npos; k++)
+		dir.resize(dir.rfind('/'));
+	return dir + "/gene/" + vdj;
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv, string &inpath) {
+	int opt, errflg = 0;
+	const char *optstring = "s:g:S:Ct:";
+	const struct option int_opts[] = {
+		{"species", 1, NULL, 's'},
+		{"gene",    1, NULL, 'g'},
+		{"stat",    1, NULL, 'S'},
+		{"clone",   0, NULL, 'C'},
+		{"threads", 1, NULL, 't'},
+		{NULL,      0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'s':
+				OPT_Species = optarg;
+				break;
+			case (int)'g':
+				OPT_Gene = optarg;
+				break;
+			case (int)'S':
+				OPT_Stat = optarg;
+				break;
+			case (int)'C':
+				OPT_Clone = 1;
+				break;
+			case (int)'t':
+				OPT_Threads = atoi(optarg);
+				if (OPT_Threads < 1) errflg++;
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind != argc - 1) help();
+	inpath = argv[optind++];
+
+	// clone.txt gives clone.vnpc, etc. unless -S is set
+	if (OPT_Clone && OPT_Stat.empty()) {
+		OPT_Stat = inpath.substr(inpath.rfind('/') + 1);
+		if (OPT_Stat.size() > 4 && OPT_Stat.compare(OPT_Stat.size()-4, 4, ".txt") == 0)
+			OPT_Stat.resize(OPT_Stat.size()-4);
+	}
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : trig-clone [option] read.cdr3 > clone.txt   (as CorrectCDR3Error.pl)\n" <<
+		"         trig-clone [option] -C clone.txt             (as CloneStat.pl)\n\n" <<
+		"option : -s | --species  species name              [hsa*, mmu] (*default)\n" <<
+		"         -g | --gene     immune receptor gene      [tra, trb*, trd, trg, igh, igl, igk]\n" <<
+		"                         (V and J genes of species_gene.vdj in the statistics)\n" <<
+		"         -S | --stat     also write the clone statistics of the clones in memory\n" <<
+		"                         as prefix.vnpc, .jnpc, .vjpc, .nlpc, .cnpc, .vjnpc and .aanpc\n" <<
+		"         -C | --clone    input is a clone.txt, write only its statistics\n" <<
+		"         -t | --threads  number of worker threads  [1*]\n\n";
+	exit(0);
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include "bundle.hpp"
+
+using namespace std;
+
+//====================================================Options===
+bool      OPT_Check      = false;
+
+//===================================================Function===
+void ParseArgs(int argc, char ** argv, string &prefix, string &bundle);
+void help();
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	string prefix, bundle;
+	ParseArgs(argc, argv, prefix, bundle);
+
+	if (OPT_Check) {
+		if (RefBundle_t::current(prefix, bundle))
+			return 0;
+		cerr << bundle << " is not current for " << prefix << ".fa, .vdj and .cdr" << endl;
+		return 1;
+	}
+	RefBundle_t::build(prefix, bundle);
+	return 0;
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv, string &prefix, string &bundle) {
+	int opt, errflg = 0;
+	const char *optstring = "ch";
+	const struct option int_opts[] = {
+		{"check", 0, NULL, 'c'},
+		{"help",  0, NULL, 'h'},
+		{NULL,    0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'c':
+				OPT_Check = true;
+				break;
+			case (int)'h':
+				help();
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind < argc - 2 || optind > argc - 1) help();
+	prefix = argv[optind++];
+	bundle = optind < argc ? argv[optind] : prefix + ".trig";
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : trig-index [option] prefix [bundle]   (prefix.fa, prefix.vdj and prefix.cdr)\n" <<
+		"e.g.   : trig-index gene/hsa_trb      (writes gene/hsa_trb.trig)\n\n" <<
+		"option : -c | --check   exit 1 if the bundle is missing, of another version or stale\n" <<
+		"                        (its sources changed since), instead of writing it\n" <<
+		"         -h | --help    this usage\n\n";
+	exit(0);
+}
@@ -0,0 +1,274 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <getopt.h>
+#include "pairmerge.hpp"
+#include "orderedpool.hpp"
+#include "fastx_read.hpp"
+#include "gzstream.hpp"
+
+using namespace std;
+
+//====================================================Options===
+int       OPT_Threads    = 1;
+bool      OPT_Fasta      = false;
+MergeParam_t OPT_Merge;
+
+const size_t BATCH_PAIRS = 4096;   // pairs per batch handed to a worker
+
+//======================================================Batch===
+
+// a read pair
+struct ReadPair_t {
+	std::string uid[2];
+	std::string seq[2];
+	std::string qua[2];
+};
+
+// consecutive pairs merged by one worker
+struct MergeBatch_t {
+	size_t serial;                  // input order of the batch
+	std::vector<ReadPair_t> pairs;
+	std::vector<std::string> out;   // merged reads, then reads 1 and 2 not merged (fastq)
+
+	MergeBatch_t() {
+		clear();
+	}
+
+	void clear() {
+		serial = 0;
+		pairs.clear();
+		out.clear();
+	}
+};
+
+//=====================================================Output===
+
+// fastq entries written to a file, and also as fasta to another if open (-f)
+class FastxStreamBuf_t : public std::streambuf
+{
+private:
+	ofstream fq_m, fa_m;
+	int line_m;   // line of the fastq entry being written (0 to 3)
+	bool bol_m;   // at the beginning of a line
+
+protected:
+	int overflow(int c) {
+		if (c != EOF) {
+			const char ch = c;
+			xsputn(&ch, 1);
+		}
+		return c;
+	}
+
+	streamsize xsputn(const char *s, streamsize n) {
+		fq_m.write(s, n);
+		if (!fa_m.is_open())
+			return n;
+		const char *p = s, *end = s + n;
+		while (p < end) {
+			const char *nl = (const char *)memchr(p, '\n', end - p);
+			const char *e = nl ? nl + 1 : end;
+			if (line_m < 2) {
+				// header ('@' to '>') and sequence
+				if (bol_m && line_m == 0 && *p == '@') {
+					fa_m.put('>');
+					p++;
+				}
+				fa_m.write(p, e - p);
+			}
+			bol_m = nl != NULL;
+			if (nl)
+				line_m = (line_m + 1) % 4;
+			p = e;
+		}
+		return n;
+	}
+
+public:
+	FastxStreamBuf_t() {
+		line_m = 0;
+		bol_m = true;
+	}
+
+	// fq_path, and its .fa if fasta
+	bool open(const string &fq_path, const bool fasta) {
+		fq_m.open(fq_path);
+		if (fasta)
+			fa_m.open(fq_path.substr(0, fq_path.rfind('.')) + ".fa");
+		return fq_m.good() && (!fasta || fa_m.good());
+	}
+
+	void close() {
+		fq_m.close();
+		if (fa_m.is_open())
+			fa_m.close();
+	}
+};
+
+class FastxOutStream_t : public std::ostream
+{
+private:
+	FastxStreamBuf_t buf_m;
+
+public:
+	FastxOutStream_t() : std::ostream(&buf_m) {
+	}
+
+	bool open(const string &fq_path, const bool fasta) {
+		return buf_m.open(fq_path, fasta);
+	}
+	void close() {
+		flush();
+		buf_m.close();
+	}
+};
+
+//===================================================Function===
+void ParseArgs(int argc, char ** argv, string &r1path, string &r2path, string outpath[3]);
+void MergeBatch(MergeBatch_t &batch);
+void help();
+
+//===================================================Variable===
+PairMerger_t Merger;
+atomic<size_t> Merged(0);
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	string r1path, r2path, outpath[3];
+	ParseArgs(argc, argv, r1path, r2path, outpath);
+	Merger = PairMerger_t(OPT_Merge);
+
+	GzInStream_t::threads = OPT_Threads;
+	FastqReader_t fr1, fr2;
+	fr1.open(r1path);
+	fr2.open(r2path);
+
+	// merged reads, then reads 1 and reads 2 that are not merged
+	FastxOutStream_t out[3];
+	for (int k = 0; k < 3; k++) {
+		if (!out[k].open(outpath[k], OPT_Fasta)) {
+			cerr << "\033[31mERROR:\033[0m Could not write fastq file, " << outpath[k] << endl;
+			exit(1);
+		}
+	}
+
+	// pairs merged by the workers of the pool and written in input order
+	size_t total = 0;
+	{
+		OrderedPool_t<MergeBatch_t> pool(OPT_Threads, MergeBatch, {&out[0], &out[1], &out[2]});
+		MergeBatch_t batch;
+		while (true) {
+			const bool h1 = fr1.readNext(), h2 = fr2.readNext();
+			if (h1 != h2) {
+				cerr << "\033[31mERROR:\033[0m Paired fastq files of different numbers of reads, "
+					<< r1path << " " << r2path << endl;
+				exit(1);
+			}
+			if (!h1)
+				break;
+			batch.pairs.emplace_back();
+			ReadPair_t &pair = batch.pairs.back();
+			FastqReader_t *fr[2] = {&fr1, &fr2};
+			for (int k = 0; k < 2; k++) {
+				pair.uid[k] = fr[k]->getUID();
+				pair.seq[k] = fr[k]->getSEQ();
+				pair.qua[k] = fr[k]->getQUA();
+			}
+			total++;
+			if (batch.pairs.size() == BATCH_PAIRS)
+				pool.push(batch);
+		}
+		if (!batch.pairs.empty())
+			pool.push(batch);
+		pool.finish();
+	}
+
+	for (int k = 0; k < 3; k++)
+		out[k].close();
+
+	cerr << "pairs             : " << total << "\n"
+		<< "merged            : " << Merged << "\n"
+		<< "not merged        : " << total - Merged << "\n";
+	return 0;
+}
+
+//=================================================MergeBatch===
+void MergeBatch(MergeBatch_t &batch) {
+	string seq, qua;
+	size_t merged = 0;
+	batch.out.assign(3, "");
+	for (const ReadPair_t &p : batch.pairs) {
+		if (Merger.merge(p.seq[0], p.qua[0], p.seq[1], p.qua[1], seq, qua)) {
+			batch.out[0] += "@" + p.uid[0] + "\n" + seq + "\n+\n" + qua + "\n";
+			merged++;
+		} else {
+			for (int k = 0; k < 2; k++)
+				batch.out[k+1] += "@" + p.uid[k] + "\n" + p.seq[k] + "\n+\n" + p.qua[k] + "\n";
+		}
+	}
+	Merged += merged;
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv, string &r1path, string &r2path, string outpath[3]) {
+	int opt, errflg = 0;
+	const char *optstring = "t:fl:L:p:d:";
+	const struct option int_opts[] = {
+		{"threads",     1, NULL, 't'},
+		{"fasta",       0, NULL, 'f'},
+		{"minovlen",    1, NULL, 'l'},
+		{"minmergelen", 1, NULL, 'L'},
+		{"pctid",       1, NULL, 'p'},
+		{"maxdiffs",    1, NULL, 'd'},
+		{NULL,          0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'t':
+				OPT_Threads = atoi(optarg);
+				if (OPT_Threads < 1) errflg++;
+				break;
+			case (int)'f':
+				OPT_Fasta = true;
+				break;
+			case (int)'l':
+				OPT_Merge.minovlen = atoi(optarg);
+				break;
+			case (int)'L':
+				OPT_Merge.minmergelen = atoi(optarg);
+				break;
+			case (int)'p':
+				OPT_Merge.pctid = atoi(optarg);
+				break;
+			case (int)'d':
+				OPT_Merge.maxdiffs = atoi(optarg);
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind != argc - 5) help();
+	r1path = argv[optind++];
+	r2path = argv[optind++];
+	for (int k = 0; k < 3; k++)
+		outpath[k] = argv[optind++];
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : trig-merge [option] read_1.fq read_2.fq read.fq um1_read.fq um2_read.fq\n" <<
+		"         (merged pairs into read.fq, the others into um1_read.fq and um2_read.fq)\n\n" <<
+		"option : -t | --threads     number of worker threads          [1*]\n" <<
+		"         -f | --fasta       also write each output as .fa\n" <<
+		"         -l | --minovlen    minimal overlap                   [20*]\n" <<
+		"         -L | --minmergelen minimal length of a merged read   [30*]\n" <<
+		"         -p | --pctid       minimal identity (%) of overlap   [90*]\n" <<
+		"         -d | --maxdiffs    maximal mismatches in overlap     [10*]\n\n";
+	exit(0);
+}
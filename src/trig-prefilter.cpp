@@ -0,0 +1,90 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <getopt.h>
+#include "kmerfilter.hpp"
+#include "gzstream.hpp"
+
+using namespace std;
+
+//====================================================Options===
+int       OPT_Minmatch   = 15;
+
+//===================================================Function===
+void ParseArgs(int argc, char ** argv, string &refpath, string &qrypath);
+void help();
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	string refpath, qrypath;
+	ParseArgs(argc, argv, refpath, qrypath);
+
+	KmerFilter_t kf;
+	kf.build(refpath, OPT_Minmatch);
+
+	// stream the fasta records, writing those with a shared k-mer as they are
+	GzInStream_t in;
+	in.open(qrypath);
+	if (!in.good()) {
+		cerr << "\033[31mERROR:\033[0m Could not parse fasta file, " << qrypath << endl;
+		exit(1);
+	}
+	ios::sync_with_stdio(false);
+	size_t kept = 0, rejected = 0;
+	string line, head, rec, seq;
+	getline(in, line);
+	while (!line.empty() && line[0] == '>') {
+		head = line;
+		rec.clear();
+		seq.clear();
+		while (getline(in, line) && (line.empty() || line[0] != '>')) {
+			rec += line;
+			rec += '\n';
+			seq += line;
+		}
+		if (kf.hit(seq)) {
+			cout << head << '\n' << rec;
+			kept++;
+		} else {
+			rejected++;
+		}
+		if (!in.good())
+			break;
+	}
+
+	cerr << "prefilter k-mer   : " << kf.kmer() << "\n"
+		<< "reads kept        : " << kept << "\n"
+		<< "reads rejected    : " << rejected << "\n";
+	return 0;
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv, string &refpath, string &qrypath) {
+	int opt, errflg = 0;
+	const char *optstring = "m:";
+	const struct option int_opts[] = {
+		{"minmatch", 1, NULL, 'm'},
+		{NULL,       0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'m':
+				OPT_Minmatch = atoi(optarg);
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind != argc - 2) help();
+	refpath = argv[optind++];
+	qrypath = argv[optind++];
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : trig-prefilter [option] ref.fa read.fa > kept.fa   (reads sharing a k-mer with ref.fa)\n\n" <<
+		"option : -m | --minmatch minimal match of nucmer   [15*] (k-mer length, at most 32)\n\n";
+	exit(0);
+}
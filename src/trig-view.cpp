@@ -0,0 +1,113 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include "vdjcol.hpp"
+
+using namespace std;
+
+//====================================================Options===
+string    OPT_Output;          // text file ("" for stdout)
+bool      OPT_Stat       = false;
+
+//===================================================Function===
+void ParseArgs(int argc, char ** argv, string &colpath);
+void PrintStat(const string &colpath);
+void help();
+
+//=======================================================Main===
+int main(int argc, char **argv) {
+	string colpath;
+	ParseArgs(argc, argv, colpath);
+
+	if (OPT_Stat) {
+		PrintStat(colpath);
+		return 0;
+	}
+
+	ofstream file;
+	if (!OPT_Output.empty()) {
+		file.open(OPT_Output);
+		if (!file.good()) {
+			cerr << "\033[31mERROR:\033[0m Could not write text file, " << OPT_Output << endl;
+			exit(1);
+		}
+	}
+	ostream &out = OPT_Output.empty() ? cout : file;
+	ios::sync_with_stdio(false);
+
+	// lines as written by ProcessAlignment (.vdjdelta or .cdr3)
+	ColReader_t cr;
+	cr.open(colpath);
+	string line;
+	while (cr.readNext()) {
+		line.clear();
+		for (size_t k = 0; k < cr.fields().size(); k++) {
+			if (k)
+				line += '\t';
+			cr.fieldText(cr.fields()[k], line);
+		}
+		line += '\n';
+		out << line;
+	}
+	return 0;
+}
+
+//==================================================PrintStat===
+void PrintStat(const string &colpath) {
+	static const char *names[] = {"shape", "align dict", "align groups", "align ref", "align exon",
+		"align sR", "align eR", "align sQ", "align eQ", "align mmgp", "align deltas"};
+	vector<pair<uint64_t, uint64_t>> sizes;
+	ColReader_t::streamSizes(colpath, sizes);
+	uint64_t raw = 0, cmp = 0;
+	cout << "stream\traw\tdeflated\n";
+	for (size_t key = 0; key < sizes.size(); key++) {
+		if (sizes[key].first == 0)
+			continue;
+		if (key < COL_INT)
+			cout << names[key];
+		else
+			cout << "field " << (key - COL_INT) / 2 + 1 << ((key - COL_INT) % 2 ? " string" : " int");
+		cout << "\t" << sizes[key].first << "\t" << sizes[key].second << "\n";
+		raw += sizes[key].first;
+		cmp += sizes[key].second;
+	}
+	cout << "total\t" << raw << "\t" << cmp << "\n";
+}
+
+//==================================================ParseArgs===
+void ParseArgs(int argc, char ** argv, string &colpath) {
+	int opt, errflg = 0;
+	const char *optstring = "o:s";
+	const struct option int_opts[] = {
+		{"output", 1, NULL, 'o'},
+		{"stat",   0, NULL, 's'},
+		{NULL,     0, NULL, 0},
+	};
+
+	while((opt = getopt_long(argc, argv, optstring, int_opts, NULL)) != -1) {
+		switch(opt) {
+			case (int)'o':
+				OPT_Output = optarg;
+				break;
+			case (int)'s':
+				OPT_Stat = true;
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg > 0 || optind != argc - 1) help();
+	colpath = argv[optind];
+}
+
+//=======================================================Help===
+void help() {
+	cout << "usage  : trig-view [option] read.vdjdelta.col   (or read.cdr3.col of ProcessAlignment -b)\n" <<
+		"         (the lines of the text file, to stdout)\n\n" <<
+		"option : -o | --output   text file instead of stdout\n" <<
+		"         -s | --stat     raw and deflated bytes of each column\n\n";
+	exit(0);
+}
@@ -0,0 +1,526 @@
+#include "vdjcol.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <zlib.h>
+
+
+//=========================================================coding===
+
+static void putVarint(std::string &out, uint64_t v) {
+	while (v >= 0x80) {
+		out += (char)(v | 0x80);
+		v >>= 7;
+	}
+	out += (char)v;
+}
+
+static void putSigned(std::string &out, const int64_t v) {
+	putVarint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static void putU32(std::string &out, const uint32_t v) {
+	for (int k = 0; k < 4; k++)
+		out += (char)(v >> (8 * k));
+}
+
+static uint32_t getU32(const char *p) {
+	uint32_t v = 0;
+	for (int k = 0; k < 4; k++)
+		v |= (uint32_t)(unsigned char)p[k] << (8 * k);
+	return v;
+}
+
+// an integer written the way it reads (no sign of 0, no leading zeros), at most 18 digits
+static bool parseInt(std::string_view s, int64_t &v) {
+	const size_t b = !s.empty() && s[0] == '-';
+	const size_t n = s.size() - b;
+	if (n == 0 || n > 18 || (s[b] == '0' && (n > 1 || b)))
+		return false;
+	v = 0;
+	for (size_t i = b; i < s.size(); i++) {
+		if (s[i] < '0' || s[i] > '9')
+			return false;
+		v = v * 10 + (s[i] - '0');
+	}
+	if (b)
+		v = -v;
+	return true;
+}
+
+// "a-b" of two integers (split at the first '-' leaving two of them)
+static bool parseRange(std::string_view s, int64_t &a, int64_t &b) {
+	for (size_t i = 1; i < s.size(); i++) {
+		if (s[i] == '-' && parseInt(s.substr(0, i), a) && parseInt(s.substr(i + 1), b))
+			return true;
+	}
+	return false;
+}
+
+static void putDict(std::string &out, const std::vector<const std::string *> &str) {
+	putVarint(out, str.size());
+	for (const std::string *s : str) {
+		putVarint(out, s->size());
+		out += *s;
+	}
+}
+
+//====================================================ColWriter_t===
+
+uint32_t ColWriter_t::Dict_t::put(const std::string &s) {
+	auto r = id.emplace(s, str.size());
+	if (r.second)
+		str.push_back(&r.first->first);
+	return r.first->second;
+}
+
+void ColWriter_t::open(const std::string &path) {
+	close();
+	path_m = path;
+	file_m.open(path, std::ios::binary);
+	if (!file_m.good()) {
+		std::cerr << "\033[31mERROR:\033[0m Could not write columnar file, " << path << std::endl;
+		exit(1);
+	}
+	file_m.write(COL_MAGIC, 8);
+}
+
+void ColWriter_t::close() {
+	if (!file_m.is_open())
+		return;
+	flush();
+	file_m.close();
+}
+
+bool ColWriter_t::parseAligns(std::string_view f) {
+	aligns_m.clear();
+	names_m.clear();
+	if (f.empty())
+		return false;
+
+	// groups split by ' ', members by '|', each ref:exon:sR-eR:sQ-eQ:mmgp:deltas
+	int group = 0;
+	size_t b = 0;
+	while (true) {
+		size_t e = b;
+		while (e < f.size() && f[e] != ' ' && f[e] != '|')
+			e++;
+		std::string_view t = f.substr(b, e - b);
+		std::string_view p[6];
+		int n = 0;
+		for (size_t s = 0; n < 6; n++) {
+			const size_t c = n < 5 ? t.find(':', s) : t.size();
+			if (c == std::string_view::npos)
+				return false;
+			p[n] = t.substr(s, c - s);
+			s = c + 1;
+		}
+		if (p[0].empty() || p[1].empty() || p[5].find(':') != std::string_view::npos)
+			return false;
+
+		ColAlign_t a;
+		a.group = group;
+		if (!parseRange(p[2], a.sR, a.eR) || !parseRange(p[3], a.sQ, a.eQ) || !parseInt(p[4], a.mmgp))
+			return false;
+		for (size_t s = 0; ; ) {
+			const size_t c = std::min(p[5].find(',', s), p[5].size());
+			int64_t d;
+			if (!parseInt(p[5].substr(s, c - s), d))
+				return false;
+			a.deltas.push_back(d);
+			if (c == p[5].size())
+				break;
+			s = c + 1;
+		}
+		aligns_m.push_back(std::move(a));
+		names_m.push_back(p[0]);
+		names_m.push_back(p[1]);
+
+		if (e == f.size())
+			break;
+		if (f[e] == ' ')
+			group++;
+		b = e + 1;
+	}
+	return true;
+}
+
+void ColWriter_t::add(std::string_view line) {
+	std::string shape;
+	size_t b = 0;
+	for (size_t k = 0; ; k++) {
+		const size_t e = std::min(line.find('\t', b), line.size());
+		std::string_view f = line.substr(b, e - b);
+		if (cols_m.size() <= k) {
+			cols_m.emplace_back();
+			cols_m.back().last = 0;
+		}
+		Column_t &c = cols_m[k];
+
+		int64_t v;
+		if (parseInt(f, v)) {
+			shape += 'I';
+			putSigned(c.ints, v - c.last);
+			c.last = v;
+		} else if (parseAligns(f)) {
+			shape += 'A';
+			putVarint(agroup_m, aligns_m.back().group + 1);
+			for (size_t i = 0, m = 0; i < aligns_m.size(); i++) {
+				m++;
+				if (i + 1 == aligns_m.size() || aligns_m[i+1].group != aligns_m[i].group) {
+					putVarint(agroup_m, m);
+					m = 0;
+				}
+			}
+			for (size_t i = 0; i < aligns_m.size(); i++) {
+				const ColAlign_t &a = aligns_m[i];
+				putVarint(aref_m, refs_m.put(std::string(names_m[2*i])));
+				const uint32_t x = exons_m.put(std::string(names_m[2*i+1]));
+				putVarint(aexon_m, x);
+				if (lastsR_m.size() <= x)
+					lastsR_m.resize(x + 1, 0);
+				putSigned(asr_m, a.sR - lastsR_m[x]);
+				lastsR_m[x] = a.sR;
+				putSigned(alr_m, a.eR - a.sR);
+				putSigned(asq_m, a.sQ);
+				putSigned(alq_m, a.eQ - a.sQ);
+				putSigned(amm_m, a.mmgp);
+				putVarint(adelta_m, a.deltas.size());
+				for (const int64_t d : a.deltas)
+					putSigned(adelta_m, d);
+			}
+		} else {
+			shape += 'S';
+			putVarint(c.ids, c.dict.put(std::string(f)));
+		}
+
+		if (e == line.size())
+			break;
+		b = e + 1;
+	}
+	putVarint(shape_m, shapes_m.put(shape));
+
+	if (++rows_m == COL_BLOCK)
+		flush();
+}
+
+void ColWriter_t::flush() {
+	if (rows_m == 0)
+		return;
+
+	// streams of the block by key, the empty ones left out
+	std::vector<std::pair<uint32_t, std::string>> streams;
+	auto add = [&](const uint32_t key, std::string &&s) {
+		if (!s.empty())
+			streams.emplace_back(key, std::move(s));
+	};
+	std::string s;
+	putDict(s, shapes_m.str);
+	add(COL_SHAPE, s + shape_m);
+	if (!agroup_m.empty()) {
+		s.clear();
+		putDict(s, refs_m.str);
+		putDict(s, exons_m.str);
+		add(COL_ADICT, std::move(s));
+	}
+	add(COL_AGROUP, std::move(agroup_m));
+	add(COL_AREF, std::move(aref_m));
+	add(COL_AEXON, std::move(aexon_m));
+	add(COL_ASR, std::move(asr_m));
+	add(COL_ALR, std::move(alr_m));
+	add(COL_ASQ, std::move(asq_m));
+	add(COL_ALQ, std::move(alq_m));
+	add(COL_AMM, std::move(amm_m));
+	add(COL_ADELTA, std::move(adelta_m));
+	for (size_t k = 0; k < cols_m.size(); k++) {
+		add(COL_INT + 2*k, std::move(cols_m[k].ints));
+		if (!cols_m[k].ids.empty()) {
+			s.clear();
+			putDict(s, cols_m[k].dict.str);
+			add(COL_STR + 2*k, s + cols_m[k].ids);
+		}
+	}
+
+	// header, then the deflated streams
+	std::string head, data;
+	putU32(head, rows_m);
+	putU32(head, streams.size());
+	std::vector<unsigned char> z;
+	for (auto &st : streams) {
+		uLongf n = compressBound(st.second.size());
+		z.resize(n);
+		if (compress2(z.data(), &n, (const Bytef *)st.second.data(), st.second.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+			std::cerr << "\033[31mERROR:\033[0m Could not deflate columnar block, " << path_m << std::endl;
+			exit(1);
+		}
+		putU32(head, st.first);
+		putU32(head, st.second.size());
+		putU32(head, n);
+		data.append((const char *)z.data(), n);
+	}
+	file_m.write(head.data(), head.size());
+	file_m.write(data.data(), data.size());
+
+	rows_m = 0;
+	lastsR_m.clear();
+	shapes_m.clear();
+	refs_m.clear();
+	exons_m.clear();
+	cols_m.clear();
+	shape_m.clear();
+	agroup_m.clear();
+	aref_m.clear();
+	aexon_m.clear();
+	asr_m.clear();
+	alr_m.clear();
+	asq_m.clear();
+	alq_m.clear();
+	amm_m.clear();
+	adelta_m.clear();
+}
+
+//================================================ColStreamBuf_t===
+
+int ColStreamBuf_t::overflow(int c) {
+	if (c == EOF)
+		return 0;
+	if (c == '\n') {
+		col_m->add(line_m);
+		line_m.clear();
+	} else {
+		line_m += (char)c;
+	}
+	return c;
+}
+
+std::streamsize ColStreamBuf_t::xsputn(const char *s, std::streamsize n) {
+	for (std::streamsize b = 0; b < n; ) {
+		const char *e = (const char *)memchr(s + b, '\n', n - b);
+		if (!e) {
+			line_m.append(s + b, n - b);
+			break;
+		}
+		line_m.append(s + b, e - s - b);
+		col_m->add(line_m);
+		line_m.clear();
+		b = e - s + 1;
+	}
+	return n;
+}
+
+void ColStreamBuf_t::finish() {
+	if (!line_m.empty())
+		col_m->add(line_m);
+	line_m.clear();
+}
+
+//================================================ColOutStream_t===
+
+void ColOutStream_t::open(const std::string &path) {
+	close();
+	col_m.open(path);
+	rdbuf(&buf_m);
+	clear();
+}
+
+void ColOutStream_t::close() {
+	if (!rdbuf())
+		return;
+	buf_m.finish();
+	col_m.close();
+	rdbuf(NULL);
+}
+
+//====================================================ColReader_t===
+
+void ColReader_t::open(const std::string &path) {
+	close();
+	path_m = path;
+	file_m.open(path, std::ios::binary);
+	char magic[8];
+	if (!file_m.good() || !file_m.read(magic, 8) || memcmp(magic, COL_MAGIC, 8) != 0) {
+		std::cerr << "\033[31mERROR:\033[0m Could not parse columnar file, " << path << std::endl;
+		exit(1);
+	}
+}
+
+uint64_t ColReader_t::getVarint(const int key) {
+	CheckFile(key < (int)stream_m.size());
+	const std::string &s = stream_m[key];
+	size_t &p = pos_m[key];
+	uint64_t v = 0;
+	for (int sh = 0; ; sh += 7) {
+		CheckFile(p < s.size() && sh < 64);
+		const unsigned char c = s[p++];
+		v |= (uint64_t)(c & 0x7f) << sh;
+		if (c < 0x80)
+			break;
+	}
+	return v;
+}
+
+int64_t ColReader_t::getSigned(const int key) {
+	const uint64_t v = getVarint(key);
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+void ColReader_t::getDict(const int key, std::vector<std::string> &dict) {
+	dict.resize(getVarint(key));
+	for (auto &d : dict) {
+		const uint64_t n = getVarint(key);
+		CheckFile(pos_m[key] + n <= stream_m[key].size());
+		d.assign(stream_m[key], pos_m[key], n);
+		pos_m[key] += n;
+	}
+}
+
+bool ColReader_t::readBlock() {
+	char h[8];
+	if (!file_m.read(h, 8)) {
+		CheckFile(file_m.gcount() == 0);
+		return false;
+	}
+	rows_m = getU32(h);
+	row_m = 0;
+	const uint32_t n = getU32(h + 4);
+
+	std::vector<char> e(12 * (size_t)n);
+	CheckFile((bool)file_m.read(e.data(), e.size()));
+	for (auto &s : stream_m)
+		s.clear();
+	std::vector<char> z;
+	for (uint32_t k = 0; k < n; k++) {
+		const uint32_t key = getU32(&e[12*k]), raw = getU32(&e[12*k + 4]), cmp = getU32(&e[12*k + 8]);
+		if (stream_m.size() <= key)
+			stream_m.resize(key + 1);
+		z.resize(cmp);
+		CheckFile((bool)file_m.read(z.data(), cmp));
+		stream_m[key].resize(raw);
+		uLongf len = raw;
+		CheckFile(uncompress((Bytef *)&stream_m[key][0], &len, (const Bytef *)z.data(), cmp) == Z_OK && len == raw);
+	}
+	pos_m.assign(stream_m.size(), 0);
+
+	// dictionaries of the block
+	getDict(COL_SHAPE, shapes_m);
+	refs_m.clear();
+	exons_m.clear();
+	if (COL_ADICT < stream_m.size() && !stream_m[COL_ADICT].empty()) {
+		getDict(COL_ADICT, refs_m);
+		getDict(COL_ADICT, exons_m);
+	}
+	dicts_m.assign(stream_m.size() / 2, std::vector<std::string>());
+	for (size_t key = COL_STR; key < stream_m.size(); key += 2) {
+		if (!stream_m[key].empty())
+			getDict(key, dicts_m[(key - COL_STR) / 2]);
+	}
+	last_m.assign(dicts_m.size(), 0);
+	lastsR_m.assign(exons_m.size(), 0);
+	return true;
+}
+
+bool ColReader_t::readNext() {
+	while (row_m == rows_m) {
+		if (!readBlock())
+			return false;
+	}
+	row_m++;
+
+	const uint64_t sh = getVarint(COL_SHAPE);
+	CheckFile(sh < shapes_m.size());
+	const std::string &shape = shapes_m[sh];
+	fields_m.resize(shape.size());
+	aligns_m.clear();
+	for (size_t k = 0; k < shape.size(); k++) {
+		ColField_t &f = fields_m[k];
+		f.type = shape[k];
+		f.i = 0;
+		f.s = NULL;
+		f.a0 = f.a1 = aligns_m.size();
+		if (f.type == 'I') {
+			CheckFile(k < last_m.size());
+			last_m[k] += getSigned(COL_INT + 2*k);
+			f.i = last_m[k];
+		} else if (f.type == 'S') {
+			const uint64_t id = getVarint(COL_STR + 2*k);
+			CheckFile(k < dicts_m.size() && id < dicts_m[k].size());
+			f.s = &dicts_m[k][id];
+		} else {
+			const uint64_t ng = getVarint(COL_AGROUP);
+			for (uint64_t g = 0; g < ng; g++) {
+				const uint64_t nm = getVarint(COL_AGROUP);
+				for (uint64_t m = 0; m < nm; m++) {
+					aligns_m.emplace_back();
+					ColAlign_t &a = aligns_m.back();
+					const uint64_t r = getVarint(COL_AREF), x = getVarint(COL_AEXON);
+					CheckFile(r < refs_m.size() && x < exons_m.size());
+					a.ref = &refs_m[r];
+					a.exon = &exons_m[x];
+					a.sR = lastsR_m[x] += getSigned(COL_ASR);
+					a.eR = a.sR + getSigned(COL_ALR);
+					a.sQ = getSigned(COL_ASQ);
+					a.eQ = a.sQ + getSigned(COL_ALQ);
+					a.mmgp = getSigned(COL_AMM);
+					a.deltas.resize(getVarint(COL_ADELTA));
+					for (auto &d : a.deltas)
+						d = getSigned(COL_ADELTA);
+					a.group = g;
+				}
+			}
+			f.a1 = aligns_m.size();
+		}
+	}
+	return true;
+}
+
+void ColReader_t::fieldText(const ColField_t &f, std::string &out) const {
+	if (f.type == 'I') {
+		out += std::to_string(f.i);
+	} else if (f.type == 'S') {
+		out += *f.s;
+	} else {
+		for (int i = f.a0; i < f.a1; i++) {
+			const ColAlign_t &a = aligns_m[i];
+			if (i > f.a0)
+				out += a.group != aligns_m[i-1].group ? ' ' : '|';
+			out += *a.ref + ":" + *a.exon + ":" + std::to_string(a.sR) + "-" + std::to_string(a.eR) + ":" +
+				std::to_string(a.sQ) + "-" + std::to_string(a.eQ) + ":" + std::to_string(a.mmgp) + ":";
+			for (size_t d = 0; d < a.deltas.size(); d++)
+				out += (d ? "," : "") + std::to_string(a.deltas[d]);
+		}
+	}
+}
+
+std::string ColReader_t::text() const {
+	std::string out;
+	for (size_t k = 0; k < fields_m.size(); k++) {
+		if (k)
+			out += '\t';
+		fieldText(fields_m[k], out);
+	}
+	return out;
+}
+
+void ColReader_t::streamSizes(const std::string &path, std::vector<std::pair<uint64_t, uint64_t>> &sizes) {
+	ColReader_t cr;
+	cr.open(path);
+	sizes.clear();
+	char h[8];
+	while (cr.file_m.read(h, 8)) {
+		const uint32_t n = getU32(h + 4);
+		std::vector<char> e(12 * (size_t)n);
+		cr.CheckFile((bool)cr.file_m.read(e.data(), e.size()));
+		for (uint32_t k = 0; k < n; k++) {
+			const uint32_t key = getU32(&e[12*k]);
+			if (sizes.size() <= key)
+				sizes.resize(key + 1);
+			sizes[key].first += getU32(&e[12*k + 4]);
+			sizes[key].second += getU32(&e[12*k + 8]);
+			cr.file_m.seekg(getU32(&e[12*k + 8]), std::ios::cur);
+		}
+	}
+}
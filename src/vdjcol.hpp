@@ -0,0 +1,246 @@
+#ifndef VDJCOL_HPP
+#define VDJCOL_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+  usage:
+  ColOutStream_t out;
+  out.open("read.vdjdelta.col");   // .vdjdelta (or .cdr3) lines in columnar blocks
+  out << line << "\n";
+  out.close();
+
+  ColReader_t cr;
+  cr.open("read.vdjdelta.col");
+  while (cr.readNext()) {
+      for (const ColField_t &f : cr.fields()) ...   // typed fields, alignments in cr.aligns()
+      std::cout << cr.text() << "\n";              // the line as written
+  }
+*/
+
+/* A columnar file of tab-separated lines (.vdjdelta, .cdr3, also of paired
+ * mode) in blocks of COL_BLOCK lines, each stream of a block deflated on
+ * its own:
+ *
+ *   "TRIGCOL1"
+ *   block: rows, streams, (key, raw size, deflated size) of each stream,
+ *          then the deflated streams
+ *
+ * All numbers are little-endian uint32 in the header and (zigzag) varints
+ * in the streams. A field is an integer (I), a list of alignments in
+ * concise form (A, groups split by ' ' and members by '|') or a string
+ * (S), as long as it reads back to the same text. The field types of a
+ * line (its shape, e.g., "IISSSSAS" ... ) are dictionary-encoded, each
+ * field position has an integer column (delta to the value before it) and
+ * a string column (dictionary of the block), and the alignments of all
+ * fields share their columns: group sizes, reference and exon (gene
+ * column) dictionary IDs, the reference start (delta to the start before
+ * it on the same exon, coordinate column), the reference span, the query
+ * start and span, the mismatches and gaps, and the deltas.
+ */
+
+#define COL_MAGIC "TRIGCOL1"
+#define COL_BLOCK 4096   // lines per block
+
+// keys of the streams of a block (field k has its integers at COL_INT+2k, strings at COL_STR+2k)
+enum {
+	COL_SHAPE = 0,   // shapes, then the shape of each line
+	COL_ADICT,       // reference and exon names of the alignments
+	COL_AGROUP,      // groups of each alignment field and members of each group
+	COL_AREF,        // reference of each alignment
+	COL_AEXON,       // exon of each alignment
+	COL_ASR,         // reference start, delta to the one before of the same exon
+	COL_ALR,         // reference end - start
+	COL_ASQ,         // query start
+	COL_ALQ,         // query end - start (negative on the reverse strand)
+	COL_AMM,         // mismatches and gaps
+	COL_ADELTA,      // number of deltas, then the deltas
+	COL_INT = 16,
+	COL_STR = 17
+};
+
+//====================================================ColAlign_t===
+
+// an alignment of the concise form, ref:exon:sR-eR:sQ-eQ:mmgp:deltas
+struct ColAlign_t {
+	const std::string *ref;    // reference contig (in the dictionary of the block)
+	const std::string *exon;   // annotation, e.g., TRBV5-1_2
+	int64_t sR, eR, sQ, eQ;
+	int64_t mmgp;
+	std::vector<int64_t> deltas;
+	int group;                 // group of its field (members of a group are joined by '|')
+};
+
+//====================================================ColField_t===
+
+struct ColField_t {
+	char type;             // 'I', 'S' or 'A'
+	int64_t i;             // of an integer
+	const std::string *s;  // of a string
+	int a0, a1;            // alignments [a0, a1) of the line, of an alignment list
+};
+
+//====================================================ColWriter_t===
+
+class ColWriter_t
+{
+private:
+	// a dictionary of strings in order of appearance
+	struct Dict_t {
+		std::unordered_map<std::string, uint32_t> id;
+		std::vector<const std::string *> str;
+		uint32_t put(const std::string &s);
+		void clear() {
+			id.clear();
+			str.clear();
+		}
+	};
+
+	// a column of a field position
+	struct Column_t {
+		std::string ints;   // varints
+		int64_t last;       // integer before
+		Dict_t dict;
+		std::string ids;    // varint string IDs
+	};
+
+	std::string path_m;
+	std::ofstream file_m;
+	size_t rows_m;
+	Dict_t shapes_m, refs_m, exons_m;
+	std::vector<Column_t> cols_m;
+	std::string shape_m;                 // varint shape IDs
+	std::string agroup_m, aref_m, aexon_m, asr_m, alr_m, asq_m, alq_m, amm_m, adelta_m;
+	std::vector<int64_t> lastsR_m;            // reference start before, of each exon
+	std::vector<ColAlign_t> aligns_m;         // of the field being added
+	std::vector<std::string_view> names_m;    // reference and exon names of aligns_m
+
+	bool parseAligns(std::string_view f);
+	void flush();
+
+public:
+	ColWriter_t() {
+		rows_m = 0;
+	}
+	~ColWriter_t() {
+		close();
+	}
+
+	void open(const std::string &path);
+	void close();
+
+	// a line without its '\n'
+	void add(std::string_view line);
+};
+
+//================================================ColStreamBuf_t===
+
+// stream buffer passing each complete line to a ColWriter_t
+class ColStreamBuf_t : public std::streambuf
+{
+private:
+	ColWriter_t *col_m;
+	std::string line_m;
+
+protected:
+	int overflow(int c);
+	std::streamsize xsputn(const char *s, std::streamsize n);
+
+public:
+	ColStreamBuf_t(ColWriter_t *col) {
+		col_m = col;
+	}
+
+	// a last line without '\n'
+	void finish();
+};
+
+//================================================ColOutStream_t===
+
+// output stream of lines into a columnar file
+class ColOutStream_t : public std::ostream
+{
+private:
+	ColWriter_t col_m;
+	ColStreamBuf_t buf_m;
+
+public:
+	ColOutStream_t() : std::ostream(NULL), buf_m(&col_m) {
+	}
+	~ColOutStream_t() {
+		close();
+	}
+
+	void open(const std::string &path);
+	void close();
+};
+
+//====================================================ColReader_t===
+
+class ColReader_t
+{
+private:
+	std::string path_m;
+	std::ifstream file_m;
+	size_t rows_m;                        // lines in the block
+	size_t row_m;                         // next line of the block
+
+	// inflated streams of the block, and their read positions
+	std::vector<std::string> stream_m;
+	std::vector<size_t> pos_m;
+
+	std::vector<std::string> shapes_m, refs_m, exons_m;
+	std::vector<std::vector<std::string>> dicts_m;   // string dictionary of each field position
+	std::vector<int64_t> last_m;                     // integer before, of each field position
+	std::vector<int64_t> lastsR_m;                   // reference start before, of each exon
+
+	std::vector<ColField_t> fields_m;
+	std::vector<ColAlign_t> aligns_m;
+
+	bool readBlock();
+	uint64_t getVarint(const int key);
+	int64_t getSigned(const int key);
+	void getDict(const int key, std::vector<std::string> &dict);
+
+	void CheckFile(const bool good) {
+		if (!good) {
+			std::cerr << "\033[31mERROR:\033[0m Could not parse columnar file, " << path_m << std::endl;
+			exit(1);
+		}
+	}
+
+public:
+	ColReader_t() {
+		rows_m = row_m = 0;
+	}
+
+	void open(const std::string &path);
+	void close() {
+		file_m.close();
+		rows_m = row_m = 0;
+	}
+
+	bool readNext();
+
+	const std::vector<ColField_t> &fields() const {
+		return fields_m;
+	}
+	const std::vector<ColAlign_t> &aligns() const {
+		return aligns_m;
+	}
+
+	// a field, or the whole line, as text
+	void fieldText(const ColField_t &f, std::string &out) const;
+	std::string text() const;
+
+	// sizes of the streams of the file by key, raw and deflated
+	static void streamSizes(const std::string &path, std::vector<std::pair<uint64_t, uint64_t>> &sizes);
+};
+
+#endif /* vdjcol.hpp */
@@ -29,6 +29,7 @@ bool VDJReader_t::readNext() {
 	vdj_stream_m >> info.strand;         // i.e., +, -
 	vdj_stream_m >> exon_range;          // e.g., 1..41,159..450
 
+	names_m.push_back(info.vdj);
 	info.species = info.species_gene.substr(0, 3);
 	info.gene = info.species_gene.substr(4, 3);
 	std::transform(info.gene.begin(), info.gene.end(), info.gene.begin(), ::toupper);
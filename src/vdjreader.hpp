@@ -47,6 +47,7 @@ private:
     std::ifstream vdj_stream_m;      // vdj file input stream
 	
 	std::unordered_map< std::string, std::vector<VDJInfo_t> > info_m;   // vdj info of all exons of a gene
+	std::vector<std::string> names_m;   // gene names in file order
     bool is_open_m;                  // vdj stream is open
 
     void CheckStream() {
@@ -75,6 +76,13 @@ public:
 		return info_m;
 	}
 
+	// gene names (e.g., TRBV5-1) in the order of the vdj file
+	std::vector<std::string> getGeneNames(const std::string &vdj_path) {
+		open(vdj_path);
+		while(readNext()){};
+		return names_m;
+	}
+
 };
 
 #endif /* vdjreader.h */
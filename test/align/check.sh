@@ -0,0 +1,13 @@
+# ProcessAlignment -A (user-016) on read.fa against hsa_trb: every read must
+# have the genes of its name; then against the output of the nucmer delta of
+# the same reads (initial.delta, see mkdelta.sh): the same on every read but
+# the exceptions of compare.pl
+
+ProcessAlignment -s hsa -g trb -o align -A $FIX/read.fa || exit 1
+perl $FIX/compare.pl -t $FIX/read.fa align.vdjdelta || exit 1
+
+# the delta names read.fa, its reads are read from read.fq (as of Fasta2Fastq)
+awk '/^>/ {print "@" substr($1, 2); next} {q = $0; gsub(/./, "I", q); print $0 "\n+\n" q}' \
+	$FIX/read.fa > read.fq
+ProcessAlignment -s hsa -g trb -o nucmer $FIX/initial.delta || exit 1
+perl $FIX/compare.pl nucmer align
@@ -0,0 +1,115 @@
+#!/usr/bin/perl -w
+# usage : compare.pl -t read.fa align.vdjdelta   (-A against the genes in the read names)
+#         compare.pl nucmer align                (outputs of the nucmer delta and of -A, by prefix:
+#                                                the same on every read but those of %except)
+
+use strict;
+
+# reads allowed to differ, with what may differ (see test/README)
+my %except = (
+	a04 => "ends",   # V and J joined with no N bases: the base between them is of both
+);
+
+# fields of each line of a .vdjdelta or .cdr3 file by query ID
+sub ReadLines {
+	my ($file) = @_;
+	my %line;
+	open(IN, $file) || die "Cannot open $file\n";
+	while (<IN>) {
+		chomp;
+		my @f = split /\t/;
+		$line{$f[0]} = \@f;
+	}
+	close IN;
+	return \%line;
+}
+
+# reference end of the V and start of the J of the concise alignments of a .vdjdelta line
+# (of each alternative of an ambiguous one)
+sub VJEnds {
+	my ($aligns) = @_;
+	my ($ve, $js) = ("", "");
+	foreach my $g (split / /, $aligns) {
+		my (@e, @s);
+		foreach my $a (split /\|/, $g) {
+			my ($ref, $exon, $r) = split /:/, $a;
+			my ($s, $e) = split /-/, $r;
+			push @e, $e if $exon =~ /^\w{3}V/;
+			push @s, $s if $exon =~ /^\w{3}J/;
+		}
+		$ve = join ",", sort @e if @e && $ve eq "";
+		$js = join ",", sort @s if @s && $js eq "";
+	}
+	return ($ve, $js);
+}
+
+
+if ($ARGV[0] eq "-t") {
+	# each read named "id case [V] [D] [J] [C]" has its V and J in the VDJ annotation,
+	# a read without genes (off target) has none
+	my (undef, $fa, $vdjdelta) = @ARGV;
+	my $line = ReadLines($vdjdelta);
+	my $bad = 0;
+	open(FA, $fa) || die "Cannot open $fa\n";
+	while (<FA>) {
+		next unless /^>/;
+		chomp;
+		my ($id, $case, @gene) = split / /, substr($_, 1);
+		my $f = $line->{$id};
+		my $vdj = (defined $f && @$f > 5) ? $f->[5] : "---";
+		my @want = grep { /^\w{3}[VJ]/ } @gene;
+		my @miss = grep { my $g = $_; !grep { $_ eq $g } split /[:|]/, $vdj } @want;
+		if ((@want && @miss) || (!@want && $vdj ne "---")) {
+			print "$id ($case): @gene, got $vdj\n";
+			$bad++;
+		}
+	}
+	close FA;
+	print "reads off their genes: $bad\n";
+	exit($bad ? 1 : 0);
+}
+
+my ($pn, $pa) = @ARGV;
+my ($vn, $va) = (ReadLines("$pn.vdjdelta"), ReadLines("$pa.vdjdelta"));
+my ($cn, $ca) = (ReadLines("$pn.cdr3"), ReadLines("$pa.cdr3"));
+
+# alternatives of an ambiguous call in one order (that of equal alignments in a delta)
+sub Sorted {
+	my ($s) = @_;
+	return join "|", sort split /\|/, $s;
+}
+
+my ($n, $bad) = (0, 0);
+foreach my $id (sort keys %$vn) {
+	my ($fn, $fa) = ($vn->{$id}, $va->{$id});
+	die "$id not in $pa.vdjdelta\n" unless defined $fa;
+	my $vdjn = @$fn > 5 ? $fn->[5] : "---";
+	my $vdja = @$fa > 5 ? $fa->[5] : "---";
+	next if $vdjn eq "---" && $vdja eq "---";
+	$n++;
+	my $ex = $except{$id} // "";
+
+	my $cdrn = $cn->{$id}->[2] // "---";
+	my $cdra = $ca->{$id}->[2] // "---";
+	if (Sorted($cdrn) ne Sorted($cdra) && $ex ne "cdr3") {
+		print "$id cdr3: $cdrn (nucmer) $cdra (-A)\n";
+		$bad++;
+	}
+	if (join(":", map { Sorted($_) } split /:/, $vdjn) ne join(":", map { Sorted($_) } split /:/, $vdja)) {
+		print "$id VDJ: $vdjn (nucmer) $vdja (-A)\n";
+		$bad++;
+		next;
+	}
+
+	my @en = VJEnds($fn->[6]);
+	my @ea = VJEnds($fa->[6]);
+	for my $k (0, 1) {
+		next if $en[$k] eq $ea[$k] || $ex eq "ends";
+		print "$id ", ($k ? "J start" : "V end"), ": $en[$k] (nucmer) $ea[$k] (-A)\n";
+		$bad++;
+	}
+}
+
+printf "reads %d, differing in V:CDR3:J, VDJ, V end or J start (but for %s) %d\n",
+	$n, join(" ", sort keys %except), $bad;
+exit($bad ? 1 : 0);
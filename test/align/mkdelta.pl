@@ -0,0 +1,169 @@
+#!/usr/bin/perl -w
+# usage : mkdelta.pl hsa_trb.fa hsa_trb.vdj read.fa > initial.delta
+# to do : a nucmer delta (as of nucmer --maxmatch -l 15 -c 15 -b 15) without MUMmer: each
+#         read, on both strands, against every exon sharing a 15-mer with it (+-20 bases),
+#         by Smith-Waterman with the nucmer scores of delta.hpp (3, -7, -7); an alignment
+#         holding a 15-base exact match is kept, once per reference interval
+
+use strict;
+
+my ($k, $flank) = (15, 20);
+my ($msc, $mmsc, $gsc) = (3, -7, -7);
+
+
+##### load reference, exons and reads
+
+my ($refid, $ref) = ("", "");
+open IN, "<$ARGV[0]" || die "open $ARGV[0]: $!\n";
+while (<IN>) {
+	chomp;
+	if (/^>(\S+)/) {
+		$refid = $1;
+	} else {
+		$ref .= uc $_;
+	}
+}
+close IN;
+
+my @win;
+open IN, "<$ARGV[1]" || die "open $ARGV[1]: $!\n";
+while (<IN>) {
+	my @a = split "\t"; chomp $a[-1];
+	foreach my $e (split ",", $a[4]) {
+		my ($s, $t) = split /\.\./, $e;
+		$s = $s - $flank < 1 ? 1 : $s - $flank;
+		$t = $t + $flank > length($ref) ? length($ref) : $t + $flank;
+		push @win, [$s, $t];
+	}
+}
+close IN;
+
+my (@id, @seq);
+open IN, "<$ARGV[2]" || die "open $ARGV[2]: $!\n";
+while (<IN>) {
+	chomp;
+	if (/^>(\S+)/) {
+		push @id, $1;
+		push @seq, "";
+	} else {
+		$seq[-1] .= uc $_;
+	}
+}
+close IN;
+
+
+##### align
+
+print "$ARGV[0] $ARGV[2]\nNUCMER\n";
+
+for my $i (0 .. $#id) {
+	my $q = $seq[$i];
+	my $n = length $q;
+	my @aln;
+	my %seen;
+	for my $rev (0, 1) {
+		my $qs = $rev ? RevComp($q) : $q;
+		my %kmer;
+		$kmer{substr($qs, $_, $k)} = 1 for 0 .. $n - $k;
+		foreach my $w (@win) {
+			my $r = substr($ref, $w->[0] - 1, $w->[1] - $w->[0] + 1);
+			next unless grep { $kmer{substr($r, $_, $k)} } 0 .. length($r) - $k;
+			my $a = Align($qs, $r) || next;
+			my ($sR, $eR) = ($a->{sR} + $w->[0] - 1, $a->{eR} + $w->[0] - 1);
+			my ($sQ, $eQ) = $rev ? ($n - $a->{sQ} + 1, $n - $a->{eQ} + 1) : ($a->{sQ}, $a->{eQ});
+			next if $seen{"$sR $eR $sQ $eQ"}++;
+			push @aln, [$sR, $eR, $sQ, $eQ, $a->{err}, $a->{deltas}];
+		}
+	}
+	next unless @aln;
+	print ">$refid $id[$i] " . length($ref) . " $n\n";
+	foreach my $a (sort { $a->[0] <=> $b->[0] || $a->[2] <=> $b->[2] } @aln) {
+		print join(" ", @$a[0..4], $a->[4], 0), "\n";
+		print "$_\n" for @{$a->[5]};
+	}
+}
+
+
+# best local alignment of query q on reference r (1-based ends), undef if it holds no
+# exact match of k bases
+sub Align {
+	my ($q, $r) = @_;
+	my ($n, $m) = (length $q, length $r);
+	my @q = split //, $q;
+	my @r = split //, $r;
+	my (@h, @t);   # score and trace ('M', 'D' reference gap in query, 'I' query base)
+	my ($best, $bi, $bj) = (0, 0, 0);
+	my @prev = (0) x ($m + 1);
+	for my $i (1 .. $n) {
+		my @cur = (0);
+		my @tr = ("");
+		for my $j (1 .. $m) {
+			my $s = $prev[$j-1] + ($q[$i-1] eq $r[$j-1] ? $msc : $mmsc);
+			my $t = "M";
+			if ($prev[$j] + $gsc > $s) {
+				$s = $prev[$j] + $gsc;
+				$t = "I";
+			}
+			if ($cur[$j-1] + $gsc > $s) {
+				$s = $cur[$j-1] + $gsc;
+				$t = "D";
+			}
+			if ($s <= 0) {
+				$s = 0;
+				$t = "";
+			}
+			push @cur, $s;
+			push @tr, $t;
+			if ($s > $best) {
+				($best, $bi, $bj) = ($s, $i, $j);
+			}
+		}
+		$t[$i] = \@tr;
+		@prev = @cur;
+	}
+	return undef if $best == 0;
+
+	my ($i, $j) = ($bi, $bj);
+	my @ops;
+	while ($i > 0 && $j > 0 && $t[$i][$j] ne "") {
+		my $t = $t[$i][$j];
+		unshift @ops, $t;
+		$i-- if $t ne "D";
+		$j-- if $t ne "I";
+	}
+
+	# deltas, mismatches and gaps, and the longest exact match
+	my ($qi, $rj) = ($i, $j);
+	my ($run, $err, $exact, $longest) = (0, 0, 0, 0);
+	my @deltas;
+	foreach my $t (@ops) {
+		if ($t eq "M") {
+			if ($q[$qi] eq $r[$rj]) {
+				$exact++;
+				$longest = $exact if $exact > $longest;
+			} else {
+				$err++;
+				$exact = 0;
+			}
+			$qi++;
+			$rj++;
+			$run++;
+		} else {
+			push @deltas, $t eq "D" ? $run + 1 : -($run + 1);
+			$err++;
+			$exact = 0;
+			$run = 0;
+			$qi++ if $t eq "I";
+			$rj++ if $t eq "D";
+		}
+	}
+	push @deltas, 0;
+	return undef if $longest < $k;
+	return {sQ => $i + 1, eQ => $bi, sR => $j + 1, eR => $bj, err => $err, deltas => \@deltas};
+}
+
+sub RevComp {
+	my $s = reverse shift;
+	$s =~ tr/ACGTN/TGCAN/;
+	return $s;
+}
@@ -0,0 +1,12 @@
+#!/bin/bash
+# usage : test/align/mkdelta.sh   (initial.delta of read.fa on gene/hsa_trb.fa)
+# by nucmer as run in trig.pl if nucmer (MUMmer) is on PATH, else by mkdelta.pl
+
+cd "$(dirname "$0")"
+ln -sf ../../gene/hsa_trb.fa ../../gene/hsa_trb.vdj .
+if command -v nucmer > /dev/null; then
+	nucmer --maxmatch -l 15 -c 15 -b 15 -p initial hsa_trb.fa read.fa
+else
+	perl mkdelta.pl hsa_trb.fa hsa_trb.vdj read.fa > initial.delta
+fi
+rm -f hsa_trb.fa hsa_trb.vdj
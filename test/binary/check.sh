@@ -0,0 +1,24 @@
+# ProcessAlignment -b (user-025) and trig-view: the .col files viewed as text equal the
+# .vdjdelta and .cdr3 of the same run without -b; on the reads of align/read.fa copied
+# 150 times (more than one block of COL_BLOCK lines), single-end with 1 and 3 threads
+# and paired (-P) on mates cut from them (the first 100 bases, and the reverse
+# complement of the last 100)
+
+awk '/^>/ {id = substr($1, 2); next} {for (k = 0; k < 150; k++) print ">" id "_" k "\n" $0}' \
+	$BIN/../test/align/read.fa > read.fa
+awk '/^>/ {print; next} {print substr($0, 1, 100)}' read.fa > r1.fa
+paste -d '\n' <(grep '>' read.fa) <(grep -v '>' read.fa | rev | cut -c 1-100 | tr ACGT TGCA) > r2.fa
+
+for t in 1 3; do
+	ProcessAlignment -t $t -A read.fa && ProcessAlignment -t $t -A -b -o col read.fa || exit 1
+	for f in vdjdelta cdr3; do
+		trig-view col.$f.col | cmp - read.$f || exit 1
+		trig-view -o col.$f col.$f.col && cmp col.$f read.$f || exit 1
+	done
+done
+
+ProcessAlignment -A -P r1.fa r2.fa && ProcessAlignment -A -P -b -o col r1.fa r2.fa || exit 1
+for f in vdjdelta cdr3; do
+	trig-view col.$f.col | cmp - read.$f || exit 1
+done
+[ $(wc -l < read.vdjdelta) -gt 4096 ] || exit 1
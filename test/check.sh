@@ -0,0 +1,28 @@
+#!/bin/bash
+# usage : test/check.sh [fixture ...]   (make check; all fixtures by default)
+# runs test/<fixture>/check.sh in a scratch directory holding links to the
+# built programs (src) and the hsa_trb gene files; a fixture check exits 0
+# if passed, 77 if skipped (e.g., a missing optional tool) or else failed
+
+TEST=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$TEST")
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+[ $# -gt 0 ] || set -- $(cd "$TEST" && ls */check.sh | sed 's|/check.sh||')
+
+fail=0
+for t in "$@"; do
+	dir="$WORK/$t"
+	mkdir -p "$dir"
+	for f in "$ROOT"/gene/hsa_trb.{fa,vdj,cdr} "$ROOT"/gene/hsa_trb_rss.txt; do
+		ln -s "$f" "$dir"
+	done
+	(cd "$dir" && PATH="$ROOT/src:$PATH" FIX="$TEST/$t" BIN="$ROOT/bin" bash "$TEST/$t/check.sh" > log 2>&1)
+	case $? in
+		0)  echo "$t: OK" ;;
+		77) echo "$t: SKIP ($(tail -1 "$dir/log"))" ;;
+		*)  echo "$t: FAIL"; sed 's/^/    /' "$dir/log" | tail -20; fail=1 ;;
+	esac
+done
+exit $fail
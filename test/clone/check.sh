@@ -0,0 +1,8 @@
+# trig-clone (user-021) on a synthetic read.cdr3 (see test/README for its cases) in place
+# of CorrectCDR3Error.pl and its usearch runs, against the expected clone.txt; each with
+# 1 and 3 threads
+
+for t in 1 3; do
+	trig-clone -t $t -s hsa -g trb $FIX/read.cdr3 > clone.txt || exit 1
+	cmp clone.txt $FIX/clone.expect.txt || exit 1
+done
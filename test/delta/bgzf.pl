@@ -0,0 +1,28 @@
+#!/usr/bin/perl -w
+# usage : bgzf.pl size < in > in.gz
+# to do : BGZF (as of bgzip) with blocks of size input bytes, and the empty end block
+
+use strict;
+use Compress::Raw::Zlib;
+
+my $size = $ARGV[0];
+binmode STDIN;
+binmode STDOUT;
+
+sub Block {
+	my ($data) = @_;
+	my ($d, $status) = Compress::Raw::Zlib::Deflate->new(-WindowBits => -MAX_WBITS, -AppendOutput => 1);
+	die "deflate: $status\n" if $status != Z_OK;
+	my $cd = "";
+	$d->deflate($data, $cd);
+	$d->flush($cd);
+	# gzip header with the BC extra field (block size - 1), deflated data, CRC32, size
+	print pack("CCCCVCCvCCvv", 31, 139, 8, 4, 0, 0, 255, 6, 66, 67, 2, length($cd) + 25);
+	print $cd, pack("VV", crc32($data), length($data));
+}
+
+my $buf;
+while (read(STDIN, $buf, $size)) {
+	Block($buf);
+}
+Block("");
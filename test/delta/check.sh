@@ -0,0 +1,63 @@
+# ProcessAlignment on a nucmer delta (user-002), read through DeltaMapReader_t, against
+# the expected .vdjdelta and .cdr3: reads of align/read.fa (q05 off target, not in the
+# delta), the alignments of q04 in two records, and q09, the last query at the end of
+# the file, also without its final newline; then streamed (user-003)
+
+ln -s $FIX/read.fq .
+ProcessAlignment $FIX/initial.delta || exit 1
+cmp read.vdjdelta $FIX/read.expect.vdjdelta && cmp read.cdr3 $FIX/read.expect.cdr3 || exit 1
+
+head -c -1 $FIX/initial.delta > noeol.delta
+ProcessAlignment -o noeol noeol.delta || exit 1
+cmp noeol.vdjdelta read.vdjdelta && cmp noeol.cdr3 read.cdr3 || exit 1
+
+# the same delta streamed through DeltaReader_t (user-003), from stdin and a named pipe
+ProcessAlignment -o stdin - < $FIX/initial.delta || exit 1
+cmp stdin.vdjdelta read.vdjdelta && cmp stdin.cdr3 read.cdr3 || exit 1
+mkfifo pipe.delta
+cat $FIX/initial.delta > pipe.delta &
+ProcessAlignment -o pipe pipe.delta || exit 1
+cmp pipe.vdjdelta read.vdjdelta && cmp pipe.cdr3 read.cdr3 || exit 1
+
+# -x (user-004): the queries in reverse order, fetched from the mapped read.fq and from
+# read.fq.gz (in memory, found as the fallback of read.fq): the same lines as the run in
+# order, in the order of the delta, with q05 (not in the delta) at the end; a query
+# missing from the fastq is an error
+awk 'BEGIN {n = 0} /^>/ {n++} {rec[n] = rec[n] $0 "\n"}
+	END {printf "%s", rec[0]; for (i = n; i >= 1; i--) printf "%s", rec[i]}' $FIX/initial.delta > shuf.delta
+mkdir gz
+ln -s $PWD/hsa_trb.* gz
+gzip -c $FIX/read.fq > gz/read.fq.gz
+for d in . gz; do
+	(cd $d && ProcessAlignment -x -o shuf $OLDPWD/shuf.delta) || exit 1
+	[ "$(cut -f 1 $d/shuf.vdjdelta | tr '\n' ' ')" = "q09 q08 q07 q06 q04 q03 q02 q01 q05 " ] || exit 1
+	for f in vdjdelta cdr3; do
+		sort $d/shuf.$f | cmp - <(sort read.$f) || exit 1
+	done
+done
+sed 's/^>hsa_trb q03 />hsa_trb q99 /' shuf.delta > miss.delta
+ProcessAlignment -x -o miss miss.delta 2> miss.log && exit 1
+grep -q "Query not found in fastq file, q99" miss.log || exit 1
+
+# read.fq.gz in place of read.fq (user-005), as gzip, gzip of two members and BGZF of
+# 1000-byte blocks, with 1 and 3 threads (inflating BGZF blocks ahead), and with -x;
+# and -A on a gzipped fasta: the same output as from the plain files
+for z in gzip member bgzf; do
+	mkdir $z
+	ln -s $PWD/hsa_trb.* $z
+	case $z in
+		gzip)   gzip -c $FIX/read.fq > $z/read.fq.gz ;;
+		member) (head -20 $FIX/read.fq | gzip -c; tail -n +21 $FIX/read.fq | gzip -c) > $z/read.fq.gz ;;
+		bgzf)   perl $FIX/bgzf.pl 1000 < $FIX/read.fq > $z/read.fq.gz ;;
+	esac
+	for t in 1 3; do
+		(cd $z && ProcessAlignment -t $t -o $t $FIX/initial.delta) || exit 1
+		cmp $z/$t.vdjdelta read.vdjdelta && cmp $z/$t.cdr3 read.cdr3 || exit 1
+	done
+	(cd $z && ProcessAlignment -x -o x $OLDPWD/shuf.delta) || exit 1
+	cmp $z/x.vdjdelta shuf.vdjdelta && cmp $z/x.cdr3 shuf.cdr3 || exit 1
+done
+ProcessAlignment -A -o fa $BIN/../test/align/read.fa || exit 1
+perl $FIX/bgzf.pl 1000 < $BIN/../test/align/read.fa > read.fa.gz
+ProcessAlignment -t 3 -A -o fagz read.fa.gz || exit 1
+cmp fagz.vdjdelta fa.vdjdelta && cmp fagz.cdr3 fa.cdr3 || exit 1
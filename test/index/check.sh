@@ -0,0 +1,51 @@
+# trig-index bundles (user-017): ProcessAlignment gives the same output from
+# a bundle as from its sources; for a bundle of another version, or after a
+# source is edited, trig-index -c fails and ProcessAlignment reads the sources
+
+for f in fa vdj cdr; do
+	cp --remove-destination $(readlink -f hsa_trb.$f) hsa_trb.$f
+done
+READ=$FIX/../align/read.fa
+
+# -h and unknown options print the usage, not taken as a prefix
+for o in -h --help -x; do
+	trig-index $o > usage.txt 2> /dev/null
+	grep -q "^usage" usage.txt && ! ls ./-*.trig 2> /dev/null || { echo "trig-index $o"; exit 1; }
+done
+
+ProcessAlignment -s hsa -g trb -o source -A $READ || exit 1
+trig-index hsa_trb || exit 1
+trig-index -c hsa_trb || exit 1
+ProcessAlignment -s hsa -g trb -o bundle -A $READ 2> bundle.err || exit 1
+[ ! -s bundle.err ] || { cat bundle.err; exit 1; }
+cmp source.vdjdelta bundle.vdjdelta && cmp source.cdr3 bundle.cdr3 || exit 1
+
+# a bundle of another version (BUNDLE_VERSION after the 8-byte magic) is
+# reported by trig-index -c, and ProcessAlignment warns and reads the sources
+cp hsa_trb.trig current.trig
+printf '\377' | dd of=hsa_trb.trig bs=1 seek=8 conv=notrunc 2> /dev/null
+if trig-index -c hsa_trb; then
+	echo "bundle of another version not detected"
+	exit 1
+fi
+ProcessAlignment -s hsa -g trb -o version -A $READ 2> version.err || exit 1
+grep -q WARNING version.err || { echo "no warning on a bundle of another version"; exit 1; }
+cmp source.vdjdelta version.vdjdelta && cmp source.cdr3 version.cdr3 || exit 1
+mv current.trig hsa_trb.trig
+
+# TRBV5-1 (of a01 and others) dropped from the vdj file
+grep -v "TRBV5-1	" hsa_trb.vdj > vdj && mv vdj hsa_trb.vdj
+touch -r hsa_trb.trig hsa_trb.vdj
+if trig-index -c hsa_trb; then
+	echo "edited hsa_trb.vdj not detected"
+	exit 1
+fi
+ProcessAlignment -s hsa -g trb -o stale -A $READ 2> stale.err || exit 1
+grep -q WARNING stale.err || { echo "no warning on a stale bundle"; exit 1; }
+rm hsa_trb.trig
+ProcessAlignment -s hsa -g trb -o edited -A $READ || exit 1
+cmp stale.vdjdelta edited.vdjdelta && cmp stale.cdr3 edited.cdr3 || exit 1
+if cmp -s stale.cdr3 bundle.cdr3; then
+	echo "output of the edited vdj file same as before"
+	exit 1
+fi
@@ -0,0 +1,15 @@
+# ProcessAlignment -L (user-023) on synthetic TRB reads, one or two of each category
+# (the category and gene classes in the read names, see test/README), against the
+# expected .vdjdelta and .lab with 1 and 3 threads; and LabelRecombination.pl on the
+# .vdjdelta, with the mate 0 field of trig.pl in both, giving the same .lab
+
+for t in 1 3; do
+	ProcessAlignment -t $t -A -L $FIX/read.fa || exit 1
+	cmp read.vdjdelta $FIX/read.expect.vdjdelta || exit 1
+	cmp read.lab $FIX/read.expect.lab || exit 1
+done
+
+awk -F'\t' -v OFS='\t' '{$1 = $1 OFS 0; print}' read.vdjdelta > unified.vdjdelta
+awk -F'\t' -v OFS='\t' '{$4 = $4 OFS 0; print}' read.lab > unified.lab
+perl $BIN/LabelRecombination.pl -s hsa -g trb unified.vdjdelta > pl.lab || exit 1
+diff pl.lab unified.lab || exit 1
@@ -0,0 +1,13 @@
+# trig-merge (user-019) on hand-built pairs named by their case: merged or
+# not at the edges of minovlen, pctid, maxdiffs and minmergelen, staggered
+# pairs, and the posterior qualities of agreeing, differing and N calls
+# (m11), against the expected read.fq, um1_read.fq and um2_read.fq; each
+# with 1 and 3 threads, and the .fa of -f as the fastq
+
+for t in 1 3; do
+	trig-merge -t $t -f $FIX/r1.fq $FIX/r2.fq read.fq um1_read.fq um2_read.fq || exit 1
+	for f in read um1_read um2_read; do
+		cmp $f.fq $FIX/$f.expect.fq || exit 1
+		awk 'NR % 4 == 1 {print ">" substr($0, 2)} NR % 4 == 2' $f.fq | cmp - $f.fa || exit 1
+	done
+done
@@ -0,0 +1,19 @@
+# ProcessAlignment -P (user-020) against the two single-mate runs combined by
+# CombinePEVDJDelta.pl and CombinePECDR3.pl: the same .vdjdelta and .cdr3, on mates cut
+# from the reads of align/read.fa (the first n bases, and the reverse complement of the
+# last n) of 80 bases (mostly a V in one mate and a J in the other) and 140 bases
+# (mostly both in each), with 1 and 3 threads
+
+for n in 80 140; do
+	awk -v n=$n '/^>/ {print $1; next} {print substr($0, 1, n)}' $BIN/../test/align/read.fa > r1.fa
+	paste -d '\n' <(grep '>' $BIN/../test/align/read.fa | cut -d ' ' -f 1) \
+		<(grep -v '>' $BIN/../test/align/read.fa | rev | cut -c 1-$n | tr ACGT TGCA) > r2.fa
+
+	ProcessAlignment -A -o um1 r1.fa && ProcessAlignment -A -o um2 r2.fa || exit 1
+	perl $BIN/CombinePEVDJDelta.pl um1.vdjdelta um2.vdjdelta > pl.vdjdelta || exit 1
+	perl $BIN/CombinePECDR3.pl um1.cdr3 um2.cdr3 > pl.cdr3 || exit 1
+	for t in 1 3; do
+		ProcessAlignment -t $t -A -P r1.fa r2.fa || exit 1
+		cmp read.vdjdelta pl.vdjdelta && cmp read.cdr3 pl.cdr3 || exit 1
+	done
+done
@@ -0,0 +1,13 @@
+# ProcessAlignment -p (user-024) on synthetic TRB reads whose J or C has a mismatch every
+# 10-14 bases (no seed of 15 to align it), named "id case genes": the J or C patched in,
+# reads with nothing to patch unchanged; against the expected .vdjdelta and .cdr3 with
+# 1 and 3 threads, and the patched reads only (p01-p05) differing from a run without -p
+
+for t in 1 3; do
+	ProcessAlignment -t $t -A -p $FIX/read.fa || exit 1
+	cmp read.vdjdelta $FIX/read.expect.vdjdelta && cmp read.cdr3 $FIX/read.expect.cdr3 || exit 1
+done
+
+ProcessAlignment -A -o np $FIX/read.fa || exit 1
+[ "$(diff np.vdjdelta read.vdjdelta | sed -n 's/^< \(p[0-9]*\)\t.*/\1/p' | tr '\n' ' ')" = \
+	"p01 p02 p03 p04 p05 " ] || exit 1
@@ -0,0 +1,11 @@
+# trig-clone -C (user-022) against CloneStat.pl on a synthetic clone.txt (clones of 11
+# V and 12 J genes, one cdr3aa of three clones, a stop codon and a length not of codons):
+# the same seven tables, aanpc up to the order of equal counts (a perl hash order)
+
+mkdir pl cc
+(cd pl && perl $BIN/CloneStat.pl $FIX/clone.txt) || exit 1
+(cd cc && ln -s ../hsa_trb.vdj . && trig-clone -C $FIX/clone.txt) || exit 1
+for e in vnpc jnpc vjpc nlpc cnpc vjnpc; do
+	cmp pl/clone.$e cc/clone.$e || exit 1
+done
+cmp <(sort pl/clone.aanpc) <(sort cc/clone.aanpc) || exit 1